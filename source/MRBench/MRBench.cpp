@@ -0,0 +1,584 @@
+#include "MRMesh/MRMesh.h"
+#include "MRMesh/MRAABBTree.h"
+#include "MRMesh/MRBox.h"
+#include "MRMesh/MRBitSet.h"
+#include "MRMesh/MRBitSetParallelFor.h"
+#include "MRMesh/MRSparseIdSet.h"
+#include "MRMesh/MRConvexHull.h"
+#include "MRMesh/MRPointCloud.h"
+#include "MRMesh/MRConstants.h"
+#include "MRMesh/MRMeshProject.h"
+#include "MRMesh/MRMeshDecimate.h"
+#include "MRMesh/MRMeshSubdivide.h"
+#include "MRMesh/MRMeshBoolean.h"
+#include "MRMesh/MROffset.h"
+#include "MRMesh/MRMeshLoad.h"
+#include "MRMesh/MRMeshSave.h"
+#include "MRMesh/MRSphere.h"
+#include "MRMesh/MRUVSphere.h"
+#include "MRMesh/MRTorus.h"
+#include "MRMesh/MRRegularGridMesh.h"
+#include "MRMesh/MRSerializer.h"
+#include "MRMesh/MRSystem.h"
+#include "MRMesh/MRStringConvert.h"
+#include "MRMesh/MRTimer.h"
+#include "MRPch/MRJson.h"
+#include "MRPch/MRSpdlog.h"
+#include "MRPch/MRTBB.h"
+#include <tbb/global_control.h>
+#include <boost/program_options.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <atomic>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <regex>
+#include <thread>
+
+namespace
+{
+
+using namespace MR;
+
+/// one benchmark case: prepare() creates the input once, setup() restores it before each repetition,
+/// and only run() is measured
+struct Benchmark
+{
+    std::string name;
+    std::function<void()> prepare;
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+/// the size of synthetic inputs: the approximate number of vertices in generated meshes
+struct Scale
+{
+    std::string name;
+    int numVerts = 0;
+};
+
+const std::vector<Scale> AllScales = { { "S", 10'000 }, { "M", 100'000 }, { "L", 1'000'000 } };
+
+/// torus with about numVerts vertices
+Mesh makeBenchTorus( int numVerts )
+{
+    const int res = std::max( 4, int( std::sqrt( float( numVerts ) / 2 ) ) );
+    return makeTorus( 1.0f, 0.3f, 2 * res, res );
+}
+
+/// regular grid of about numVerts vertices on a wavy surface
+Mesh makeBenchGrid( int numVerts )
+{
+    const size_t side = std::max( 2, int( std::sqrt( float( numVerts ) ) ) );
+    return makeRegularGridMesh( side, side, []( size_t, size_t ) { return true; }, [side]( size_t x, size_t y )
+    {
+        const float u = float( x ) / side, v = float( y ) / side;
+        return Vector3f( u, v, 0.05f * std::sin( 20 * u ) * std::cos( 15 * v ) );
+    } );
+}
+
+/// points of torus surface with small noise in the order of scanner lines, not coherent with the mesh
+std::vector<Vector3f> makeBenchScan( int numPoints )
+{
+    const int numLines = std::max( 2, int( std::sqrt( float( numPoints ) ) ) );
+    const int numPerLine = std::max( 2, numPoints / numLines );
+    std::vector<Vector3f> res;
+    res.reserve( size_t( numLines ) * numPerLine );
+    for ( int l = 0; l < numLines; ++l )
+    {
+        const float u = 2 * PI_F * ( l * 37 % numLines ) / numLines;
+        for ( int k = 0; k < numPerLine; ++k )
+        {
+            const float v = 2 * PI_F * k / numPerLine;
+            const float noise = 0.01f * std::sin( 12.9898f * l + 78.233f * k );
+            const float r = 1.0f + 0.3f * ( 1.0f + noise ) * std::cos( v );
+            res.emplace_back( r * std::cos( u ), r * std::sin( u ), 0.3f * ( 1.0f + noise ) * std::sin( v ) );
+        }
+    }
+    return res;
+}
+
+void addBenchmarks( std::vector<Benchmark> & res, const Scale & scale )
+{
+    const int n = scale.numVerts;
+    const auto suffix = "/" + scale.name;
+
+    // micro: AABB tree construction
+    {
+        auto mesh = std::make_shared<Mesh>();
+        res.push_back( { "micro/aabbTree" + suffix,
+            [mesh, n] { *mesh = makeBenchTorus( n ); },
+            [mesh] { mesh->invalidateCaches(); },
+            [mesh] { (void)mesh->getAABBTree(); } } );
+    }
+
+    // micro: closest point queries, the tree is built in advance
+    {
+        auto mesh = std::make_shared<Mesh>();
+        auto points = std::make_shared<std::vector<Vector3f>>();
+        res.push_back( { "micro/findProjection" + suffix,
+            [mesh, points, n]
+            {
+                *mesh = makeBenchTorus( n );
+                (void)mesh->getAABBTree();
+                std::mt19937 gen( 0 );
+                std::uniform_real_distribution<float> coord( -1.5f, 1.5f );
+                points->resize( 10'000 );
+                for ( auto & p : *points )
+                    p = Vector3f( coord( gen ), coord( gen ), coord( gen ) );
+            },
+            {},
+            [mesh, points]
+            {
+                for ( const auto & p : *points )
+                    (void)findProjection( p, *mesh );
+            } } );
+    }
+
+    // micro: signed distances of scan points, single queries in parallel loop and batched queries
+    for ( bool batched : { false, true } )
+    {
+        auto mesh = std::make_shared<Mesh>();
+        auto points = std::make_shared<std::vector<Vector3f>>();
+        res.push_back( { ( batched ? "micro/findSignedDistances" : "micro/findSignedDistance" ) + suffix,
+            [mesh, points, n]
+            {
+                *mesh = makeBenchTorus( n );
+                (void)mesh->getAABBTree();
+                *points = makeBenchScan( n );
+            },
+            {},
+            [mesh, points, batched]
+            {
+                if ( batched )
+                {
+                    (void)findSignedDistances( *points, *mesh );
+                    return;
+                }
+                tbb::parallel_for( tbb::blocked_range<size_t>( 0, points->size() ), [&]( const tbb::blocked_range<size_t> & range )
+                {
+                    for ( size_t i = range.begin(); i < range.end(); ++i )
+                        (void)findSignedDistance( ( *points )[i], *mesh );
+                } );
+            } } );
+    }
+
+    // micro: iteration over every 100th bit of large bit set: test of all bits, word skipping and sparse set
+    {
+        auto bits = std::make_shared<VertBitSet>();
+        auto sparse = std::make_shared<SparseVertSet>();
+        auto prepare = [bits, sparse, n]
+        {
+            bits->resize( 20 * size_t( n ) );
+            for ( size_t i = 0; i < bits->size(); i += 100 )
+                bits->set( VertId( i ) );
+            *sparse = SparseVertSet( *bits );
+        };
+        res.push_back( { "micro/bitSetParallelForAll" + suffix, prepare, {}, [bits]
+            {
+                std::atomic<size_t> sum{ 0 };
+                BitSetParallelForAll( *bits, [&]( VertId v )
+                {
+                    if ( bits->test( v ) )
+                        sum.fetch_add( v, std::memory_order_relaxed );
+                } );
+            } } );
+        res.push_back( { "micro/bitSetParallelFor" + suffix, prepare, {}, [bits]
+            {
+                std::atomic<size_t> sum{ 0 };
+                BitSetParallelFor( *bits, [&]( VertId v ) { sum.fetch_add( v, std::memory_order_relaxed ); } );
+            } } );
+        res.push_back( { "micro/sparseSetParallelFor" + suffix, prepare, {}, [sparse]
+            {
+                std::atomic<size_t> sum{ 0 };
+                BitSetParallelFor( *sparse, [&]( VertId v ) { sum.fetch_add( v, std::memory_order_relaxed ); } );
+            } } );
+    }
+
+    // macro: convex hull of random points in a ball
+    {
+        auto cloud = std::make_shared<PointCloud>();
+        res.push_back( { "macro/convexHull" + suffix,
+            [cloud, n]
+            {
+                std::mt19937 gen( 0 );
+                std::uniform_real_distribution<float> coord( -1.0f, 1.0f );
+                cloud->points.clear();
+                while ( cloud->points.size() < size_t( n ) )
+                {
+                    const Vector3f p( coord( gen ), coord( gen ), coord( gen ) );
+                    if ( p.lengthSq() <= 1 )
+                        cloud->points.push_back( p );
+                }
+                cloud->validPoints.clear();
+                cloud->validPoints.resize( cloud->points.size(), true );
+                cloud->invalidateCaches();
+            },
+            {},
+            [cloud] { (void)makeConvexHull( *cloud ); } } );
+    }
+
+    // macro: decimation of irregular sphere
+    {
+        auto source = std::make_shared<Mesh>();
+        auto mesh = std::make_shared<Mesh>();
+        res.push_back( { "macro/decimateMesh" + suffix,
+            [source, n] { *source = makeSphere( { .radius = 1.0f, .numMeshVertices = n } ); },
+            [source, mesh] { *mesh = *source; },
+            [mesh]
+            {
+                DecimateSettings settings;
+                settings.maxError = 0.01f;
+                decimateMesh( *mesh, settings );
+            } } );
+    }
+
+    // macro: subdivision of torus up to the half of its average edge length, serial and in parallel parts
+    for ( int parts : { 1, 32 } )
+    {
+        auto source = std::make_shared<Mesh>();
+        auto mesh = std::make_shared<Mesh>();
+        auto edgeLen = std::make_shared<float>();
+        res.push_back( { ( parts > 1 ? "macro/subdivideMeshParallel" : "macro/subdivideMesh" ) + suffix,
+            [source, edgeLen, n]
+            {
+                *source = makeBenchTorus( n );
+                *edgeLen = 0.5f * source->averageEdgeLength();
+            },
+            [source, mesh] { *mesh = *source; },
+            [mesh, edgeLen, parts]
+            {
+                SubdivideSettings settings;
+                settings.maxEdgeLen = *edgeLen;
+                settings.maxEdgeSplits = INT_MAX;
+                settings.subdivideParts = parts;
+                subdivideMesh( *mesh, settings );
+            } } );
+    }
+
+    // macro: remeshing of irregular sphere to the half of its average edge length, serial and in parallel parts
+    for ( int parts : { 1, 32 } )
+    {
+        auto source = std::make_shared<Mesh>();
+        auto mesh = std::make_shared<Mesh>();
+        auto edgeLen = std::make_shared<float>();
+        res.push_back( { ( parts > 1 ? "macro/remeshParallel" : "macro/remesh" ) + suffix,
+            [source, edgeLen, n]
+            {
+                *source = makeSphere( { .radius = 1.0f, .numMeshVertices = n } );
+                *edgeLen = 0.5f * source->averageEdgeLength();
+            },
+            [source, mesh] { *mesh = *source; },
+            [mesh, edgeLen, parts]
+            {
+                RemeshSettings settings;
+                settings.targetEdgeLen = *edgeLen;
+                settings.subdivideParts = parts;
+                if ( !remesh( *mesh, settings ) )
+                    throw std::runtime_error( "remesh failed" );
+            } } );
+    }
+
+    // macro: union of two intersecting UV-spheres
+    {
+        auto meshA = std::make_shared<Mesh>();
+        auto meshB = std::make_shared<Mesh>();
+        res.push_back( { "macro/boolean" + suffix,
+            [meshA, meshB, n]
+            {
+                const int resolution = std::max( 4, int( std::sqrt( float( n ) ) ) );
+                *meshA = makeUVSphere( 1.0f, resolution, resolution );
+                *meshB = makeUVSphere( 1.0f, resolution, resolution );
+                meshB->transform( AffineXf3f::translation( Vector3f( 0.3f, 0.2f, 0.1f ) ) );
+            },
+            [meshA, meshB]
+            {
+                // the trees are part of boolean computation
+                meshA->invalidateCaches();
+                meshB->invalidateCaches();
+            },
+            [meshA, meshB]
+            {
+                if ( !boolean( *meshA, *meshB, BooleanOperation::Union ) )
+                    throw std::runtime_error( "boolean failed" );
+            } } );
+    }
+
+#ifndef __EMSCRIPTEN__
+    // macro: offset of torus with voxel size equal to its average edge length
+    {
+        auto mesh = std::make_shared<Mesh>();
+        res.push_back( { "macro/offsetMesh" + suffix,
+            [mesh, n] { *mesh = makeBenchTorus( n ); },
+            {},
+            [mesh]
+            {
+                OffsetParameters params;
+                params.voxelSize = mesh->averageEdgeLength();
+                if ( !offsetMesh( *mesh, 0.05f, params ) )
+                    throw std::runtime_error( "offsetMesh failed" );
+            } } );
+    }
+#endif
+
+    // macro: loading of the same grid mesh saved in several formats
+    for ( const char * ext : { ".mrmesh", ".stl", ".ply", ".obj" } )
+    {
+        const auto path = GetTempDirectory() / ( "MRBench_" + scale.name + ext );
+        res.push_back( { std::string( "macro/load" ) + ext + suffix,
+            [path, n]
+            {
+                if ( auto saved = MeshSave::toAnySupportedFormat( makeBenchGrid( n ), path ); !saved )
+                    throw std::runtime_error( saved.error() );
+            },
+            {},
+            [path]
+            {
+                if ( auto loaded = MeshLoad::fromAnySupportedFormat( path ); !loaded )
+                    throw std::runtime_error( loaded.error() );
+            } } );
+    }
+}
+
+std::string compilerInfo()
+{
+#ifdef __clang__
+    return fmt::format( "Clang {}", __clang_version__ );
+#elif defined __GNUC__
+    return fmt::format( "GCC {}", __VERSION__ );
+#else
+    return fmt::format( "MSVC {}", _MSC_FULL_VER );
+#endif
+}
+
+std::string osInfo()
+{
+#if defined(__EMSCRIPTEN__)
+    return "Web Browser";
+#elif defined(_WIN32)
+    return "Windows";
+#elif defined(__APPLE__)
+    return "macOS";
+#else
+    return "Linux";
+#endif
+}
+
+Json::Value hardwareInfo()
+{
+    Json::Value info;
+    info["version"] = GetMRVersionString();
+    info["cpu"] = GetCpuId();
+    info["hardwareThreads"] = std::thread::hardware_concurrency();
+    info["threads"] = Json::UInt64( tbb::global_control::active_value( tbb::global_control::max_allowed_parallelism ) );
+    info["compiler"] = compilerInfo();
+    info["os"] = osInfo();
+#ifdef NDEBUG
+    info["build"] = "Release";
+#else
+    info["build"] = "Debug";
+#endif
+    return info;
+}
+
+/// runs the benchmark given number of times, returns its statistics in milliseconds
+Json::Value measure( const Benchmark & b, int repetitions )
+{
+    if ( b.prepare )
+        b.prepare();
+
+    std::vector<double> times;
+    // first run is a warm-up and it is not counted
+    for ( int i = 0; i <= repetitions; ++i )
+    {
+        if ( b.setup )
+            b.setup();
+        Timer timer( b.name );
+        b.run();
+        const double ms = 1000 * timer.secondsPassed().count();
+        if ( i > 0 )
+            times.push_back( ms );
+    }
+    std::sort( times.begin(), times.end() );
+
+    Json::Value res;
+    res["name"] = b.name;
+    res["repetitions"] = repetitions;
+    res["min"] = times.front();
+    res["median"] = times.size() % 2 ? times[times.size() / 2] : ( times[times.size() / 2 - 1] + times[times.size() / 2] ) / 2;
+    res["mean"] = std::accumulate( times.begin(), times.end(), 0.0 ) / times.size();
+    res["max"] = times.back();
+    return res;
+}
+
+/// compares median times of the benchmarks present in both files,
+/// \return the number of benchmarks slower in new file more than by given relative threshold
+int compareResults( const Json::Value & base, const Json::Value & next, double threshold )
+{
+    for ( const char * key : { "cpu", "threads", "build" } )
+        if ( base["info"][key] != next["info"][key] )
+            std::cout << "Warning: results obtained on different configurations, " << key << ": "
+                << base["info"][key].asString() << " vs " << next["info"][key].asString() << "\n";
+
+    std::map<std::string, double> baseMedians;
+    for ( const auto & r : base["results"] )
+        baseMedians[r["name"].asString()] = r["median"].asDouble();
+
+    int numRegressions = 0;
+    std::cout << fmt::format( "{:<28} {:>12} {:>12} {:>8}\n", "benchmark", "base, ms", "new, ms", "ratio" );
+    for ( const auto & r : next["results"] )
+    {
+        const auto name = r["name"].asString();
+        auto it = baseMedians.find( name );
+        if ( it == baseMedians.end() )
+        {
+            std::cout << fmt::format( "{:<28} {:>12} {:>12.3f}\n", name, "-", r["median"].asDouble() );
+            continue;
+        }
+        const double ratio = it->second > 0 ? r["median"].asDouble() / it->second : 1.0;
+        const char * mark = "";
+        if ( ratio > 1 + threshold )
+        {
+            mark = "  REGRESSION";
+            ++numRegressions;
+        }
+        else if ( ratio < 1 / ( 1 + threshold ) )
+            mark = "  improved";
+        std::cout << fmt::format( "{:<28} {:>12.3f} {:>12.3f} {:>8.3f}{}\n", name, it->second, r["median"].asDouble(), ratio, mark );
+    }
+    std::cout << numRegressions << " regression(s) with threshold " << threshold * 100 << "%\n";
+    return numRegressions;
+}
+
+// can throw
+int mainInternal( int argc, char **argv )
+{
+    int repetitions = 5;
+    int threads = 0;
+    std::string filter;
+    std::string scales = "S,M";
+    std::filesystem::path outFilePath;
+    std::vector<std::filesystem::path> compareFiles;
+    double threshold = 0.1;
+
+    namespace po = boost::program_options;
+    po::options_description options( "Available options" );
+    options.add_options()
+        ( "help", "produce help message" )
+        ( "list", "print names of the benchmarks and exit" )
+        ( "filter", po::value<std::string>( &filter ), "run only the benchmarks with names matching given regular expression" )
+        ( "scales", po::value<std::string>( &scales )->default_value( scales ), "comma-separated sizes of inputs: S (10K vertices), M (100K), L (1M)" )
+        ( "repeat", po::value<int>( &repetitions )->default_value( repetitions ), "number of measured runs of each benchmark" )
+        ( "threads", po::value<int>( &threads ), "limit the number of threads, by default all hardware threads are used" )
+        ( "output", po::value<std::filesystem::path>( &outFilePath ), "save results in given JSON file" )
+        ( "compare", po::value<std::vector<std::filesystem::path>>( &compareFiles )->multitoken(), "compare two JSON result files: base and new" )
+        ( "threshold", po::value<double>( &threshold )->default_value( threshold ), "relative slowdown of median time reported as regression in comparison" )
+        ;
+
+    po::variables_map vm;
+    po::store( po::parse_command_line( argc, argv, options ), vm );
+    po::notify( vm );
+
+    if ( vm.count( "help" ) )
+    {
+        std::cerr <<
+            "MRBench is performance benchmark of MeshLib on synthetic inputs\n"
+            "Usage: MRBench [options]\n"
+            "       MRBench --compare base.json new.json [--threshold 0.1]   (exit code 3 if there are regressions)\n"
+            << options << "\n";
+        return 1;
+    }
+
+    if ( vm.count( "compare" ) )
+    {
+        if ( compareFiles.size() != 2 )
+        {
+            std::cerr << "--compare expects two result files\n";
+            return 1;
+        }
+        auto base = deserializeJsonValue( compareFiles[0] );
+        if ( !base )
+        {
+            std::cerr << base.error() << "\n";
+            return 1;
+        }
+        auto next = deserializeJsonValue( compareFiles[1] );
+        if ( !next )
+        {
+            std::cerr << next.error() << "\n";
+            return 1;
+        }
+        return compareResults( *base, *next, threshold ) > 0 ? 3 : 0;
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for ( const auto & s : AllScales )
+        if ( ( "," + scales + "," ).find( "," + s.name + "," ) != std::string::npos )
+            addBenchmarks( benchmarks, s );
+    if ( !filter.empty() )
+    {
+        const std::regex re( filter );
+        std::erase_if( benchmarks, [&re]( const Benchmark & b ) { return !std::regex_search( b.name, re ); } );
+    }
+
+    if ( vm.count( "list" ) )
+    {
+        for ( const auto & b : benchmarks )
+            std::cout << b.name << "\n";
+        return 0;
+    }
+
+    std::unique_ptr<tbb::global_control> threadLimit;
+    if ( threads > 0 )
+        threadLimit = std::make_unique<tbb::global_control>( tbb::global_control::max_allowed_parallelism, threads );
+
+    Json::Value root;
+    root["info"] = hardwareInfo();
+    std::cout << root["info"].toStyledString();
+    root["results"] = Json::arrayValue;
+    for ( const auto & b : benchmarks )
+    {
+        auto r = measure( b, std::max( 1, repetitions ) );
+        std::cout << fmt::format( "{:<28} median {:>10.3f} ms, min {:>10.3f} ms\n", b.name, r["median"].asDouble(), r["min"].asDouble() );
+        root["results"].append( std::move( r ) );
+    }
+
+    for ( const auto & s : AllScales )
+        for ( const char * ext : { ".mrmesh", ".stl", ".ply", ".obj" } )
+        {
+            std::error_code ec;
+            std::filesystem::remove( GetTempDirectory() / ( "MRBench_" + s.name + ext ), ec );
+        }
+
+    if ( !outFilePath.empty() )
+    {
+        std::ofstream ofs( outFilePath );
+        Json::StreamWriterBuilder builder;
+        std::unique_ptr<Json::StreamWriter> writer{ builder.newStreamWriter() };
+        if ( !ofs || writer->write( root, &ofs ) != 0 )
+        {
+            std::cerr << "Cannot write results in " << utf8string( outFilePath ) << "\n";
+            return 1;
+        }
+        std::cout << "Results saved in " << utf8string( outFilePath ) << "\n";
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+int main( int argc, char **argv )
+{
+    try
+    {
+        return mainInternal( argc, argv );
+    }
+    catch ( ... )
+    {
+        std::cerr << "Exception: " << boost::current_exception_diagnostic_information();
+        return 2;
+    }
+}
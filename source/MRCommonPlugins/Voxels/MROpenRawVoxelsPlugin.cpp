@@ -3,7 +3,7 @@
 #include "MRViewer/MRRibbonMenu.h"
 #include "MRViewer/ImGuiHelpers.h"
 #include "MRViewer/MRFileDialog.h"
-#include "MRViewer/MRProgressBar.h"
+#include "MRViewer/MRBackgroundJobs.h"
 #include "MRMesh/MRObjectVoxels.h"
 #include "MRMesh/MRStringConvert.h"
 #include "MRViewer/MRAppendHistory.h"
@@ -54,37 +54,58 @@ void OpenRawVoxelsPlugin::drawDialog( float menuScaling, ImGuiContext* )
         auto path = openFileDialog( { {},{},{{"RAW File","*.raw"}} } );
         if ( !path.empty() )
         {
-            ProgressBar::orderWithMainThreadPostProcessing( "Load voxels", [params = parameters_, path]()->std::function<void()>
+            // the loading does not block the user interface, several files can be loaded concurrently
+            BackgroundJobs::order( { "Load voxels " + utf8string( path.filename() ) },
+                [params = parameters_, path] ( const ProgressCallback& cb ) -> std::function<void()>
             {
-                ProgressBar::nextTask( "Load file" );
-                auto res = VoxelsLoad::loadRaw( path, params, ProgressBar::callBackSetProgress );
-                if ( res.has_value() )
+                // three equal stages: load file, create object, create iso-surface
+                auto stageCb = [&cb] ( int stage )
                 {
-                    ProgressBar::nextTask( "Create object" );
-                    std::shared_ptr<ObjectVoxels> object = std::make_shared<ObjectVoxels>();
-                    object->setName( utf8string( path.stem() ) );
-                    object->construct( *res, ProgressBar::callBackSetProgress );
-                    auto bins = object->histogram().getBins();
-                    auto minMax = object->histogram().getBinMinMax( bins.size() / 3 );
-
-                    ProgressBar::nextTask( "Create ISO surface" );
-                    object->setIsoValue( minMax.first, ProgressBar::callBackSetProgress );
-                    object->select( true );
-                    return [object] ()
-                    {
-                        AppendHistory<ChangeSceneAction>( "Open Voxels", object, ChangeSceneAction::Type::AddObject );
-                        SceneRoot::get().addChild( object );
-                        getViewerInstance().viewport().preciseFitDataToScreenBorder( { 0.9f } );
-                    };
+                    return ProgressCallback( [&cb, stage] ( float p ) { return cb( ( stage + p ) / 3.0f ); } );
+                };
+                std::shared_ptr<ObjectVoxels> object = std::make_shared<ObjectVoxels>();
+                object->setName( utf8string( path.stem() ) );
+                std::string error;
+                // 8-bit and 16-bit voxels are kept in compact storage till the grid is created
+                if ( params.isCompactType() )
+                {
+                    auto res = VoxelsLoad::loadRawCompact( path, params, stageCb( 0 ) );
+                    if ( res.has_value() )
+                        object->construct( *res, stageCb( 1 ) );
+                    else
+                        error = std::move( res.error() );
                 }
                 else
-                    return [error = res.error()] ()
+                {
+                    auto res = VoxelsLoad::loadRaw( path, params, stageCb( 0 ) );
+                    if ( res.has_value() )
+                        object->construct( *res, stageCb( 1 ) );
+                    else
+                        error = std::move( res.error() );
+                }
+                if ( !cb( 2.0f / 3.0f ) )
+                    return {}; // canceled
+                if ( !error.empty() )
+                    return [error] ()
                 {
                     auto menu = getViewerInstance().getMenuPlugin();
                     if ( menu )
                         menu->showErrorModal( error );
                 };
-            }, 3 );
+
+                auto bins = object->histogram().getBins();
+                auto minMax = object->histogram().getBinMinMax( bins.size() / 3 );
+                object->setIsoValue( minMax.first, stageCb( 2 ) );
+                if ( !cb( 1.0f ) )
+                    return {};
+                object->select( true );
+                return [object] ()
+                {
+                    AppendHistory<ChangeSceneAction>( "Open Voxels", object, ChangeSceneAction::Type::AddObject );
+                    SceneRoot::get().addChild( object );
+                    getViewerInstance().viewport().preciseFitDataToScreenBorder( { 0.9f } );
+                };
+            } );
         }
     }
 
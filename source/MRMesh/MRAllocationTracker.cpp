@@ -0,0 +1,208 @@
+#include "MRAllocationTracker.h"
+#include "MRGTest.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef MR_TRACK_ALLOCATIONS
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#endif
+
+namespace MR
+{
+
+namespace
+{
+
+std::atomic<size_t> allocCount{ 0 };
+std::atomic<size_t> allocBytes{ 0 };
+std::atomic<size_t> currentBytes{ 0 };
+std::atomic<size_t> peakBytes{ 0 };
+// the peak of allocated memory since the start of innermost scope
+std::atomic<size_t> scopePeakBytes{ 0 };
+std::atomic<bool> trackingEnabled{ false };
+
+void updateMax( std::atomic<size_t>& a, size_t value )
+{
+    auto old = a.load( std::memory_order_relaxed );
+    while ( old < value && !a.compare_exchange_weak( old, value, std::memory_order_relaxed ) ) {}
+}
+
+#ifdef MR_TRACK_ALLOCATIONS
+// the size of allocated block is requested from the allocator to avoid storing it in a header of each block
+size_t allocatedSize( void* p )
+{
+#if defined _WIN32
+    return _msize( p );
+#elif defined __APPLE__
+    return malloc_size( p );
+#else
+    return malloc_usable_size( p );
+#endif
+}
+
+void* allocate( size_t size )
+{
+    void* p = std::malloc( size > 0 ? size : 1 );
+    if ( !p )
+        return nullptr;
+    const auto bytes = allocatedSize( p );
+    allocCount.fetch_add( 1, std::memory_order_relaxed );
+    allocBytes.fetch_add( bytes, std::memory_order_relaxed );
+    const auto current = currentBytes.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+    updateMax( peakBytes, current );
+    updateMax( scopePeakBytes, current );
+    return p;
+}
+
+void deallocate( void* p )
+{
+    if ( !p )
+        return;
+    currentBytes.fetch_sub( allocatedSize( p ), std::memory_order_relaxed );
+    std::free( p );
+}
+#endif
+
+} // anonymous namespace
+
+bool isAllocationTrackingAvailable()
+{
+#ifdef MR_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+AllocationStats getAllocationStats()
+{
+    AllocationStats res;
+    res.count = allocCount.load( std::memory_order_relaxed );
+    res.bytes = allocBytes.load( std::memory_order_relaxed );
+    res.currentBytes = currentBytes.load( std::memory_order_relaxed );
+    res.peakBytes = peakBytes.load( std::memory_order_relaxed );
+    return res;
+}
+
+void enableAllocationTracking( bool on )
+{
+    trackingEnabled = on && isAllocationTrackingAvailable();
+}
+
+bool isAllocationTrackingEnabled()
+{
+    return trackingEnabled;
+}
+
+AllocationStats startAllocationScope()
+{
+    auto res = getAllocationStats();
+    // peakBytes of the state keeps the peak of outer scope to restore it at the end of this scope
+    res.peakBytes = scopePeakBytes.exchange( res.currentBytes, std::memory_order_relaxed );
+    return res;
+}
+
+AllocationStats finishAllocationScope( const AllocationStats& start )
+{
+    const auto now = getAllocationStats();
+    const auto scopePeak = scopePeakBytes.load( std::memory_order_relaxed );
+    updateMax( scopePeakBytes, start.peakBytes );
+
+    AllocationStats res;
+    res.count = now.count - start.count;
+    res.bytes = now.bytes - start.bytes;
+    res.currentBytes = now.currentBytes;
+    res.peakBytes = scopePeak > start.currentBytes ? scopePeak - start.currentBytes : 0;
+    return res;
+}
+
+TEST( MRMesh, AllocationTracker )
+{
+    if ( !isAllocationTrackingAvailable() )
+    {
+        EXPECT_EQ( getAllocationStats().count, 0 );
+        return;
+    }
+    constexpr size_t size = 1 << 20;
+    const auto outer = startAllocationScope();
+    std::vector<char> kept( size );
+    const auto inner = startAllocationScope();
+    {
+        std::vector<char> temp( 2 * size );
+    }
+    const auto innerStats = finishAllocationScope( inner );
+    EXPECT_GE( innerStats.count, 1 );
+    EXPECT_GE( innerStats.bytes, 2 * size );
+    EXPECT_GE( innerStats.peakBytes, 2 * size );
+
+    const auto outerStats = finishAllocationScope( outer );
+    EXPECT_GE( outerStats.count, 2 );
+    EXPECT_GE( outerStats.bytes, 3 * size );
+    // the peak of outer scope includes the peak of inner scope
+    EXPECT_GE( outerStats.peakBytes, 3 * size );
+    EXPECT_GE( getAllocationStats().peakBytes, 3 * size );
+}
+
+} // namespace MR
+
+#ifdef MR_TRACK_ALLOCATIONS
+
+void* operator new( std::size_t size )
+{
+    if ( auto p = MR::allocate( size ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size )
+{
+    if ( auto p = MR::allocate( size ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    return MR::allocate( size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    return MR::allocate( size );
+}
+
+void operator delete( void* p ) noexcept
+{
+    MR::deallocate( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+    MR::deallocate( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+    MR::deallocate( p );
+}
+
+void operator delete[]( void* p, std::size_t ) noexcept
+{
+    MR::deallocate( p );
+}
+
+void operator delete( void* p, const std::nothrow_t& ) noexcept
+{
+    MR::deallocate( p );
+}
+
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept
+{
+    MR::deallocate( p );
+}
+
+#endif // MR_TRACK_ALLOCATIONS
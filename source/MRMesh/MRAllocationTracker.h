@@ -0,0 +1,49 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include <cstddef>
+
+namespace MR
+{
+
+/// \addtogroup BasicGroup
+/// \{
+
+/// statistics of heap allocations made by operator new in all threads
+struct AllocationStats
+{
+    /// the number of allocations
+    size_t count = 0;
+    /// the total size of all allocations
+    size_t bytes = 0;
+    /// the size of currently allocated memory
+    size_t currentBytes = 0;
+    /// the maximal size of simultaneously allocated memory
+    size_t peakBytes = 0;
+};
+
+/// returns true if MeshLib is built with MR_TRACK_ALLOCATIONS definition, which replaces global operator new and delete
+/// to count allocations; otherwise allocation tracking is not available, and all statistics is zero;
+/// \note on Windows the replacement affects only the allocations made in MRMesh library
+[[nodiscard]] MRMESH_API bool isAllocationTrackingAvailable();
+
+/// returns current statistics of allocations since program start
+[[nodiscard]] MRMESH_API AllocationStats getAllocationStats();
+
+/// if allocation tracking is available and enabled, then each MR_TIMER scope in main thread records
+/// the number and total size of allocations and the peak of allocated memory above its level at the scope start,
+/// and these values are printed in the timing tree;
+/// \note allocations in all threads (e.g. in parallel algorithms) are attributed to current scope of main thread
+MRMESH_API void enableAllocationTracking( bool on );
+[[nodiscard]] MRMESH_API bool isAllocationTrackingEnabled();
+
+/// starts new scope of peak memory measurement, returns the state to be passed in finishAllocationScope
+[[nodiscard]] MRMESH_API AllocationStats startAllocationScope();
+
+/// finishes the scope started by startAllocationScope (the scopes must be properly nested),
+/// returns the statistics of allocations inside the scope: peakBytes is the maximal excess of allocated memory over its level at the scope start
+[[nodiscard]] MRMESH_API AllocationStats finishAllocationScope( const AllocationStats& start );
+
+/// \}
+
+} // namespace MR
@@ -1,4 +1,5 @@
 #include "MRBitSet.h"
+#include "MRBitSetParallelFor.h"
 #include "MRGTest.h"
 
 namespace MR
@@ -101,4 +102,41 @@ TEST(MRMesh, TaggedBitSet)
     EXPECT_EQ( VertBitSet( VertBitSet( bs0 ) ^= bs1 ).count(), 2 );
 }
 
+TEST(MRMesh, BitSetParallelFor)
+{
+    FaceBitSet bs( 100000 );
+    for ( int i = 0; i < 100000; i += 7 )
+        bs.set( FaceId( i ) );
+    bs.set( FaceId( 99999 ) );
+
+    std::atomic<size_t> count{ 0 }, sum{ 0 };
+    BitSetParallelFor( bs, [&]( FaceId f )
+    {
+        EXPECT_TRUE( bs.test( f ) );
+        ++count;
+        sum += f;
+    } );
+    size_t expectedSum = 0;
+    for ( auto f : bs )
+        expectedSum += f;
+    EXPECT_EQ( count, bs.count() );
+    EXPECT_EQ( sum, expectedSum );
+
+    const SparseFaceSet sparse( bs );
+    EXPECT_EQ( sparse.count(), bs.count() );
+    EXPECT_TRUE( sparse.test( FaceId( 700 ) ) );
+    EXPECT_FALSE( sparse.test( FaceId( 701 ) ) );
+    EXPECT_EQ( sparse.toBitSet( bs.size() ), bs );
+
+    count = 0;
+    sum = 0;
+    BitSetParallelFor( sparse, [&]( FaceId f )
+    {
+        ++count;
+        sum += f;
+    } );
+    EXPECT_EQ( count, bs.count() );
+    EXPECT_EQ( sum, expectedSum );
+}
+
 } //namespace MR
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "MRBitSet.h"
+#include "MRSparseIdSet.h"
 #include "MRPch/MRTBB.h"
 #include "MRProgressCallback.h"
 #include <atomic>
+#include <bit>
 #include <thread>
 
 namespace MR
@@ -72,36 +74,140 @@ bool BitSetParallelForAll( const BS& bs, F f, ProgressCallback progressCb )
     return keepGoing.load( std::memory_order_relaxed );
 }
 
-/// executes given function f for every set bit in bs in parallel threads;
-/// it is guaranteed that every individual block in bit-set is processed by one thread only
+namespace BitSetParallel
+{
+
+/// calls f for every set bit in the blocks [beginBlock, endBlock) of bs, skipping zero blocks entirely
 template <typename BS, typename F>
-void BitSetParallelFor( const BS& bs, F f )
+inline void forSetBitsInBlocks( const BS& bs, size_t beginBlock, size_t endBlock, F& f )
 {
     using IndexType = typename BS::IndexType;
-    BitSetParallelForAll( bs, [&]( IndexType id )
+    for ( size_t b = beginBlock; b < endBlock; ++b )
+    {
+        for ( auto block = bs.m_bits[b]; block; block &= block - 1 ) // clear the lowest set bit
+            f( IndexType( b * BS::bits_per_block + std::countr_zero( block ) ) );
+    }
+}
+
+/// the number of blocks, which set bits are counted together to balance the work among threads
+constexpr size_t BlocksInChunk = 256;
+
+/// splits the blocks of bs in the ranges with approximately equal number of set bits in each
+template <typename BS>
+std::vector<size_t> splitBlocksBySetBits( const BS& bs, size_t numRanges )
+{
+    const size_t numBlocks = bs.num_blocks();
+    const size_t numChunks = ( numBlocks + BlocksInChunk - 1 ) / BlocksInChunk;
+    std::vector<size_t> chunkCount( numChunks + 1, 0 );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, numChunks ), [&] ( const tbb::blocked_range<size_t>& range )
     {
-        if ( bs.test( id ) )
+        for ( size_t c = range.begin(); c < range.end(); ++c )
         {
-            f( id );
+            size_t count = 0;
+            for ( size_t b = c * BlocksInChunk; b < std::min( numBlocks, ( c + 1 ) * BlocksInChunk ); ++b )
+                count += std::popcount( bs.m_bits[b] );
+            chunkCount[c + 1] = count;
         }
     } );
+    for ( size_t c = 0; c < numChunks; ++c )
+        chunkCount[c + 1] += chunkCount[c];
+
+    const size_t total = chunkCount.back();
+    std::vector<size_t> bounds{ 0 };
+    size_t c = 0;
+    for ( size_t r = 1; r < numRanges && c < numChunks; ++r )
+    {
+        const size_t target = total * r / numRanges;
+        while ( c < numChunks && chunkCount[c] < target )
+            ++c;
+        if ( c * BlocksInChunk > bounds.back() )
+            bounds.push_back( std::min( numBlocks, c * BlocksInChunk ) );
+    }
+    if ( bounds.back() < numBlocks )
+        bounds.push_back( numBlocks );
+    return bounds;
+}
+
+} // namespace BitSetParallel
+
+/// executes given function f for every set bit in bs in parallel threads;
+/// zero blocks are skipped without testing their bits, and the work is split among threads by the number of set bits rather than by index range;
+/// it is guaranteed that every individual block in bit-set is processed by one thread only
+template <typename BS, typename F>
+void BitSetParallelFor( const BS& bs, F f )
+{
+    const size_t numBlocks = bs.num_blocks();
+    if ( numBlocks <= BitSetParallel::BlocksInChunk )
+    {
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0, numBlocks ), [&] ( const tbb::blocked_range<size_t>& range )
+        {
+            BitSetParallel::forSetBitsInBlocks( bs, range.begin(), range.end(), f );
+        } );
+        return;
+    }
+
+    // several ranges per thread to let work stealing smooth out the difference in the cost of f calls
+    const auto bounds = BitSetParallel::splitBlocksBySetBits( bs, 8 * size_t( tbb::this_task_arena::max_concurrency() ) );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, bounds.size() - 1, 1 ), [&] ( const tbb::blocked_range<size_t>& range )
+    {
+        for ( size_t r = range.begin(); r < range.end(); ++r )
+            BitSetParallel::forSetBitsInBlocks( bs, bounds[r], bounds[r + 1], f );
+    }, tbb::simple_partitioner() );
 }
 
 /// executes given function f for every set bit in bs in parallel threads;
+/// zero blocks are skipped without testing their bits;
 /// it is guaranteed that every individual block in bit-set is processed by one thread only
 /// uses tbb::static_partitioner for uniform distribution of ids
 /// \return false if the processing was canceled by progressCb
 template <typename BS, typename F>
 bool BitSetParallelFor( const BS& bs, F f, ProgressCallback progressCb )
 {
-    using IndexType = typename BS::IndexType;
-    return BitSetParallelForAll( bs, [&] ( IndexType id )
+    if ( !progressCb )
+    {
+        BitSetParallelFor( bs, f );
+        return true;
+    }
+
+    const size_t numBlocks = bs.num_blocks();
+    auto mainThreadId = std::this_thread::get_id();
+    std::atomic<bool> keepGoing{ true };
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, numBlocks ),
+        [&] ( const tbb::blocked_range<size_t>& range )
     {
-        if ( bs.test( id ) )
+        const bool report = std::this_thread::get_id() == mainThreadId;
+        const auto blockRange = float( range.size() );
+        for ( size_t b = range.begin(); b < range.end(); ++b )
         {
-            f( id );
+            if ( !keepGoing.load( std::memory_order_relaxed ) )
+                break;
+            BitSetParallel::forSetBitsInBlocks( bs, b, b + 1, f );
+            if ( report && !progressCb( float( b - range.begin() ) / blockRange ) )
+                keepGoing.store( false, std::memory_order_relaxed );
         }
-    }, progressCb );
+    }, tbb::static_partitioner() ); // static partitioner is needed to uniform distribution of ids
+    return keepGoing.load( std::memory_order_relaxed );
+}
+
+/// executes given function f for every id of sparse set in parallel threads;
+/// it is guaranteed that all ids from one block of corresponding bit-set are processed by one thread only
+template <typename T, typename F>
+void BitSetParallelFor( const SparseIdSet<T>& set, F f )
+{
+    const auto& ids = set.ids();
+    // moves the boundary of a range forward till the first id of next block
+    auto blockStart = [&] ( size_t i )
+    {
+        while ( i > 0 && i < ids.size() && int( ids[i] ) / BitSet::bits_per_block == int( ids[i - 1] ) / BitSet::bits_per_block )
+            ++i;
+        return i;
+    };
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, ids.size() ), [&] ( const tbb::blocked_range<size_t>& range )
+    {
+        const auto end = blockStart( range.end() );
+        for ( size_t i = blockStart( range.begin() ); i < end; ++i )
+            f( ids[i] );
+    } );
 }
 
 /// \}
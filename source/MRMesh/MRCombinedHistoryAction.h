@@ -27,6 +27,9 @@ public:
 
     bool empty() const { return actions_.empty(); };
 
+    /// Returns combined actions in the order of redo
+    const HistoryActionsVector& getActions() const { return actions_; }
+
     [[nodiscard]] MRMESH_API virtual size_t heapBytes() const override;
 
 private:
@@ -10,8 +10,11 @@
 #include "MRMeshFixer.h"
 #include "MRHeap.h"
 #include "MRTimer.h"
+#include "MRBitSetParallelFor.h"
 #include "MRTorus.h"
 #include "MRGTest.h"
+#include "MRPch/MRTBB.h"
+#include <random>
 
 namespace MR
 {
@@ -114,7 +117,8 @@ static void makeConvexOriginRing( Mesh & mesh, EdgeId e )
 
 const double NoDist = -1.0;
 
-Mesh makeConvexHull( const VertCoords & points, const VertBitSet & validPoints )
+// serial incremental algorithm, optionally returns the ids of input points that became the vertices of the hull
+static Mesh makeConvexHullSerial( const VertCoords & points, const VertBitSet & validPoints, VertBitSet * outHullPoints = nullptr )
 {
     MR_TIMER
     Mesh res;
@@ -309,9 +313,142 @@ Mesh makeConvexHull( const VertCoords & points, const VertBitSet & validPoints )
             break;*/
     }
 
+    if ( outHullPoints )
+        *outHullPoints = std::move( hullPoints );
     return res;
 }
 
+// returns the ids of input points that are the vertices of their convex hull;
+// the incremental algorithm needs the hull mesh to find them, but the mesh is not returned
+static VertBitSet findConvexHullPoints( const VertCoords & points, const VertBitSet & validPoints )
+{
+    VertBitSet res;
+    (void)makeConvexHullSerial( points, validPoints, &res );
+    return res;
+}
+
+// returns the points having extreme projections on 26 directions to the corners, edge middles and face centers of a cube
+static VertBitSet getExtremePoints( const VertCoords & points, const VertBitSet & validPoints )
+{
+    MR_TIMER
+    constexpr int NumDirs = 26;
+    struct Extreme
+    {
+        float proj = -FLT_MAX;
+        VertId v;
+    };
+    using Extremes = std::array<Extreme, NumDirs>;
+
+    std::array<Vector3f, NumDirs> dirs;
+    int n = 0;
+    for ( int x = -1; x <= 1; ++x )
+        for ( int y = -1; y <= 1; ++y )
+            for ( int z = -1; z <= 1; ++z )
+                if ( x != 0 || y != 0 || z != 0 )
+                    dirs[n++] = Vector3f( float( x ), float( y ), float( z ) );
+    assert( n == NumDirs );
+
+    tbb::enumerable_thread_specific<Extremes> threadExtremes;
+    BitSetParallelFor( validPoints, [&]( VertId v )
+    {
+        auto & extremes = threadExtremes.local();
+        const auto & p = points[v];
+        for ( int i = 0; i < NumDirs; ++i )
+        {
+            const auto proj = dot( dirs[i], p );
+            auto & e = extremes[i];
+            if ( proj > e.proj || ( proj == e.proj && v < e.v ) )
+                e = { proj, v };
+        }
+    } );
+
+    Extremes extremes;
+    for ( const auto & te : threadExtremes )
+    {
+        for ( int i = 0; i < NumDirs; ++i )
+        {
+            if ( te[i].proj > extremes[i].proj || ( te[i].proj == extremes[i].proj && te[i].v < extremes[i].v ) )
+                extremes[i] = te[i];
+        }
+    }
+
+    VertBitSet res( validPoints.size() );
+    for ( const auto & e : extremes )
+        if ( e.v )
+            res.set( e.v );
+    return res;
+}
+
+// removes from candidates all points strictly inside the convex polyhedron
+static void removeInnerPoints( const VertCoords & points, VertBitSet & candidates, const Mesh & polyhedron )
+{
+    MR_TIMER
+    std::vector<Plane3d> planes;
+    for ( auto f : polyhedron.topology.getValidFaces() )
+    {
+        VertId a, b, c;
+        polyhedron.topology.getTriVerts( f, a, b, c );
+        const Vector3d ap{ polyhedron.points[a] };
+        const Vector3d bp{ polyhedron.points[b] };
+        const Vector3d cp{ polyhedron.points[c] };
+        const auto n = cross( bp - ap, cp - ap );
+        if ( n.lengthSq() <= 0 )
+            return; // degenerate polyhedron, keep all points
+        planes.push_back( Plane3d::fromDirAndPt( n.normalized(), ap ) );
+    }
+    if ( planes.size() < 4 )
+        return; // flat polyhedron has no interior
+
+    BitSetParallelFor( candidates, [&]( VertId v )
+    {
+        const Vector3d p{ points[v] };
+        for ( const auto & pl : planes )
+            if ( !( pl.distance( p ) < 0 ) )
+                return;
+        candidates.reset( v );
+    } );
+}
+
+Mesh makeConvexHull( const VertCoords & points, const VertBitSet & validPoints )
+{
+    MR_TIMER
+    constexpr size_t MinParallelPoints = 1 << 15;
+    const auto numPoints = validPoints.count();
+    if ( numPoints < MinParallelPoints )
+        return makeConvexHullSerial( points, validPoints );
+
+    // the points inside the hull of extreme points cannot be on the hull
+    VertBitSet candidates = validPoints;
+    removeInnerPoints( points, candidates, makeConvexHullSerial( points, getExtremePoints( points, validPoints ) ) );
+    const auto numCandidates = candidates.count();
+    if ( numCandidates < MinParallelPoints )
+        return makeConvexHullSerial( points, candidates );
+
+    // the hulls of parts are found in parallel, and then the hull of their vertices
+    const size_t numParts = std::min( numCandidates / ( MinParallelPoints / 2 ), 4 * size_t( tbb::this_task_arena::max_concurrency() ) );
+    const auto bounds = BitSetParallel::splitBlocksBySetBits( candidates, numParts );
+    std::vector<VertBitSet> partHullPoints( bounds.size() - 1 );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, partHullPoints.size(), 1 ), [&]( const tbb::blocked_range<size_t> & range )
+    {
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+        {
+            VertBitSet part( candidates.size() );
+            auto addToPart = [&part]( VertId v ) { part.set( v ); };
+            BitSetParallel::forSetBitsInBlocks( candidates, bounds[i], bounds[i + 1], addToPart );
+            partHullPoints[i] = findConvexHullPoints( points, part );
+        }
+    } );
+
+    VertBitSet hullCandidates( candidates.size() );
+    for ( const auto & hp : partHullPoints )
+    {
+        if ( hp.size() > hullCandidates.size() )
+            hullCandidates.resize( hp.size() );
+        hullCandidates |= hp;
+    }
+    return makeConvexHullSerial( points, hullCandidates );
+}
+
 Mesh makeConvexHull( const Mesh & in )
 {
     return makeConvexHull( in.points, in.topology.getValidVerts() );
@@ -331,4 +468,30 @@ TEST( MRMesh, ConvexHull )
     EXPECT_EQ( discus.topology.lastNotLoneEdge(), EdgeId( 426 * 2 - 1 ) );
 }
 
+// points uniformly distributed in a ball
+static PointCloud makeRandomBallCloud( size_t numPoints )
+{
+    PointCloud res;
+    std::mt19937 gen( 42 );
+    std::uniform_real_distribution<float> dist( -1.0f, 1.0f );
+    while ( res.points.size() < numPoints )
+    {
+        const Vector3f p( dist( gen ), dist( gen ), dist( gen ) );
+        if ( p.lengthSq() <= 1 )
+            res.points.push_back( p );
+    }
+    res.validPoints.resize( res.points.size(), true );
+    return res;
+}
+
+TEST( MRMesh, ConvexHullParallel )
+{
+    const auto cloud = makeRandomBallCloud( 200000 );
+    const auto serial = makeConvexHullSerial( cloud.points, cloud.validPoints );
+    const auto parallel = makeConvexHull( cloud );
+    EXPECT_EQ( parallel.topology.numValidVerts(), serial.topology.numValidVerts() );
+    EXPECT_EQ( parallel.topology.numValidFaces(), serial.topology.numValidFaces() );
+    EXPECT_NEAR( parallel.volume(), serial.volume(), 1e-6 * serial.volume() );
+}
+
 } //namespace MR
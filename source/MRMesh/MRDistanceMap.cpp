@@ -11,6 +11,7 @@
 #include "MRPolyline2Project.h"
 #include "MRBitSetParallelFor.h"
 #include "MRPolyline2Intersect.h"
+#include "MRLineSegm.h"
 #include "MRPch/MRSpdlog.h"
 #include "MRPch/MRTBB.h"
 #include <vector>
@@ -336,6 +337,479 @@ DistanceMap computeDistanceMapD( const MeshPart& mp, const MeshToDistanceMapPara
     return computeDistanceMap_<double>( mp, params );
 }
 
+namespace
+{
+
+/// applies the sign and the offset of the closest edge to the distance from the pixel to contours
+float finalizeContoursDistance( float dist, UndirectedEdgeId line, bool positive, const ContourToDistanceMapParams& params,
+    const ContoursDistanceMapOptions& options )
+{
+    if ( !positive )
+    {
+        dist *= -1.0f;
+        if ( options.offsetParameters )
+            dist -= 2.0f * options.offsetParameters->perEdgeOffset[line];
+    }
+    if ( !params.withSign && options.offsetParameters && options.offsetParameters->type == ContoursDistanceMapOffset::OffsetType::Shell )
+        dist = std::abs( dist );
+    return dist;
+}
+
+/// finds the closest point of contours (taking into account per-edge offsets) by the search in AABB tree
+Polyline2ProjectionWithOffsetResult projectOnContours( const Vector2f& p, const Polyline2& polyline, const ContoursDistanceMapOptions& options )
+{
+    Polyline2ProjectionWithOffsetResult res;
+    if ( options.offsetParameters )
+    {
+        res = findProjectionOnPolyline2WithOffset( p, polyline, options.offsetParameters->perEdgeOffset );
+    }
+    else
+    {
+        auto noOffsetRes = findProjectionOnPolyline2( p, polyline );
+        res.line = noOffsetRes.line;
+        res.point = noOffsetRes.point;
+        res.dist = std::sqrt( noOffsetRes.distSq );
+    }
+    return res;
+}
+
+/// grid cells crossed by contour edges (seeds) and the edges crossing each of them
+struct ContoursRaster
+{
+    /// the size of the grid, which is the distance map extended to cover the contours (up to some margin)
+    int width = 0;
+    int height = 0;
+    /// pixel (x,y) of distance map is the cell (x+offsetX, y+offsetY) of the grid
+    int offsetX = 0;
+    int offsetY = 0;
+
+    struct Seed
+    {
+        int cell = 0;
+        int edgesBegin = 0;
+        int edgesEnd = 0;
+    };
+    std::vector<Seed> seeds;
+    std::vector<UndirectedEdgeId> edges;
+
+    /// whether the contours extend past the left, right, bottom and top sides of the grid and were clipped there
+    bool clippedMinX = false;
+    bool clippedMaxX = false;
+    bool clippedMinY = false;
+    bool clippedMaxY = false;
+};
+
+/// clips segment (a,b) by the rectangle [0,size.x]x[0,size.y] (Liang-Barsky), returns false if nothing remains
+bool clipSegment( Vector2f& a, Vector2f& b, const Vector2f& size )
+{
+    const Vector2f d = b - a;
+    float t0 = 0.0f, t1 = 1.0f;
+    const auto clip = [&] ( float p, float q )
+    {
+        // the part of the segment with p * t <= q is kept
+        if ( p == 0.0f )
+            return q >= 0.0f;
+        const float t = q / p;
+        if ( p < 0.0f )
+            t0 = std::max( t0, t );
+        else
+            t1 = std::min( t1, t );
+        return t0 <= t1;
+    };
+    if ( !clip( -d.x, a.x ) || !clip( d.x, size.x - a.x ) || !clip( -d.y, a.y ) || !clip( d.y, size.y - a.y ) )
+        return false;
+    const Vector2f a0 = a;
+    if ( t0 > 0.0f )
+        a = a0 + t0 * d;
+    if ( t1 < 1.0f )
+        b = a0 + t1 * d;
+    return true;
+}
+
+ContoursRaster rasterizeContours( const Polyline2& polyline, const ContourToDistanceMapParams& params )
+{
+    MR_TIMER
+    ContoursRaster res;
+    const auto toGrid = [&] ( const Vector2f& p )
+    {
+        return Vector2f( ( p.x - params.orgPoint.x ) / params.pixelSize.x, ( p.y - params.orgPoint.y ) / params.pixelSize.y );
+    };
+    // contours outside the map are rasterized in the margins, but the margins are limited not to waste the memory,
+    // and the contours beyond them are clipped
+    const auto box = polyline.getBoundingBox();
+    const auto gridMin = toGrid( box.min );
+    const auto gridMax = toGrid( box.max );
+    const int maxMarginX = std::max( 16, params.resolution.x / 4 );
+    const int maxMarginY = std::max( 16, params.resolution.y / 4 );
+    res.offsetX = std::clamp( int( std::ceil( -gridMin.x ) ), 0, maxMarginX );
+    res.offsetY = std::clamp( int( std::ceil( -gridMin.y ) ), 0, maxMarginY );
+    res.width = res.offsetX + params.resolution.x + std::clamp( int( std::ceil( gridMax.x ) ) - params.resolution.x, 0, maxMarginX );
+    res.height = res.offsetY + params.resolution.y + std::clamp( int( std::ceil( gridMax.y ) ) - params.resolution.y, 0, maxMarginY );
+    assert( size_t( res.width ) * res.height < size_t( INT_MAX ) );
+    res.clippedMinX = -gridMin.x > float( res.offsetX );
+    res.clippedMinY = -gridMin.y > float( res.offsetY );
+    res.clippedMaxX = gridMax.x + float( res.offsetX ) > float( res.width );
+    res.clippedMaxY = gridMax.y + float( res.offsetY ) > float( res.height );
+
+    // all cells crossed by each edge: the segment is clipped by each row of cells it passes
+    std::vector<std::pair<int, UndirectedEdgeId>> marks;
+    const Vector2f shift( float( res.offsetX ), float( res.offsetY ) );
+    for ( UndirectedEdgeId ue{ 0 }; ue < polyline.topology.undirectedEdgeSize(); ++ue )
+    {
+        if ( polyline.topology.isLoneEdge( ue ) )
+            continue;
+        auto a = toGrid( polyline.orgPnt( ue ) ) + shift;
+        auto b = toGrid( polyline.destPnt( ue ) ) + shift;
+        if ( !clipSegment( a, b, Vector2f( float( res.width ), float( res.height ) ) ) )
+            continue;
+        if ( a.y > b.y )
+            std::swap( a, b );
+        const int y0 = std::clamp( int( std::floor( a.y ) ), 0, res.height - 1 );
+        const int y1 = std::clamp( int( std::floor( b.y ) ), 0, res.height - 1 );
+        for ( int y = y0; y <= y1; ++y )
+        {
+            float xa = a.x, xb = b.x;
+            if ( b.y > a.y )
+            {
+                const float ta = std::clamp( ( float( y ) - a.y ) / ( b.y - a.y ), 0.0f, 1.0f );
+                const float tb = std::clamp( ( float( y + 1 ) - a.y ) / ( b.y - a.y ), 0.0f, 1.0f );
+                xa = a.x + ta * ( b.x - a.x );
+                xb = a.x + tb * ( b.x - a.x );
+            }
+            if ( xa > xb )
+                std::swap( xa, xb );
+            const int x0 = std::clamp( int( std::floor( xa ) ), 0, res.width - 1 );
+            const int x1 = std::clamp( int( std::floor( xb ) ), 0, res.width - 1 );
+            for ( int x = x0; x <= x1; ++x )
+                marks.emplace_back( y * res.width + x, ue );
+        }
+    }
+    std::sort( marks.begin(), marks.end() );
+
+    res.edges.reserve( marks.size() );
+    for ( size_t i = 0; i < marks.size(); ++i )
+    {
+        if ( i == 0 || marks[i].first != marks[i - 1].first )
+            res.seeds.push_back( { marks[i].first, int( i ), int( i ) } );
+        res.edges.push_back( marks[i].second );
+        ++res.seeds.back().edgesEnd;
+    }
+    return res;
+}
+
+/// finds the closest seed for each cell of the grid by exact Euclidean distance transform of Felzenszwalb and Huttenlocher
+/// (the distance is measured between cell centers in world units);
+/// returns the index of the closest seed for each cell or -1 if there are no seeds at all
+std::vector<int> findClosestSeeds( const ContoursRaster& raster, const Vector2f& pixelSize )
+{
+    MR_TIMER
+    const int width = raster.width;
+    const int height = raster.height;
+    std::vector<int> closest( size_t( width ) * height, -1 );
+    for ( int s = 0; s < int( raster.seeds.size() ); ++s )
+        closest[raster.seeds[s].cell] = s;
+    const auto seedRow = [&] ( int s ) { return raster.seeds[s].cell / width; };
+
+    // the closest seed in each column, the columns are processed in blocks for memory locality
+    constexpr int blockSize = 64;
+    tbb::parallel_for( tbb::blocked_range<int>( 0, ( width + blockSize - 1 ) / blockSize ), [&] ( const tbb::blocked_range<int>& range )
+    {
+        int last[blockSize];
+        for ( int b = range.begin(); b < range.end(); ++b )
+        {
+            const int xBegin = b * blockSize;
+            const int xEnd = std::min( width, xBegin + blockSize );
+            std::fill( last, last + blockSize, -1 );
+            for ( int y = 0; y < height; ++y )
+            {
+                int* row = closest.data() + size_t( y ) * width;
+                for ( int x = xBegin; x < xEnd; ++x )
+                {
+                    if ( row[x] >= 0 )
+                        last[x - xBegin] = row[x];
+                    else
+                        row[x] = last[x - xBegin];
+                }
+            }
+            std::fill( last, last + blockSize, -1 );
+            for ( int y = height - 1; y >= 0; --y )
+            {
+                int* row = closest.data() + size_t( y ) * width;
+                for ( int x = xBegin; x < xEnd; ++x )
+                {
+                    int& below = last[x - xBegin];
+                    if ( row[x] >= 0 && seedRow( row[x] ) == y )
+                        below = row[x];
+                    else if ( below >= 0 && ( row[x] < 0 || seedRow( below ) - y < y - seedRow( row[x] ) ) )
+                        row[x] = below;
+                }
+            }
+        }
+    } );
+
+    // in each row: lower envelope of parabolas centered at the closest seeds of the columns
+    const double wx = sqr( double( pixelSize.x ) );
+    const double wy = sqr( double( pixelSize.y ) );
+    tbb::parallel_for( tbb::blocked_range<int>( 0, height ), [&] ( const tbb::blocked_range<int>& range )
+    {
+        std::vector<int> rowSeeds( width );
+        std::vector<int> v( width );
+        std::vector<double> f( width );
+        std::vector<double> z( width + 1 );
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        for ( int y = range.begin(); y < range.end(); ++y )
+        {
+            int* row = closest.data() + size_t( y ) * width;
+            std::copy( row, row + width, rowSeeds.begin() );
+            int k = -1;
+            for ( int q = 0; q < width; ++q )
+            {
+                if ( rowSeeds[q] < 0 )
+                    continue;
+                f[q] = wy * sqr( double( y - seedRow( rowSeeds[q] ) ) );
+                if ( k < 0 )
+                {
+                    k = 0;
+                    v[0] = q;
+                    z[0] = -inf;
+                    z[1] = inf;
+                    continue;
+                }
+                for ( ;; )
+                {
+                    const int p = v[k];
+                    const double s = ( ( f[q] + wx * sqr( double( q ) ) ) - ( f[p] + wx * sqr( double( p ) ) ) ) / ( 2 * wx * ( q - p ) );
+                    if ( s <= z[k] )
+                    {
+                        --k; // z[0] = -inf, so k never becomes negative here
+                        continue;
+                    }
+                    ++k;
+                    v[k] = q;
+                    z[k] = s;
+                    z[k + 1] = inf;
+                    break;
+                }
+            }
+            if ( k < 0 )
+                continue;
+            k = 0;
+            for ( int q = 0; q < width; ++q )
+            {
+                while ( z[k + 1] < q )
+                    ++k;
+                row[q] = rowSeeds[v[k]];
+            }
+        }
+    } );
+    return closest;
+}
+
+/// the edges crossing the horizontal line through the centers of each row of the distance map
+struct RowCrossings
+{
+    std::vector<int> rowBegin;
+    std::vector<UndirectedEdgeId> edges;
+};
+
+RowCrossings findRowCrossings( const Polyline2& polyline, const ContourToDistanceMapParams& params )
+{
+    MR_TIMER
+    const int height = params.resolution.y;
+    // the range of rows, which centers can be crossed by the edge (with reserve for rounding errors)
+    const auto rowRange = [&] ( UndirectedEdgeId ue )
+    {
+        auto y0 = ( polyline.orgPnt( ue ).y - params.orgPoint.y ) / params.pixelSize.y - 0.5f;
+        auto y1 = ( polyline.destPnt( ue ).y - params.orgPoint.y ) / params.pixelSize.y - 0.5f;
+        if ( y0 > y1 )
+            std::swap( y0, y1 );
+        return std::make_pair( std::max( 0, int( std::floor( y0 ) ) ), std::min( height - 1, int( std::ceil( y1 ) ) ) );
+    };
+
+    RowCrossings res;
+    res.rowBegin.resize( height + 1, 0 );
+    for ( UndirectedEdgeId ue{ 0 }; ue < polyline.topology.undirectedEdgeSize(); ++ue )
+    {
+        if ( polyline.topology.isLoneEdge( ue ) )
+            continue;
+        const auto [y0, y1] = rowRange( ue );
+        for ( int y = y0; y <= y1; ++y )
+            ++res.rowBegin[y + 1];
+    }
+    for ( int y = 0; y < height; ++y )
+        res.rowBegin[y + 1] += res.rowBegin[y];
+    res.edges.resize( res.rowBegin[height] );
+    auto pos = res.rowBegin;
+    for ( UndirectedEdgeId ue{ 0 }; ue < polyline.topology.undirectedEdgeSize(); ++ue )
+    {
+        if ( polyline.topology.isLoneEdge( ue ) )
+            continue;
+        const auto [y0, y1] = rowRange( ue );
+        for ( int y = y0; y <= y1; ++y )
+            res.edges[pos[y]++] = ue;
+    }
+    return res;
+}
+
+/// distanceMapFromContours with ContoursDistanceMapOptions::Engine::DistanceTransform
+void distanceMapFromContoursByTransform( DistanceMap& distMap, const Polyline2& polyline, const ContourToDistanceMapParams& params,
+    const ContoursDistanceMapOptions& options )
+{
+    MR_TIMER
+    const auto raster = rasterizeContours( polyline, params );
+    const auto closest = findClosestSeeds( raster, params.pixelSize );
+    const bool withSign = params.withSign && ( !options.offsetParameters || options.offsetParameters->type != ContoursDistanceMapOffset::OffsetType::Shell );
+    const auto crossings = withSign ? findRowCrossings( polyline, params ) : RowCrossings{};
+
+    float minOffset = 0, maxOffset = 0;
+    if ( options.offsetParameters )
+    {
+        const auto& offsets = options.offsetParameters->perEdgeOffset.vec_;
+        const auto [minIt, maxIt] = std::minmax_element( offsets.begin(), offsets.end() );
+        minOffset = *minIt;
+        maxOffset = *maxIt;
+    }
+    // a contour edge passes within half of pixel diagonal from the center of each seed it crosses
+    const float halfDiagonal = 0.5f * params.pixelSize.length();
+    // the distances are found exactly for the pixels with the closest seed within this band (around the zero level of offset contours)
+    const float exactBand = 3 * std::max( params.pixelSize.x, params.pixelSize.y ) + std::max( maxOffset, 0.0f );
+
+    const auto cellCenter = [&] ( int cell )
+    {
+        return Vector2f(
+            params.orgPoint.x + params.pixelSize.x * ( float( cell % raster.width - raster.offsetX ) + 0.5f ),
+            params.orgPoint.y + params.pixelSize.y * ( float( cell / raster.width - raster.offsetY ) + 0.5f ) );
+    };
+
+    // the distance from the center of grid cell to the nearest side of the grid, where the contours were clipped
+    const auto borderDist = [&] ( int gx, int gy )
+    {
+        float res = FLT_MAX;
+        if ( raster.clippedMinX )
+            res = std::min( res, params.pixelSize.x * ( float( gx ) + 0.5f ) );
+        if ( raster.clippedMaxX )
+            res = std::min( res, params.pixelSize.x * ( float( raster.width - gx ) - 0.5f ) );
+        if ( raster.clippedMinY )
+            res = std::min( res, params.pixelSize.y * ( float( gy ) + 0.5f ) );
+        if ( raster.clippedMaxY )
+            res = std::min( res, params.pixelSize.y * ( float( raster.height - gy ) - 0.5f ) );
+        return res;
+    };
+
+    tbb::parallel_for( tbb::blocked_range<int>( 0, params.resolution.y ), [&] ( const tbb::blocked_range<int>& range )
+    {
+        std::vector<std::pair<float, int>> rowCrossings;
+        for ( int y = range.begin(); y < range.end(); ++y )
+        {
+            const float py = params.orgPoint.y + params.pixelSize.y * ( float( y ) + 0.5f );
+            // intersections of the horizontal ray to the right with contours, the same as in isPointInsidePolyline
+            rowCrossings.clear();
+            if ( withSign )
+            {
+                for ( int i = crossings.rowBegin[y]; i < crossings.rowBegin[y + 1]; ++i )
+                {
+                    const auto ue = crossings.edges[i];
+                    const auto& org = polyline.orgPnt( ue );
+                    const auto& dest = polyline.destPnt( ue );
+                    if ( ( org.y <= py ) == ( dest.y <= py ) )
+                        continue;
+                    const double ratio = ( double( py ) - double( org.y ) ) / ( double( dest.y ) - double( org.y ) );
+                    const float x = float( ratio * double( dest.x ) + ( 1.0 - ratio ) * double( org.x ) );
+                    rowCrossings.emplace_back( x, dest.y > org.y ? 1 : -1 );
+                }
+                std::sort( rowCrossings.begin(), rowCrossings.end() );
+            }
+            size_t nextCrossing = 0;
+            int windingRight = 0;
+            for ( const auto& c : rowCrossings )
+                windingRight += c.second;
+
+            const int gy = y + raster.offsetY;
+            for ( int x = 0; x < params.resolution.x; ++x )
+            {
+                const size_t i = size_t( y ) * params.resolution.x + x;
+                const Vector2f p( params.orgPoint.x + params.pixelSize.x * ( float( x ) + 0.5f ), py );
+                while ( nextCrossing < rowCrossings.size() && rowCrossings[nextCrossing].first < p.x )
+                    windingRight -= rowCrossings[nextCrossing++].second;
+                if ( options.region && !options.region->test( PixelId( int( i ) ) ) )
+                    continue;
+
+                Polyline2ProjectionWithOffsetResult res;
+                res.dist = FLT_MAX;
+                const auto testSeed = [&] ( int s )
+                {
+                    const auto& seed = raster.seeds[s];
+                    for ( int j = seed.edgesBegin; j < seed.edgesEnd; ++j )
+                    {
+                        const auto ue = raster.edges[j];
+                        const auto proj = closestPointOnLineSegm( p, LineSegm2f{ polyline.orgPnt( ue ), polyline.destPnt( ue ) } );
+                        float dist = ( proj - p ).length();
+                        if ( options.offsetParameters )
+                            dist -= options.offsetParameters->perEdgeOffset[ue];
+                        if ( dist < res.dist )
+                        {
+                            res.dist = dist;
+                            res.point = proj;
+                            res.line = ue;
+                        }
+                    }
+                };
+
+                const int gx = x + raster.offsetX;
+                const int closestSeed = closest[size_t( gy ) * raster.width + gx];
+                const float seedDist = closestSeed >= 0 ? ( cellCenter( raster.seeds[closestSeed].cell ) - p ).length() : FLT_MAX;
+                if ( closestSeed >= 0 && seedDist <= exactBand )
+                {
+                    // the closest point of contours is in a seed within this radius
+                    const float radius = seedDist + 2 * halfDiagonal + ( maxOffset - minOffset );
+                    const int rx = int( std::ceil( radius / params.pixelSize.x ) );
+                    const int ry = int( std::ceil( radius / params.pixelSize.y ) );
+                    for ( int cy = std::max( 0, gy - ry ); cy <= std::min( raster.height - 1, gy + ry ); ++cy )
+                        for ( int cx = std::max( 0, gx - rx ); cx <= std::min( raster.width - 1, gx + rx ); ++cx )
+                        {
+                            const int cell = cy * raster.width + cx;
+                            const int s = closest[cell];
+                            if ( s >= 0 && raster.seeds[s].cell == cell )
+                                testSeed( s );
+                        }
+                }
+                else if ( closestSeed >= 0 )
+                {
+                    // far from contours: the closest seeds of the pixel and its neighbors
+                    int tested[9];
+                    int numTested = 0;
+                    for ( int cy = std::max( 0, gy - 1 ); cy <= std::min( raster.height - 1, gy + 1 ); ++cy )
+                        for ( int cx = std::max( 0, gx - 1 ); cx <= std::min( raster.width - 1, gx + 1 ); ++cx )
+                        {
+                            const int s = closest[size_t( cy ) * raster.width + cx];
+                            if ( std::find( tested, tested + numTested, s ) != tested + numTested )
+                                continue;
+                            tested[numTested++] = s;
+                            testSeed( s );
+                        }
+                }
+                // the contours clipped off the grid can be closer than the found seeds
+                if ( res.dist > borderDist( gx, gy ) - maxOffset )
+                    res = projectOnContours( p, polyline, options );
+
+                if ( options.outClosestEdges )
+                    ( *options.outClosestEdges )[i] = res.line;
+                bool positive = true;
+                if ( withSign )
+                {
+                    if ( options.signMethod == ContoursDistanceMapOptions::SignedDetectionMethod::WindingRule )
+                        positive = ( rowCrossings.size() - nextCrossing ) % 2 == 0;
+                    else
+                        positive = windingRight >= 0;
+                }
+                distMap.set( x, y, finalizeContoursDistance( res.dist, res.line, positive, params, options ) );
+            }
+        }
+    } );
+}
+
+} // anonymous namespace
+
 DistanceMap distanceMapFromContours( const Polyline2& polyline, const ContourToDistanceMapParams& params,
     const ContoursDistanceMapOptions& options )
 {
@@ -362,6 +836,11 @@ DistanceMap distanceMapFromContours( const Polyline2& polyline, const ContourToD
     DistanceMap distMap( params.resolution.x, params.resolution.y );
     if ( !polyline.topology.lastNotLoneEdge().valid())
         return distMap;
+    if ( options.engine == ContoursDistanceMapOptions::Engine::DistanceTransform )
+    {
+        distanceMapFromContoursByTransform( distMap, polyline, params, options );
+        return distMap;
+    }
     tbb::parallel_for( tbb::blocked_range<size_t>( 0, size ),
         [&] ( const tbb::blocked_range<size_t>& range )
     {
@@ -374,25 +853,14 @@ DistanceMap distanceMapFromContours( const Polyline2& polyline, const ContourToD
             Vector2f p;
             p.x = params.pixelSize.x * x + originPoint.x;
             p.y = params.pixelSize.y * y + originPoint.y;
-            Polyline2ProjectionWithOffsetResult res;
-            if ( options.offsetParameters )
-            {
-                res = findProjectionOnPolyline2WithOffset( p, polyline, options.offsetParameters->perEdgeOffset );
-            }
-            else
-            {
-                auto noOffsetRes = findProjectionOnPolyline2( p, polyline );
-                res.line = noOffsetRes.line;
-                res.point = noOffsetRes.point;
-                res.dist = std::sqrt( noOffsetRes.distSq );
-            }
-            
+            const auto res = projectOnContours( p, polyline, options );
+
             if ( options.outClosestEdges )
                 ( *options.outClosestEdges )[i] = res.line;
 
+            bool positive = true;
             if ( params.withSign && ( !options.offsetParameters || options.offsetParameters->type != ContoursDistanceMapOffset::OffsetType::Shell ) )
             {
-                bool positive = true;
                 if ( options.signMethod == ContoursDistanceMapOptions::SignedDetectionMethod::ContourOrientation )
                 {
                     const EdgeId e = res.line;
@@ -426,16 +894,8 @@ DistanceMap distanceMapFromContours( const Polyline2& polyline, const ContourToD
                     if ( isPointInsidePolyline( polyline, p ) )
                         positive = false;
                 }
-                if ( !positive )
-                {
-                    res.dist *= -1.0f;
-                    if ( options.offsetParameters )
-                        res.dist -= 2.0f * options.offsetParameters->perEdgeOffset[res.line];
-                }
             }
-            if ( !params.withSign && options.offsetParameters && options.offsetParameters->type == ContoursDistanceMapOffset::OffsetType::Shell )
-                res.dist = std::abs( res.dist );
-            distMap.set( x, y, res.dist );
+            distMap.set( x, y, finalizeContoursDistance( res.dist, res.line, positive, params, options ) );
         }
     } );
     return distMap;
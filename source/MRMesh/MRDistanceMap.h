@@ -193,6 +193,18 @@ struct ContoursDistanceMapOptions
         /// (recommended for contours with self-intersections)
         WindingRule
     } signMethod{ ContourOrientation };
+    /// algorithm of distance computation
+    enum class Engine
+    {
+        /// finds the closest point on contours for each pixel independently using AABB tree of contours
+        ClosestPoint,
+        /// rasterizes contours and finds the closest rasterized pixel for each pixel by separable linear-time Euclidean distance transform,
+        /// then computes the distances to contour segments passing through the closest rasterized pixels
+        /// (exactly near contours, and with the error not more than pixel diagonal far from them);
+        /// the sign is found by scanline intersections with contours (ContourOrientation method uses winding number of oriented contours then);
+        /// much faster than ClosestPoint for big maps
+        DistanceTransform
+    } engine{ Engine::ClosestPoint };
     /// optional input offset for each edges of polyline, find more on `ContoursDistanceMapOffset` structure description
     const ContoursDistanceMapOffset* offsetParameters{ nullptr };
     /// if pointer is valid, then only these pixels will be filled
@@ -325,6 +325,113 @@ TEST( MRMesh, DistanceMapOffsetMap )
     ASSERT_EQ( counter, 80275 );
 }
 
+TEST( MRMesh, DistanceMapFromContoursEngines )
+{
+    // clockwise star-shaped contour with concave corners and counterclockwise hole inside it
+    Contours2f conts( 2 );
+    constexpr int numRays = 7;
+    for ( int i = 0; i <= 2 * numRays; ++i )
+    {
+        const float angle = -PI_F * float( i % ( 2 * numRays ) ) / numRays;
+        const float radius = ( i % 2 == 0 ) ? 100.0f : 45.0f;
+        conts[0].push_back( { radius * std::cos( angle ), radius * std::sin( angle ) } );
+    }
+    conts[1] = { { -10.0f, -10.0f }, { 10.0f, -10.0f }, { 10.0f, 10.0f }, { -10.0f, 10.0f }, { -10.0f, -10.0f } };
+    Polyline2 polyline( conts );
+
+    const auto params = ContourToDistanceMapParams( Vector2i( 300, 280 ), Vector2f( -130.0f, -120.0f ), Vector2f( 260.0f, 240.0f ), true );
+    const float pixelDiagonal = params.pixelSize.length();
+
+    for ( auto signMethod : { ContoursDistanceMapOptions::SignedDetectionMethod::WindingRule, ContoursDistanceMapOptions::SignedDetectionMethod::ContourOrientation } )
+    {
+        ContoursDistanceMapOptions options;
+        options.signMethod = signMethod;
+        std::vector<UndirectedEdgeId> closestEdges;
+        options.outClosestEdges = &closestEdges;
+        const auto refMap = distanceMapFromContours( polyline, params, options );
+        options.engine = ContoursDistanceMapOptions::Engine::DistanceTransform;
+        const auto map = distanceMapFromContours( polyline, params, options );
+
+        for ( int i = 0; i < map.resX() * map.resY(); ++i )
+        {
+            const float ref = refMap.getValue( i );
+            const float val = map.getValue( i );
+            if ( signMethod == ContoursDistanceMapOptions::SignedDetectionMethod::WindingRule || std::abs( ref ) > pixelDiagonal )
+            {
+                ASSERT_EQ( ref < 0, val < 0 );
+            }
+            if ( std::abs( ref ) < pixelDiagonal )
+            {
+                ASSERT_NEAR( std::abs( ref ), std::abs( val ), 1e-4f );
+            }
+            else
+            {
+                ASSERT_LE( std::abs( std::abs( val ) - std::abs( ref ) ), pixelDiagonal );
+            }
+        }
+    }
+
+    // per-edge offsets
+    Vector<float, UndirectedEdgeId> perEdgeOffset( polyline.topology.undirectedEdgeSize() );
+    for ( UndirectedEdgeId ue{ 0 }; ue < perEdgeOffset.size(); ++ue )
+        perEdgeOffset[ue] = float( int( ue ) % 3 );
+    for ( auto type : { ContoursDistanceMapOffset::OffsetType::Normal, ContoursDistanceMapOffset::OffsetType::Shell } )
+    {
+        ContoursDistanceMapOffset offsetParams{ perEdgeOffset, type };
+        ContoursDistanceMapOptions options;
+        options.signMethod = ContoursDistanceMapOptions::SignedDetectionMethod::WindingRule;
+        options.offsetParameters = &offsetParams;
+        const auto refMap = distanceMapFromContours( polyline, params, options );
+        options.engine = ContoursDistanceMapOptions::Engine::DistanceTransform;
+        const auto map = distanceMapFromContours( polyline, params, options );
+        for ( int i = 0; i < map.resX() * map.resY(); ++i )
+        {
+            const float ref = refMap.getValue( i );
+            const float val = map.getValue( i );
+            if ( std::abs( ref ) < pixelDiagonal )
+            {
+                ASSERT_NEAR( ref, val, 1e-4f );
+            }
+            else
+            {
+                // negative distances are shifted on doubled offset of the closest edge, which can be found differently far from contours
+                ASSERT_LE( std::abs( val - ref ), pixelDiagonal + 2 * 2.0f );
+            }
+        }
+    }
+
+    // contours extending far past the map: enclosing square, small circle in the center and the strip crossing the map
+    Contours2f farConts( 3 );
+    farConts[0] = { { -1000.0f, -1000.0f }, { -1000.0f, 1000.0f }, { 1000.0f, 1000.0f }, { 1000.0f, -1000.0f }, { -1000.0f, -1000.0f } };
+    constexpr int numCirclePoints = 32;
+    for ( int i = 0; i <= numCirclePoints; ++i )
+    {
+        const float angle = 2 * PI_F * float( i % numCirclePoints ) / numCirclePoints;
+        farConts[1].push_back( { 10.0f * std::cos( angle ), 10.0f * std::sin( angle ) } );
+    }
+    farConts[2] = { { -900.0f, 30.0f }, { -900.0f, 35.0f }, { 900.0f, 35.0f }, { 900.0f, 30.0f }, { -900.0f, 30.0f } };
+    Polyline2 farPolyline( farConts );
+    const auto farParams = ContourToDistanceMapParams( Vector2i( 100, 100 ), Vector2f( -50.0f, -50.0f ), Vector2f( 100.0f, 100.0f ), true );
+    const float farPixelDiagonal = farParams.pixelSize.length();
+    {
+        ContoursDistanceMapOptions options;
+        options.signMethod = ContoursDistanceMapOptions::SignedDetectionMethod::WindingRule;
+        const auto refMap = distanceMapFromContours( farPolyline, farParams, options );
+        options.engine = ContoursDistanceMapOptions::Engine::DistanceTransform;
+        const auto map = distanceMapFromContours( farPolyline, farParams, options );
+        for ( int i = 0; i < map.resX() * map.resY(); ++i )
+        {
+            const float ref = refMap.getValue( i );
+            const float val = map.getValue( i );
+            ASSERT_EQ( ref < 0, val < 0 );
+            ASSERT_LE( std::abs( std::abs( val ) - std::abs( ref ) ), farPixelDiagonal );
+        }
+        // the pixel on the left border of the map is closer to the circle than to the square
+        EXPECT_NEAR( std::abs( map.getValue( 0, 40 ) ), std::abs( refMap.getValue( 0, 40 ) ), 1e-4f );
+        EXPECT_LT( std::abs( map.getValue( 0, 40 ) ), 50.0f );
+    }
+}
+
 TEST( MRMesh, DistanceMapInterpolation )
 {
     DistanceMap dm( 2, 2 );
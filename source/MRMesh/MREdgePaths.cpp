@@ -9,6 +9,10 @@
 #include "MRTimer.h"
 #include "MRCube.h"
 #include "MRUnionFind.h"
+#include "MRBitSetParallelFor.h"
+#include "MRTorus.h"
+#include "MRExpandShrink.h"
+#include "MRPch/MRTBB.h"
 #include "MRGTest.h"
 #include <queue>
 
@@ -442,16 +446,107 @@ void dilateRegionByMetric( const MeshTopology & topology, const EdgeMetric & met
 void dilateRegionByMetric( const MeshTopology & topology, const EdgeMetric & metric, VertBitSet & region, float dilation )
 {
     MR_TIMER
+    if ( !( dilation >= 0 ) )
+        return;
+    if ( region.size() < topology.vertSize() )
+        region.resize( topology.vertSize() );
 
-    EdgePathsBuilder builder( topology, metric );
-    builder.addStartRegion( region, 0 );
+    // only the vertices of the region having neighbors outside it start the propagation
+    VertBitSet pending( region.size() );
+    BitSetParallelFor( region, [&]( VertId v )
+    {
+        if ( !topology.hasVert( v ) )
+            return;
+        for ( EdgeId e : orgRing( topology, v ) )
+        {
+            if ( !region.test( topology.dest( e ) ) )
+            {
+                pending.set( v );
+                break;
+            }
+        }
+    } );
 
-    while ( !builder.done() && builder.doneDistance() <= dilation )
+    // the width of distance buckets processed in parallel is about the average metric of an edge near the region
+    float delta = 0;
+    int numSampled = 0;
+    for ( auto v : pending )
     {
-        auto vinfo = builder.growOneEdge();
-        if ( vinfo.back.valid() )
-            region.autoResizeSet( topology.org( vinfo.back ) );
+        for ( EdgeId e : orgRing( topology, v ) )
+        {
+            const auto m = metric( e );
+            if ( m < FLT_MAX )
+            {
+                delta += m;
+                ++numSampled;
+            }
+        }
+        if ( numSampled >= 1024 )
+            break;
+    }
+    delta = numSampled > 0 && delta > 0 ? delta / numSampled : dilation;
+    if ( !( delta > 0 ) )
+        delta = 1;
+
+    // the minimal metric to reach each vertex from the region, the same values as found by EdgePathsBuilder
+    Vector<float, VertId> dist( region.size(), FLT_MAX );
+    for ( auto v : pending )
+        dist[v] = 0;
+
+    tbb::enumerable_thread_specific<std::vector<std::pair<VertId, float>>> threadUpdates;
+    float bucketEnd = delta;
+    for (;;)
+    {
+        // all pending vertices in current bucket are relaxed in parallel, several times if the bucket is refilled
+        VertBitSet active( pending.size() );
+        BitSetParallelFor( pending, [&]( VertId v )
+        {
+            if ( dist[v] < bucketEnd )
+                active.set( v );
+        } );
+        if ( active.none() )
+        {
+            float minDist = FLT_MAX;
+            for ( auto v : pending )
+                minDist = std::min( minDist, dist[v] );
+            if ( minDist == FLT_MAX )
+                break;
+            bucketEnd = minDist + delta;
+            continue;
+        }
+        pending -= active;
+
+        BitSetParallelFor( active, [&]( VertId u )
+        {
+            auto & updates = threadUpdates.local();
+            const auto du = dist[u];
+            for ( EdgeId e : orgRing( topology, u ) )
+            {
+                const auto v = topology.dest( e );
+                const auto dv = du + metric( e );
+                if ( dv <= dilation && dv < dist[v] )
+                    updates.emplace_back( v, dv );
+            }
+        } );
+        for ( auto & updates : threadUpdates )
+        {
+            for ( const auto & [v, dv] : updates )
+            {
+                if ( dv < dist[v] )
+                {
+                    dist[v] = dv;
+                    pending.set( v );
+                }
+            }
+            updates.clear();
+        }
     }
+
+    BitSetParallelForAll( region, [&]( VertId v )
+    {
+        if ( dist[v] <= dilation )
+            region.set( v );
+    } );
 }
 
 void erodeRegionByMetric( const MeshTopology & topology, const EdgeMetric & metric, FaceBitSet & region, float dilation )
@@ -548,4 +643,66 @@ TEST(MRMesh, BuildShortestPath)
     EXPECT_LE( calcPathMetric( paths[0], euclid ), calcPathMetric( paths[1], euclid ) );
 }
 
+// the original sequential implementation of dilateRegionByMetric, kept verbatim as the reference for the test
+static void dilateRegionByMetricSeq( const MeshTopology & topology, const EdgeMetric & metric, VertBitSet & region, float dilation )
+{
+    MR_TIMER
+
+    EdgePathsBuilder builder( topology, metric );
+    builder.addStartRegion( region, 0 );
+
+    while ( !builder.done() && builder.doneDistance() <= dilation )
+    {
+        auto vinfo = builder.growOneEdge();
+        if ( vinfo.back.valid() )
+            region.autoResizeSet( topology.org( vinfo.back ) );
+    }
+}
+
+// the original expand of vertex region by hops, kept verbatim as the reference for the test
+static void expandSeq( const MeshTopology & topology, VertBitSet & region, int hops )
+{
+    assert( hops >= 0 );
+    if ( hops <= 0 )
+        return;
+    dilateRegionByMetricSeq( topology, identityMetric(), region, hops + 0.5f );
+}
+
+TEST(MRMesh, DilateRegionByMetric)
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 64, 64 );
+    const auto & topology = torus.topology;
+    const auto euclid = edgeLengthMetric( torus );
+
+    VertBitSet start( topology.vertSize() );
+    start.set( 0_v );
+    start.set( 1000_v );
+    start.set( 2000_v );
+    for ( float dilation : { 0.0f, 0.1f, 0.5f, 1.5f, 10.0f } )
+    {
+        auto region = start;
+        dilateRegionByMetric( topology, euclid, region, dilation );
+        auto ref = start;
+        dilateRegionByMetricSeq( topology, euclid, ref, dilation );
+        EXPECT_EQ( ( region - ref ).count(), 0 );
+        // the original implementation could add one vertex beyond the dilation after popping a stale queue entry,
+        // and only such vertex is allowed to be missing
+        const auto missing = ref - region;
+        EXPECT_LE( missing.count(), 1 );
+        for ( auto v : missing )
+            EXPECT_TRUE( buildSmallestMetricPath( topology, euclid, v, start, dilation ).empty() );
+    }
+    for ( int hops : { 1, 4, 20 } )
+    {
+        auto region = start;
+        dilateRegionByMetric( topology, identityMetric(), region, hops + 0.5f );
+        auto ref = start;
+        expandSeq( topology, ref, hops );
+        EXPECT_EQ( region, ref );
+        auto expanded = start;
+        expand( topology, expanded, hops );
+        EXPECT_EQ( expanded, ref );
+    }
+}
+
 } //namespace MR
@@ -76,7 +76,8 @@ MRMESH_API void addLeftBand( const MeshTopology & topology, const EdgeLoop & loo
     EdgeBitSet * outNotLoopEdges = nullptr );
 [[nodiscard]] MRMESH_API EdgeLoop extractLongestClosedLoop( const Mesh & mesh, const std::vector<EdgeId> & inEdges );
 
-/// expands the region (of faces or vertices) on given metric value
+/// expands the region (of faces or vertices) on given metric value;
+/// the distances are propagated in parallel by buckets, so the metric must be callable from several threads at once
 MRMESH_API void dilateRegionByMetric( const MeshTopology & topology, const EdgeMetric & metric, FaceBitSet & region, float dilation );
 MRMESH_API void dilateRegionByMetric( const MeshTopology & topology, const EdgeMetric & metric, VertBitSet & region, float dilation );
 
@@ -2,16 +2,79 @@
 #include "MREdgePaths.h"
 #include "MRTimer.h"
 #include "MRMeshTopology.h"
+#include "MRRingIterator.h"
+#include "MRBitSetParallelFor.h"
+#include "MRRegionBoundary.h"
+#include "MRTorus.h"
+#include "MRMesh.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 
 namespace MR
 {
 
+// adds to the region all vertices within given number of hops from it by level-synchronous breadth-first search,
+// each level is found in parallel either from the frontier vertices (sparse frontier)
+// or by testing the neighbors of all not yet reached vertices (dense frontier)
+static void expandByHops( const MeshTopology & topology, VertBitSet & region, int hops )
+{
+    MR_TIMER
+    if ( region.size() < topology.vertSize() )
+        region.resize( topology.vertSize() );
+    const auto & validVerts = topology.getValidVerts();
+    VertBitSet frontier = region & validVerts;
+    tbb::enumerable_thread_specific<std::vector<VertId>> threadFound;
+    for ( int hop = 0; hop < hops && frontier.any(); ++hop )
+    {
+        VertBitSet next( region.size() );
+        if ( frontier.count() * 32 > size_t( topology.numValidVerts() ) )
+        {
+            // each thread writes only the blocks of the bit-set it iterates over
+            const VertBitSet candidates = validVerts - region;
+            BitSetParallelFor( candidates, [&]( VertId v )
+            {
+                for ( EdgeId e : orgRing( topology, v ) )
+                {
+                    if ( frontier.test( topology.dest( e ) ) )
+                    {
+                        next.set( v );
+                        break;
+                    }
+                }
+            } );
+        }
+        else
+        {
+            BitSetParallelFor( frontier, [&]( VertId u )
+            {
+                auto & found = threadFound.local();
+                for ( EdgeId e : orgRing( topology, u ) )
+                {
+                    const auto v = topology.dest( e );
+                    if ( !region.test( v ) )
+                        found.push_back( v );
+                }
+            } );
+            for ( auto & found : threadFound )
+            {
+                for ( auto v : found )
+                    next.set( v );
+                found.clear();
+            }
+        }
+        region |= next;
+        frontier = std::move( next );
+    }
+}
+
 void expand( const MeshTopology & topology, FaceBitSet & region, int hops )
 {
     assert( hops >= 0 );
     if ( hops <= 0 )
         return;
-    dilateRegionByMetric( topology, identityMetric(), region, hops + 0.5f );
+    auto vertRegion = getIncidentVerts( topology, region );
+    expandByHops( topology, vertRegion, hops );
+    region = getInnerFaces( topology, vertRegion );
 }
 
 FaceBitSet expand( const MeshTopology & topology, FaceId f, int hops )
@@ -28,7 +91,7 @@ void expand( const MeshTopology & topology, VertBitSet & region, int hops )
     assert( hops >= 0 );
     if ( hops <= 0 )
         return;
-    dilateRegionByMetric( topology, identityMetric(), region, hops + 0.5f );
+    expandByHops( topology, region, hops );
 }
 
 VertBitSet expand( const MeshTopology & topology, VertId v, int hops )
@@ -45,7 +108,9 @@ void shrink( const MeshTopology & topology, FaceBitSet & region, int hops )
     assert( hops >= 0 );
     if ( hops <= 0 )
         return;
-    erodeRegionByMetric( topology, identityMetric(), region, hops + 0.5f );
+    region = topology.getValidFaces() - region;
+    expand( topology, region, hops );
+    region = topology.getValidFaces() - region;
 }
 
 void shrink( const MeshTopology & topology, VertBitSet & region, int hops )
@@ -55,8 +120,49 @@ void shrink( const MeshTopology & topology, VertBitSet & region, int hops )
         return;
 
     region = topology.getValidVerts() - region;
-    dilateRegionByMetric( topology, identityMetric(), region, hops + 0.5f );
+    expandByHops( topology, region, hops );
     region = topology.getValidVerts() - region;
 }
 
+TEST( MRMesh, ExpandShrink )
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 48, 48 );
+    const auto & topology = torus.topology;
+    for ( int hops : { 1, 3, 10 } )
+    {
+        VertBitSet verts( topology.vertSize() );
+        verts.set( 0_v );
+        verts.set( 500_v );
+        auto expected = verts;
+        dilateRegionByMetric( topology, identityMetric(), expected, hops + 0.5f );
+        expand( topology, verts, hops );
+        EXPECT_EQ( verts, expected );
+
+        expected = topology.getValidVerts() - verts;
+        dilateRegionByMetric( topology, identityMetric(), expected, hops + 0.5f );
+        expected = topology.getValidVerts() - expected;
+        shrink( topology, verts, hops );
+        EXPECT_EQ( verts, expected );
+
+        auto faces = expand( topology, 0_f, hops );
+        auto expectedFaces = faces;
+        dilateRegionByMetric( topology, identityMetric(), expectedFaces, hops + 0.5f );
+        expand( topology, faces, hops );
+        EXPECT_EQ( faces, expectedFaces );
+
+        erodeRegionByMetric( topology, identityMetric(), expectedFaces, hops + 0.5f );
+        shrink( topology, faces, hops );
+        EXPECT_EQ( faces, expectedFaces );
+    }
+
+    // dense frontier
+    auto half = topology.getValidVerts();
+    for ( VertId v{ 0 }; v < half.size() / 2; ++v )
+        half.reset( v );
+    auto expected = half;
+    dilateRegionByMetric( topology, identityMetric(), expected, 5.5f );
+    expand( topology, half, 5 );
+    EXPECT_EQ( half, expected );
+}
+
 } //namespace MR
@@ -8,6 +8,12 @@
 #include "MRVector2.h"
 #include "MRRingIterator.h"
 #include "MRTimer.h"
+#include "MRBitSetParallelFor.h"
+#include "MRMatrix3.h"
+#include "MRTorus.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
+#include <algorithm>
 
 namespace MR
 {
@@ -23,6 +29,9 @@ public:
     {}
 
     IsoLines extract();
+    // extracts iso-lines passing only via given edges (sorted, they must include all edges crossed by iso-lines);
+    // seen edges are marked in (seen) bit set, which has only these bits cleared on exit to be reused for next extraction
+    IsoLines extract( const std::vector<UndirectedEdgeId> & candidates, UndirectedEdgeBitSet & seen );
 
     IsoLine track( const MeshTriPoint& start, ContinueTrack continueTrack );
 
@@ -63,6 +72,31 @@ IsoLines Isoliner::extract()
     return res;
 }
 
+IsoLines Isoliner::extract( const std::vector<UndirectedEdgeId> & candidates, UndirectedEdgeBitSet & seen )
+{
+    std::swap( seenEdges_, seen );
+    std::vector<std::vector<MeshEdgePoint>> res;
+    for ( auto ue : candidates )
+    {
+        if ( region_ && !contains( *region_, topology_.left( ue ) ) && !contains( *region_, topology_.right( ue ) ) )
+            continue;
+        if ( seenEdges_.test( ue ) )
+            continue;
+        EdgeId e = ue;
+        float vo = valueInVertex_( topology_.org( e ) );
+        float vd = valueInVertex_( topology_.dest( e ) );
+        if ( vo < 0 && 0 <= vd )
+            res.push_back( extractOneLine_( toEdgePoint_( e, vo, vd ) ) );
+        else if ( vd < 0 && 0 <= vo )
+            res.push_back( extractOneLine_( toEdgePoint_( e.sym(), vd, vo ) ) );
+    }
+    for ( auto ue : candidates )
+        seenEdges_.reset( ue );
+    assert( seenEdges_.none() );
+    std::swap( seenEdges_, seen );
+    return res;
+}
+
 IsoLine Isoliner::track( const MeshTriPoint& start, ContinueTrack continueTrack )
 {
     auto testEdge = [&] ( EdgeId e )->std::optional<MeshEdgePoint>
@@ -206,6 +240,126 @@ PlaneSections extractPlaneSections( const MeshPart& mp, const Plane3f& plane )
     return s.extract();
 }
 
+bool sliceMeshLayers( const MeshPart & mp, const Vector3f & direction, const std::vector<float> & heights,
+    const std::function<bool( size_t layer, Contours2f contours )> & callback )
+{
+    MR_TIMER;
+    assert( std::is_sorted( heights.begin(), heights.end() ) );
+    if ( heights.empty() )
+        return true;
+    const auto & topology = mp.mesh.topology;
+    const auto dir = direction.normalized();
+    const auto meshToPlane = AffineXf3f::linear( Matrix3f::rotation( dir, Vector3f::plusZ() ) );
+
+    // the height of each vertex is computed only once for all layers
+    Vector<float, VertId> vertHeights( topology.vertSize() );
+    BitSetParallelFor( topology.getValidVerts(), [&] ( VertId v )
+    {
+        vertHeights[v] = dot( dir, mp.mesh.points[v] );
+    } );
+
+    // the edges crossing at least one layer with the range of their heights
+    struct EdgeSpan
+    {
+        float lo = 0, hi = 0;
+        UndirectedEdgeId ue;
+    };
+    std::vector<EdgeSpan> spans;
+    for ( auto ue : undirectedEdges( topology ) )
+    {
+        if ( mp.region && !contains( *mp.region, topology.left( ue ) ) && !contains( *mp.region, topology.right( ue ) ) )
+            continue;
+        const auto ho = vertHeights[topology.org( ue )];
+        const auto hd = vertHeights[topology.dest( ue )];
+        EdgeSpan span{ std::min( ho, hd ), std::max( ho, hd ), ue };
+        // the edge is crossed by the layer at height z if lo < z <= hi
+        if ( span.lo < heights.back() && span.hi >= heights.front() && span.lo < span.hi )
+            spans.push_back( span );
+    }
+    std::sort( spans.begin(), spans.end(), [] ( const EdgeSpan & a, const EdgeSpan & b ) { return a.lo < b.lo; } );
+
+    // the layers are processed by chunks to limit the memory occupied by not yet passed in the callback contours
+    const size_t layersInChunk = 4 * size_t( tbb::this_task_arena::max_concurrency() );
+    std::vector<EdgeSpan> active;
+    size_t nextSpan = 0;
+    std::vector<size_t> layerFirstEdge;
+    std::vector<UndirectedEdgeId> layerEdges;
+    std::vector<Contours2f> chunkContours;
+    tbb::enumerable_thread_specific<UndirectedEdgeBitSet> threadSeenEdges;
+    for ( size_t chunkBegin = 0; chunkBegin < heights.size(); chunkBegin += layersInChunk )
+    {
+        const size_t chunkEnd = std::min( chunkBegin + layersInChunk, heights.size() );
+        const auto chunkHeightsBegin = heights.begin() + chunkBegin;
+        const auto chunkHeightsEnd = heights.begin() + chunkEnd;
+
+        // update the edges crossing the layers of this chunk
+        while ( nextSpan < spans.size() && spans[nextSpan].lo < *( chunkHeightsEnd - 1 ) )
+            active.push_back( spans[nextSpan++] );
+        active.erase( std::remove_if( active.begin(), active.end(),
+            [z = *chunkHeightsBegin] ( const EdgeSpan & s ) { return s.hi < z; } ), active.end() );
+
+        // distribute them among the layers: edge crosses the layers from the first with z > lo till the first with z > hi
+        layerFirstEdge.assign( chunkEnd - chunkBegin + 1, 0 );
+        for ( const auto & s : active )
+        {
+            const auto b = std::upper_bound( chunkHeightsBegin, chunkHeightsEnd, s.lo ) - chunkHeightsBegin;
+            const auto e = std::upper_bound( chunkHeightsBegin, chunkHeightsEnd, s.hi ) - chunkHeightsBegin;
+            for ( auto k = b; k < e; ++k )
+                ++layerFirstEdge[k + 1];
+        }
+        for ( size_t k = 0; k + 1 < layerFirstEdge.size(); ++k )
+            layerFirstEdge[k + 1] += layerFirstEdge[k];
+        layerEdges.resize( layerFirstEdge.back() );
+        auto layerNextEdge = layerFirstEdge;
+        for ( const auto & s : active )
+        {
+            const auto b = std::upper_bound( chunkHeightsBegin, chunkHeightsEnd, s.lo ) - chunkHeightsBegin;
+            const auto e = std::upper_bound( chunkHeightsBegin, chunkHeightsEnd, s.hi ) - chunkHeightsBegin;
+            for ( auto k = b; k < e; ++k )
+                layerEdges[layerNextEdge[k]++] = s.ue;
+        }
+
+        chunkContours.clear();
+        chunkContours.resize( chunkEnd - chunkBegin );
+        tbb::parallel_for( tbb::blocked_range<size_t>( chunkBegin, chunkEnd, 1 ), [&] ( const tbb::blocked_range<size_t>& range )
+        {
+            auto & seen = threadSeenEdges.local();
+            seen.resize( topology.undirectedEdgeSize() );
+            std::vector<UndirectedEdgeId> candidates;
+            for ( size_t layer = range.begin(); layer < range.end(); ++layer )
+            {
+                const auto k = layer - chunkBegin;
+                // the same order of edges as in extractPlaneSections gives the same contours
+                candidates.assign( layerEdges.begin() + layerFirstEdge[k], layerEdges.begin() + layerFirstEdge[k + 1] );
+                std::sort( candidates.begin(), candidates.end() );
+                const auto z = heights[layer];
+                Isoliner s( topology, [&] ( VertId v )
+                {
+                    return vertHeights[v] - z;
+                }, mp.region );
+                chunkContours[k] = planeSectionsToContours2f( mp.mesh, s.extract( candidates, seen ), meshToPlane );
+            }
+        } );
+
+        for ( size_t k = 0; k < chunkContours.size(); ++k )
+            if ( !callback( chunkBegin + k, std::move( chunkContours[k] ) ) )
+                return false;
+    }
+    return true;
+}
+
+std::vector<Contours2f> sliceMeshLayers( const MeshPart & mp, const Vector3f & direction, const std::vector<float> & heights )
+{
+    MR_TIMER;
+    std::vector<Contours2f> res( heights.size() );
+    sliceMeshLayers( mp, direction, heights, [&] ( size_t layer, Contours2f contours )
+    {
+        res[layer] = std::move( contours );
+        return true;
+    } );
+    return res;
+}
+
 PlaneSection trackSection( const MeshPart& mp,
     const MeshTriPoint& start, MeshTriPoint& end, const Vector3f& direction, float distance )
 {
@@ -289,4 +443,34 @@ Contours2f planeSectionsToContours2f( const Mesh& mesh, const PlaneSections& sec
     return res;
 }
 
+TEST( MRMesh, SliceMeshLayers )
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 32, 32 );
+    const Vector3f dir = Vector3f( 0.1f, 0.2f, 1.0f ).normalized();
+    std::vector<float> heights;
+    for ( int i = 0; i <= 100; ++i )
+        heights.push_back( -1.5f + 0.03f * i );
+
+    const auto layers = sliceMeshLayers( torus, dir, heights );
+    ASSERT_EQ( layers.size(), heights.size() );
+    const auto meshToPlane = AffineXf3f::linear( Matrix3f::rotation( dir, Vector3f::plusZ() ) );
+    for ( size_t i = 0; i < heights.size(); ++i )
+    {
+        const auto sections = extractPlaneSections( torus, Plane3f( dir, heights[i] ) );
+        EXPECT_EQ( planeSectionsToContours2f( torus, sections, meshToPlane ), layers[i] );
+    }
+    EXPECT_TRUE( layers.front().empty() );
+    EXPECT_EQ( layers[50].size(), 2 );
+
+    // streaming stops as soon as the callback returns false
+    size_t numReceived = 0;
+    EXPECT_FALSE( sliceMeshLayers( torus, dir, heights, [&] ( size_t layer, Contours2f )
+    {
+        EXPECT_EQ( layer, numReceived );
+        ++numReceived;
+        return layer < 10;
+    } ) );
+    EXPECT_EQ( numReceived, 11 );
+}
+
 } //namespace MR
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MRMeshFwd.h"
+#include <functional>
 
 namespace MR
 {
@@ -18,6 +19,17 @@ MRMESH_API IsoLines extractIsolines( const MeshTopology & topology,
 // extracts all plane sections of given mesh
 MRMESH_API PlaneSections extractPlaneSections( const MeshPart & mp, const Plane3f & plane );
 
+/// extracts the sections of given mesh by the planes orthogonal to (direction) at all given (heights) along it (sorted ascending),
+/// each layer gives the same contours as planeSectionsToContours2f( extractPlaneSections ) with the rotation of (direction) in OZ axis;
+/// the vertex heights are computed only once, each layer visits only the edges crossing it, and the layers are processed in parallel
+MRMESH_API std::vector<Contours2f> sliceMeshLayers( const MeshPart & mp, const Vector3f & direction, const std::vector<float> & heights );
+
+/// same as above but passes the contours of each layer in the callback (in the order of heights) instead of keeping all of them in memory,
+/// the callback is called from one thread at a time, and the slicing stops as soon as the callback returns false
+/// \return false if the slicing was stopped by the callback
+MRMESH_API bool sliceMeshLayers( const MeshPart & mp, const Vector3f & direction, const std::vector<float> & heights,
+    const std::function<bool( size_t layer, Contours2f contours )> & callback );
+
 /// track section of plane set by start point, direction and surface normal in start point 
 /// in given direction while given distance or
 /// mesh boundary is not reached, or track looped
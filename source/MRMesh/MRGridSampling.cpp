@@ -5,9 +5,12 @@
 #include "MRPointCloud.h"
 #include "MRRegionBoundary.h"
 #include "MRVolumeIndexer.h"
+#include "MRBitSetParallelFor.h"
+#include "MRphmap.h"
 #include "MRTimer.h"
 #include "MRUVSphere.h"
 #include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 
 namespace MR
 {
@@ -16,6 +19,11 @@ struct GridElement
 {
     VertId vid;
     float centerDistSq = FLT_MAX;
+
+    // the point closer to voxel center is preferred, and among equally close points - the one with smaller id,
+    // so the result does not depend on the order of addition
+    bool betterThan( const GridElement & other ) const
+        { return centerDistSq < other.centerDistSq || ( centerDistSq == other.centerDistSq && vid < other.vid ); }
 };
 
 class Grid : public VolumeIndexer
@@ -26,8 +34,8 @@ public:
     Vector3i pointPos( const Vector3f & p ) const;
     // finds center of given voxel
     Vector3f voxelCenter( const Vector3i & pos ) const;
-    // if given point is closer to the center of its voxel, then it is remembered
-    void addVertex( const Vector3f & p, VertId vid );
+    // adds in parallel given points, each one is remembered if it is closer to the center of its voxel than previous ones
+    void addVertices( const VertCoords & points, const VertBitSet & verts );
     // returns all sampled points after addition
     VertBitSet getSamples() const;
 
@@ -35,14 +43,14 @@ private:
     Box3f box_; 
     Vector3f voxelSize_;
     Vector3f recipVoxelSize_;
-    std::vector<GridElement> voxels_;
+    // only occupied voxels are stored
+    HashMap<VoxelId, GridElement> voxels_;
 };
 
 Grid::Grid( const Box3f & box, const Vector3i & dims )
     : VolumeIndexer( dims )
     , box_( box )
 {
-    voxels_.resize( size_ );
     const auto boxSz = box.max - box.min;
     voxelSize_.x = boxSz.x / dims.x;
     voxelSize_.y = boxSz.y / dims.y;
@@ -72,26 +80,40 @@ inline Vector3f Grid::voxelCenter( const Vector3i & pos ) const
     };
 }
 
-void Grid::addVertex( const Vector3f & p, VertId vid )
+void Grid::addVertices( const VertCoords & points, const VertBitSet & verts )
 {
-    const auto pos = pointPos( p );
-    auto & ge = voxels_[ toVoxelId( pos ) ];
-    const auto distSq = ( p - voxelCenter( pos ) ).lengthSq();
-    if ( distSq < ge.centerDistSq )
+    MR_TIMER
+    // each thread bins its points in own map
+    tbb::enumerable_thread_specific<HashMap<VoxelId, GridElement>> threadVoxels;
+    BitSetParallelFor( verts, [&]( VertId vid )
+    {
+        const auto & p = points[vid];
+        const auto pos = pointPos( p );
+        const GridElement candidate{ vid, ( p - voxelCenter( pos ) ).lengthSq() };
+        auto & ge = threadVoxels.local()[ toVoxelId( pos ) ];
+        if ( candidate.betterThan( ge ) )
+            ge = candidate;
+    } );
+
+    for ( const auto & tv : threadVoxels )
     {
-        ge.centerDistSq = distSq;
-        ge.vid = vid;
+        for ( const auto & [voxel, candidate] : tv )
+        {
+            auto & ge = voxels_[voxel];
+            if ( candidate.betterThan( ge ) )
+                ge = candidate;
+        }
     }
 }
 
 VertBitSet Grid::getSamples() const
 {
     VertId maxId;
-    for ( const auto & ge : voxels_ )
+    for ( const auto & [voxel, ge] : voxels_ )
         maxId = std::max( maxId, ge.vid );
 
     VertBitSet res( (size_t)maxId + 1 );
-    for ( const auto & ge : voxels_ )
+    for ( const auto & [voxel, ge] : voxels_ )
         if ( ge.vid )
             res.set( ge.vid );
 
@@ -121,16 +143,9 @@ VertBitSet verticesGridSampling( const MeshPart & mp, float voxelSize )
 
     Grid grid( bbox, dims );
     if ( mp.region )
-    {
-        VertBitSet regionVerts = getIncidentVerts( mp.mesh.topology, *mp.region );
-        for ( auto v : regionVerts )
-            grid.addVertex( mp.mesh.points[v], v );
-    }
+        grid.addVertices( mp.mesh.points, getIncidentVerts( mp.mesh.topology, *mp.region ) );
     else
-    {
-        for ( auto v : mp.mesh.topology.getValidVerts() )
-            grid.addVertex( mp.mesh.points[v], v );
-    }
+        grid.addVertices( mp.mesh.points, mp.mesh.topology.getValidVerts() );
 
     return grid.getSamples();
 }
@@ -152,8 +167,7 @@ VertBitSet pointGridSampling( const PointCloud & cloud, float voxelSize )
     };
 
     Grid grid( bbox, dims );
-    for ( auto v : cloud.validPoints )
-        grid.addVertex( cloud.points[v], v );
+    grid.addVertices( cloud.points, cloud.validPoints );
 
     return grid.getSamples();
 }
@@ -165,6 +179,28 @@ TEST( MRMesh, GridSampling )
     auto samples = verticesGridSampling( sphereMesh, 0.5f );
     auto sampleCount = samples.count();
     EXPECT_LE( sampleCount, numVerts );
+
+    // the same as serial addition of vertices in the order of their ids
+    const float voxelSize = 0.1f;
+    const auto bbox = sphereMesh.computeBoundingBox();
+    const auto bboxSz = bbox.max - bbox.min;
+    const Vector3i dims{ (int)std::ceil( bboxSz.x / voxelSize ), (int)std::ceil( bboxSz.y / voxelSize ), (int)std::ceil( bboxSz.z / voxelSize ) };
+    const Grid grid( bbox, dims );
+    HashMap<VoxelId, GridElement> voxels;
+    for ( auto v : sphereMesh.topology.getValidVerts() )
+    {
+        const auto pos = grid.pointPos( sphereMesh.points[v] );
+        const auto distSq = ( sphereMesh.points[v] - grid.voxelCenter( pos ) ).lengthSq();
+        auto & ge = voxels[grid.toVoxelId( pos )];
+        if ( distSq < ge.centerDistSq )
+            ge = { v, distSq };
+    }
+    VertBitSet expected( sphereMesh.topology.vertSize() );
+    for ( const auto & [voxel, ge] : voxels )
+        expected.set( ge.vid );
+    samples = verticesGridSampling( sphereMesh, voxelSize );
+    samples.resize( expected.size() );
+    EXPECT_EQ( samples, expected );
 }
 
 } //namespace MR
@@ -52,6 +52,11 @@ public:
     /// Returns the name of last undo or redo action (or empty string if there is no such action)
     MRMESH_API std::string getLastActionName( HistoryAction::Type type ) const;
 
+    /// Returns all actions of main history stack
+    const HistoryActionsVector& getStack() const { return stack_; }
+    /// Returns the index of first redo action in the stack (or stack size if no redo is available)
+    size_t getStackPointer() const { return firstRedoIndex_; }
+
     /// Signal is called after this store changed
     enum class ChangeType
     {
@@ -1,37 +1,56 @@
 #include "MRICP.h"
 #include "MRMesh.h"
 #include "MRMeshNormals.h"
-#include "MRGridSampling.h"
+#include "MRPointCloud.h"
+#include "MRPointCloudMakeNormals.h"
 #include "MRTimer.h"
 #include "MRBox.h"
 #include "MRQuaternion.h"
+#include "MRTorus.h"
 #include "MRGTest.h"
 #include "MRPch/MRTBB.h"
+#include <chrono>
 #include <numeric>
 
 const int MAX_RESAMPLING_VOXEL_NUMBER = 500000;
 namespace MR
 {
 
-MeshICP::MeshICP(const MeshPart& floatingMesh, const MeshPart& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
+MeshICP::MeshICP(const MeshOrPoints& floatingMesh, const MeshOrPoints& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
     const VertBitSet& floatingMeshBitSet)
-    : meshPart_( floatingMesh )
-    , refPart_( referenceMesh )
+    : flt_( floatingMesh )
+    , ref_( referenceMesh )
 {
+    computeMissingNormals_();
     setXfs( fltMeshXf, refMeshXf );
     bitSet_ = floatingMeshBitSet;
     updateVertPairs();
 }
 
-MeshICP::MeshICP(const MeshPart& floatingMesh, const MeshPart& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
+MeshICP::MeshICP(const MeshOrPoints& floatingMesh, const MeshOrPoints& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
     float floatSamplingVoxelSize )
-    : meshPart_( floatingMesh )
-    , refPart_( referenceMesh )
+    : flt_( floatingMesh )
+    , ref_( referenceMesh )
 {
+    computeMissingNormals_();
     setXfs( fltMeshXf, refMeshXf );
     recomputeBitSet(floatSamplingVoxelSize);
 }
 
+void MeshICP::computeMissingNormals_()
+{
+    if ( !flt_.hasNormals() )
+    {
+        fltNormals_ = std::make_unique<VertCoords>( makeNormals( *flt_.asPointCloud() ) );
+        flt_.setPointNormals( fltNormals_.get() );
+    }
+    if ( !ref_.hasNormals() )
+    {
+        refNormals_ = std::make_unique<VertCoords>( makeNormals( *ref_.asPointCloud() ) );
+        ref_.setPointNormals( refNormals_.get() );
+    }
+}
+
 void MeshICP::setXfs( const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf )
 {
     refXf_ = refMeshXf;
@@ -41,12 +60,13 @@ void MeshICP::setXfs( const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf )
 
 void MeshICP::recomputeBitSet(const float floatSamplingVoxelSize)
 {
-    auto bboxDiag = meshPart_.mesh.computeBoundingBox( meshPart_.region ).size() / floatSamplingVoxelSize;
+    auto bboxDiag = flt_.computeBoundingBox().size() / floatSamplingVoxelSize;
     auto nSamples = bboxDiag[0] * bboxDiag[1] * bboxDiag[2];
     if (nSamples > MAX_RESAMPLING_VOXEL_NUMBER)
-        bitSet_ = verticesGridSampling( meshPart_, floatSamplingVoxelSize * std::cbrt(float(nSamples) / float(MAX_RESAMPLING_VOXEL_NUMBER)) );
+        samplingVoxelSize_ = floatSamplingVoxelSize * std::cbrt(float(nSamples) / float(MAX_RESAMPLING_VOXEL_NUMBER));
     else
-        bitSet_ = verticesGridSampling( meshPart_, floatSamplingVoxelSize );
+        samplingVoxelSize_ = floatSamplingVoxelSize;
+    bitSet_ = flt_.gridSampling( samplingVoxelSize_ );
 
     updateVertPairs();
 }
@@ -56,7 +76,7 @@ void MeshICP::updateVertPairs()
     MR_TIMER;
     const auto& actualBitSet = bitSet_;
 
-    const VertCoords& points = meshPart_.mesh.points;
+    const VertCoords& points = flt_.points();
     if (!prop_.freezePairs)
     {
         vertPairs_.clear();
@@ -72,6 +92,10 @@ void MeshICP::updateVertPairs()
         }
     }
 
+    if ( lastRefElems_.size() < points.size() )
+        lastRefElems_.resize( points.size(), -1 );
+    const auto fltToRefXf = refXfInv_ * xf_;
+
     // calculate pairs
     tbb::parallel_for(tbb::blocked_range<size_t>(0, vertPairs_.size()),
         [&](const tbb::blocked_range<size_t>& range)
@@ -80,17 +104,21 @@ void MeshICP::updateVertPairs()
             {
                 VertPair& vp = vertPairs_[idx];
                 auto& id = vp.vertId;
-                const auto& p = points[id];
-                MeshProjectionResult mp = findProjection( (refXfInv_ * xf_)(p), refPart_ );
+
+                // warm start: the distance to the reference element found on previous update limits the search,
+                // since the point moves only slightly between iterations, most of the tree is pruned
+                auto& lastElem = lastRefElems_[id];
+                const auto prj = ref_.project( fltToRefXf( points[id] ), lastElem );
+                lastElem = prj.elem;
 
                 // projection should be found and if point projects on the border it will be ignored
-                if ( !mp.mtp.isBd( refPart_.mesh.topology ) )
+                if ( prj.elem >= 0 && !prj.isBd )
                 {
-                    vp.vertDist2 = mp.distSq;
-                    vp.weight = meshPart_.mesh.dblArea(id);
-                    vp.refPoint = refXf_(mp.proj.point);
-                    vp.norm = xf_.A * meshPart_.mesh.normal(id);
-                    vp.normRef = refXf_.A * refPart_.mesh.normal(mp.proj.face);
+                    vp.vertDist2 = prj.distSq;
+                    vp.weight = flt_.weight(id);
+                    vp.refPoint = refXf_(prj.point);
+                    vp.norm = xf_.A * flt_.normal(id);
+                    vp.normRef = refXf_.A * prj.normal;
                     vp.normalsAngleCos = dot((vp.normRef), (vp.norm));
                 }
                 else
@@ -101,6 +129,7 @@ void MeshICP::updateVertPairs()
         });
 
     removeInvalidVertPairs_();
+    orientComputedNormals_();
 
     if (!prop_.freezePairs)
     {
@@ -108,6 +137,31 @@ void MeshICP::updateVertPairs()
     }
 }
 
+void MeshICP::orientComputedNormals_()
+{
+    // makeNormals orients the normals consistently with each other, but their common sign is arbitrary,
+    // and the pairs with opposite normals would be rejected by the cos filter
+    VertCoords* computed = fltNormals_ ? fltNormals_.get() : refNormals_.get();
+    if ( !computed || vertPairs_.empty() )
+        return;
+    double sumCos = 0;
+    for ( const auto& vp : vertPairs_ )
+        sumCos += vp.normalsAngleCos;
+    if ( sumCos >= 0 )
+        return;
+
+    for ( auto& n : *computed )
+        n = -n;
+    for ( auto& vp : vertPairs_ )
+    {
+        if ( fltNormals_ )
+            vp.norm = -vp.norm;
+        else
+            vp.normRef = -vp.normRef;
+        vp.normalsAngleCos = -vp.normalsAngleCos;
+    }
+}
+
 void MeshICP::removeInvalidVertPairs_()
 {
     // remove border and unprojected cases pairs
@@ -170,7 +224,7 @@ std::pair<float,float> MeshICP::getDistLimitsSq() const
 bool MeshICP::p2ptIter_()
 {
     MR_TIMER;
-    const VertCoords& points = meshPart_.mesh.points;
+    const VertCoords& points = flt_.points();
     for (const auto& vp : vertPairs_)
     {
         const auto& id = vp.vertId;
@@ -199,7 +253,7 @@ bool MeshICP::p2ptIter_()
 bool MeshICP::p2plIter_()
 {
     MR_TIMER;
-    const VertCoords& points = meshPart_.mesh.points;
+    const VertCoords& points = flt_.points();
     Vector3f centroidRef;
     for (auto& vp : vertPairs_)
     {
@@ -269,6 +323,29 @@ bool MeshICP::p2plIter_()
 }
 
 AffineXf3f MeshICP::calculateTransformation()
+{
+    MR_TIMER;
+    iterInfos_.clear();
+    // frozen pairs cannot be resampled, and the sampling of user given bitset is unknown
+    const int levels = ( samplingVoxelSize_ > 0 && !prop_.freezePairs ) ? std::max( prop_.multiresLevels, 1 ) : 1;
+    if ( levels > 1 )
+    {
+        // coarse levels quickly find approximate transformation using few samples
+        const auto fineBitSet = bitSet_;
+        for ( int level = levels - 1; level > 0; --level )
+        {
+            bitSet_ = flt_.gridSampling( samplingVoxelSize_ * float( 1 << level ) );
+            updateVertPairs();
+            iterate_( level );
+        }
+        bitSet_ = fineBitSet;
+        updateVertPairs();
+    }
+    iterate_( 0 );
+    return xf_;
+}
+
+void MeshICP::iterate_( int level )
 {
     float curDist = 0;
     float minDist = std::numeric_limits<float>::max();
@@ -276,6 +353,12 @@ AffineXf3f MeshICP::calculateTransformation()
     resultType_ = ExitType::NotStarted;
     for (iter_ = 0; iter_ < prop_.iterLimit; iter_++)
     {
+        const auto iterStart = std::chrono::high_resolution_clock::now();
+        auto addIterInfo = [&]()
+        {
+            const std::chrono::duration<double> passed = std::chrono::high_resolution_clock::now() - iterStart;
+            iterInfos_.push_back( { level, vertPairs_.size(), curDist, passed.count() } );
+        };
         if (prop_.method == ICPMethod::Combined)
         {
             if (iter_ < 2)
@@ -287,6 +370,7 @@ AffineXf3f MeshICP::calculateTransformation()
                 }
                 updateVertPairs();
                 curDist = getMeanSqDistToPoint();
+                addIterInfo();
             }
             else
             {
@@ -297,6 +381,7 @@ AffineXf3f MeshICP::calculateTransformation()
                 }
                 updateVertPairs();
                 curDist = getMeanSqDistToPlane();
+                addIterInfo();
                 if ( prop_.exitVal > curDist )
                 {
                     resultType_ = ExitType::StopMsdReached;
@@ -314,6 +399,7 @@ AffineXf3f MeshICP::calculateTransformation()
             }
             updateVertPairs();
             curDist = getMeanSqDistToPoint();
+            addIterInfo();
             if ( prop_.exitVal > curDist )
             {
                 resultType_ = ExitType::StopMsdReached;
@@ -330,6 +416,7 @@ AffineXf3f MeshICP::calculateTransformation()
             }
             updateVertPairs();
             curDist = getMeanSqDistToPlane();
+            addIterInfo();
             if ( prop_.exitVal > curDist )
             {
                 resultType_ = ExitType::StopMsdReached;
@@ -355,7 +442,6 @@ AffineXf3f MeshICP::calculateTransformation()
     }
     if ( iter_ == prop_.iterLimit )
         resultType_ = ExitType::MaxIterations;
-    return xf_;
 }
 
 float MeshICP::getMeanSqDistToPoint() const
@@ -374,7 +460,7 @@ float MeshICP::getMeanSqDistToPlane() const
 {
     if ( vertPairs_.empty() )
         return 0;
-    const VertCoords& points = meshPart_.mesh.points;
+    const VertCoords& points = flt_.points();
     double sum = 0;
     for (const auto& vp : vertPairs_)
     {
@@ -386,7 +472,7 @@ float MeshICP::getMeanSqDistToPlane() const
 
 Vector3f MeshICP::getShiftVector() const
 {
-    const VertCoords& points = meshPart_.mesh.points;
+    const VertCoords& points = flt_.points();
     Vector3f vecAcc{ 0.f,0.f,0.f };
     for (const auto& vp : vertPairs_)
     {
@@ -447,6 +533,15 @@ std::string MeshICP::getLastICPInfo() const
         result = "ICP hasn't started yet.";
         break;
     }
+    for ( int i = 0; i < iterInfos_.size(); ++i )
+    {
+        const auto& info = iterInfos_[i];
+        result += "\nIteration " + std::to_string( i + 1 );
+        if ( info.level > 0 )
+            result += " (level " + std::to_string( info.level ) + ")";
+        result += ": " + std::to_string( info.numPairs ) + " pairs, deviation " + std::to_string( info.dist ) +
+            ", " + std::to_string( int( info.seconds * 1000 ) ) + " ms";
+    }
     return result;
 }
 
@@ -655,4 +750,74 @@ TEST(MRMesh, RegistrationOneIterPointToPoint)
     }
 }
 
+TEST(MRMesh, RegistrationMultiresolution)
+{
+    const Mesh ref = makeTorus( 1.0f, 0.3f, 64, 32 );
+    const AffineXf3f fltXf( Matrix3f::rotation( Vector3f( 1, 1, 0 ).normalized(), 0.05f ), Vector3f( 0.03f, -0.02f, 0.01f ) );
+
+    MeshICP icp( ref, ref, fltXf, AffineXf3f(), 0.02f );
+    auto prop = icp.getParams();
+    prop.multiresLevels = 3;
+    prop.iterLimit = 20;
+    icp.setParams( prop );
+    const auto xf = icp.calculateTransformation();
+
+    EXPECT_LT( icp.getMeanSqDistToPoint(), 1e-3f );
+    // torus center is invariant to the rotation around its axis
+    EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+    EXPECT_NE( icp.getLastICPInfo().find( "level 2" ), std::string::npos );
+}
+
+TEST(MRMesh, RegistrationPointClouds)
+{
+    const Mesh mesh = makeTorus( 1.0f, 0.3f, 64, 32 );
+    PointCloud cloud; // without normals
+    for ( auto v : mesh.topology.getValidVerts() )
+        cloud.addPoint( mesh.points[v] );
+    const AffineXf3f fltXf( Matrix3f::rotation( Vector3f( 1, 1, 0 ).normalized(), 0.05f ), Vector3f( 0.03f, -0.02f, 0.01f ) );
+
+    // point cloud to mesh
+    MeshICP icpToMesh( cloud, mesh, fltXf, AffineXf3f(), 0.02f );
+    auto xf = icpToMesh.calculateTransformation();
+    EXPECT_LT( icpToMesh.getMeanSqDistToPlane(), 1e-3f );
+    EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+
+    // point cloud to point cloud
+    MeshICP icpToCloud( cloud, cloud, fltXf, AffineXf3f(), 0.02f );
+    xf = icpToCloud.calculateTransformation();
+    EXPECT_LT( icpToCloud.getMeanSqDistToPoint(), 1e-3f );
+    EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+}
+
+TEST(MRMesh, RegistrationPointCloudsFlippedNormals)
+{
+    Mesh mesh = makeTorus( 1.0f, 0.3f, 64, 32 );
+    PointCloud cloud; // without normals
+    for ( auto v : mesh.topology.getValidVerts() )
+        cloud.addPoint( mesh.points[v] );
+    const AffineXf3f fltXf( Matrix3f::rotation( Vector3f( 1, 1, 0 ).normalized(), 0.05f ), Vector3f( 0.03f, -0.02f, 0.01f ) );
+
+    // the computed normals of the cloud are opposite to the normals of the mesh in one of two orientations
+    for ( int i = 0; i < 2; ++i )
+    {
+        MeshICP icp( cloud, mesh, fltXf, AffineXf3f(), 0.02f );
+        EXPECT_GT( icp.getVertPairs().size(), 100 );
+        const auto xf = icp.calculateTransformation();
+        EXPECT_LT( icp.getMeanSqDistToPlane(), 1e-3f );
+        EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+        mesh.topology.flipOrientation();
+    }
+
+    // reference cloud with given normals opposite to the computed ones
+    PointCloud flipped = cloud;
+    flipped.normals = makeNormals( cloud );
+    for ( auto& n : flipped.normals )
+        n = -n;
+    MeshICP icp( cloud, flipped, fltXf, AffineXf3f(), 0.02f );
+    EXPECT_GT( icp.getVertPairs().size(), 100 );
+    const auto xf = icp.calculateTransformation();
+    EXPECT_LT( icp.getMeanSqDistToPoint(), 1e-3f );
+    EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+}
+
 }
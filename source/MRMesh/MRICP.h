@@ -3,6 +3,7 @@
 #include "MRAligningTransform.h"
 #include "MRVector3.h"
 #include "MRMesh.h"
+#include "MRMeshOrPoints.h"
 #include "MRId.h"
 
 namespace MR
@@ -62,6 +63,10 @@ struct ICPProperties
     Vector3f fixedRotationAxis;
     // keep point pairs from first iteration
     bool freezePairs = false;
+    // number of sampling levels in coarse-to-fine mode: the iterations start on floating mesh samples
+    // with the voxel size multiplied by 2^(multiresLevels-1), and it is halved on each next level;
+    // works only if the sampling voxel size is known (MeshICP is constructed with floatSamplingVoxelSize or recomputeBitSet was called)
+    int multiresLevels = 1;
 
     // parameters of iterative call
     int iterLimit = 10; // maximum iterations
@@ -71,7 +76,9 @@ struct ICPProperties
     float exitVal = 0; // [distance]
 };
 
-// This class allows to match two meshes with almost same geometry throw ICP point-to-point or point-to-plane algorithms
+// This class allows to match two meshes with almost same geometry throw ICP point-to-point or point-to-plane algorithms;
+// any of the objects can be a point cloud as well, then the normals of points are taken from the cloud or computed by makeNormals if it has none;
+// the common sign of computed normals is chosen on each update of pairs to agree with the normals of the other object
 class MeshICP
 {
 public:
@@ -80,9 +87,9 @@ public:
     // refMeshXf transform from the local refMesh basis to the global
     // calculateTransform returns new mesh transformation to the global frame, which matches refMesh in the global frame
     // bitset allows to take exact set of vertices from the mesh
-    MRMESH_API MeshICP(const MeshPart& floatingMesh, const MeshPart& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
+    MRMESH_API MeshICP(const MeshOrPoints& floatingMesh, const MeshOrPoints& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
         const VertBitSet& floatingMeshBitSet);
-    MRMESH_API MeshICP(const MeshPart& floatingMesh, const MeshPart& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
+    MRMESH_API MeshICP(const MeshOrPoints& floatingMesh, const MeshOrPoints& referenceMesh, const AffineXf3f& fltMeshXf, const AffineXf3f& refMeshXf,
         float floatSamplingVoxelSize ); // positive value here defines voxel size, and only one vertex per voxel will be selected
     // TODO: add single transform constructor
 
@@ -111,12 +118,12 @@ public:
 
 private:
     // input meshes variables
-    MeshPart meshPart_;
+    MeshOrPoints flt_;
     AffineXf3f xf_;
     
     VertBitSet bitSet_; // region of interests on the floating mesh
     
-    MeshPart refPart_;
+    MeshOrPoints ref_;
     AffineXf3f refXf_;
     AffineXf3f refXfInv_; // optimized for reference points transformation
 
@@ -126,6 +133,24 @@ private:
 
     std::vector<VertPair> vertPairs_;
 
+    // voxel size of current sampling of the floating mesh, 0 if the samples were given by the user
+    float samplingVoxelSize_ = 0;
+    // normals computed for the point clouds without own normals
+    std::unique_ptr<VertCoords> fltNormals_, refNormals_;
+    // the reference face or point (see MeshOrPoints::ProjectionResult::elem) found for each floating vertex on previous update of pairs,
+    // the distance to it bounds the search of the closest point on next update
+    Vector<int, VertId> lastRefElems_;
+
+    // statistics of one iteration
+    struct IterInfo
+    {
+        int level = 0; // sampling level in coarse-to-fine mode, 0 is the finest
+        size_t numPairs = 0; // number of point pairs after the iteration
+        float dist = 0; // root-mean-square deviation after the iteration
+        double seconds = 0; // iteration time
+    };
+    std::vector<IterInfo> iterInfos_;
+
     // types of exit conditions in calculation
     enum class ExitType {
         NotStarted, // calculation is not started yet
@@ -136,11 +161,17 @@ private:
     };
     ExitType resultType_{ ExitType::NotStarted };
 
+    void computeMissingNormals_();
+    // flips the computed normals if they disagree with the normals of the other object in the most of current pairs
+    void orientComputedNormals_();
+
     void removeInvalidVertPairs_();
 
     void updateVertFilters_();
 
     int iter_ = 0;
+    // performs iterations on current sampling of the floating mesh
+    void iterate_( int level );
     bool p2ptIter_();
     bool p2plIter_();
 };
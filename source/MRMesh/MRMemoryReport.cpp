@@ -0,0 +1,330 @@
+#include "MRMemoryReport.h"
+#include "MRObjectMeshHolder.h"
+#include "MRObjectPointsHolder.h"
+#include "MRObjectLinesHolder.h"
+#include "MRObjectDistanceMap.h"
+#include "MRObjectMesh.h"
+#include "MRSceneRoot.h"
+#include "MRHistoryStore.h"
+#include "MRCombinedHistoryAction.h"
+#include "MRChangeMeshAction.h"
+#include "MRMesh.h"
+#include "MRMeshNormals.h"
+#include "MRAABBTree.h"
+#include "MRAABBTreePoints.h"
+#include "MRAABBTreePolyline.h"
+#include "MRPointCloud.h"
+#include "MRPolyline.h"
+#include "MRDistanceMap.h"
+#include "MRHeapBytes.h"
+#include "MRUVSphere.h"
+#include "MRStringConvert.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRSpdlog.h"
+#include <unordered_set>
+
+namespace MR
+{
+
+const char* asString( MemoryKind kind )
+{
+    constexpr const char* names[] =
+    {
+        "points",
+        "topology",
+        "attributes",
+        "caches",
+        "render buffers",
+        "history",
+        "other"
+    };
+    static_assert( std::size( names ) == size_t( MemoryKind::Count ) );
+    return names[int( kind )];
+}
+
+namespace
+{
+
+MemoryReportNode component( std::string name, MemoryKind kind, size_t bytes )
+{
+    MemoryReportNode res;
+    res.name = std::move( name );
+    res.kind = kind;
+    res.bytes = bytes;
+    return res;
+}
+
+template<typename T>
+size_t cacheBytes( const T* cache )
+{
+    return cache ? sizeof( T ) + cache->heapBytes() : 0;
+}
+
+void addChild( MemoryReportNode& parent, MemoryReportNode child )
+{
+    if ( child.bytes == 0 && !child.shared )
+        return;
+    parent.bytes += child.bytes;
+    parent.children.push_back( std::move( child ) );
+}
+
+MemoryReportNode meshComponents( const Mesh& mesh )
+{
+    MemoryReportNode res;
+    addChild( res, component( "points", MemoryKind::Points, mesh.points.heapBytes() ) );
+    addChild( res, component( "topology", MemoryKind::Topology, mesh.topology.heapBytes() ) );
+    addChild( res, component( "AABB tree", MemoryKind::Caches, cacheBytes( mesh.getAABBTreeNotCreate() ) ) );
+    addChild( res, component( "normals", MemoryKind::Caches, cacheBytes( mesh.getNormalsNotCreate() ) ) );
+    return res;
+}
+
+MemoryReportNode pointCloudComponents( const PointCloud& pointCloud )
+{
+    MemoryReportNode res;
+    addChild( res, component( "points", MemoryKind::Points, pointCloud.points.heapBytes() ) );
+    addChild( res, component( "normals", MemoryKind::Points, pointCloud.normals.heapBytes() ) );
+    addChild( res, component( "valid points", MemoryKind::Topology, pointCloud.validPoints.heapBytes() ) );
+    addChild( res, component( "AABB tree", MemoryKind::Caches, cacheBytes( pointCloud.getAABBTreeNotCreate() ) ) );
+    return res;
+}
+
+MemoryReportNode polylineComponents( const Polyline3& polyline )
+{
+    MemoryReportNode res;
+    addChild( res, component( "points", MemoryKind::Points, polyline.points.heapBytes() ) );
+    addChild( res, component( "topology", MemoryKind::Topology, polyline.topology.heapBytes() ) );
+    addChild( res, component( "AABB tree", MemoryKind::Caches, cacheBytes( polyline.getAABBTreeNotCreate() ) ) );
+    return res;
+}
+
+class MemoryReporter
+{
+public:
+    MemoryReportNode object( const Object& obj );
+
+private:
+    /// adds the node of the data owned by shared pointer, which is reported only once if it is shared by several objects;
+    /// returns the size of the data which is really occupied (even if it is not counted here)
+    template<typename T, typename F>
+    size_t addSharedData_( MemoryReportNode& parent, std::string name, const std::shared_ptr<T>& data, F&& components );
+
+    std::unordered_set<const void*> visited_;
+};
+
+template<typename T, typename F>
+size_t MemoryReporter::addSharedData_( MemoryReportNode& parent, std::string name, const std::shared_ptr<T>& data, F&& components )
+{
+    if ( !data )
+        return 0;
+    const auto bytes = MR::heapBytes( data );
+    MemoryReportNode node;
+    if ( visited_.insert( data.get() ).second )
+    {
+        node = components( *data );
+        // the size of the structure itself and the data not reported separately
+        if ( bytes > node.bytes )
+            addChild( node, component( "other", MemoryKind::Other, bytes - node.bytes ) );
+    }
+    else
+        node.shared = true;
+    node.name = std::move( name );
+    addChild( parent, std::move( node ) );
+    return bytes;
+}
+
+MemoryReportNode MemoryReporter::object( const Object& obj )
+{
+    MemoryReportNode res;
+    res.name = obj.name();
+    res.type = obj.typeName();
+
+    // the size of this object without children, which are included in Object::heapBytes()
+    size_t ownBytes = obj.heapBytes();
+    for ( const auto& child : obj.children() )
+        if ( child )
+            ownBytes -= child->heapBytes();
+
+    // the size of the data reported in components
+    size_t reportedBytes = 0;
+    auto add = [&] ( std::string name, MemoryKind kind, size_t bytes )
+    {
+        reportedBytes += bytes;
+        addChild( res, component( std::move( name ), kind, bytes ) );
+    };
+
+    if ( auto visual = dynamic_cast<const VisualObject*>( &obj ) )
+    {
+        add( "render buffers", MemoryKind::RenderBuffers, visual->renderBuffersHeapBytes() );
+        add( "vertex normals", MemoryKind::Caches, visual->normalsCacheHeapBytes() );
+        add( "vertex colors", MemoryKind::Attributes, visual->getVertsColorMap().heapBytes() );
+        add( "texture", MemoryKind::Attributes, visual->getTexture().heapBytes() );
+        add( "UV coordinates", MemoryKind::Attributes, visual->getUVCoords().heapBytes() );
+        add( "labels", MemoryKind::Attributes, MR::heapBytes( visual->getLabels() ) );
+    }
+    if ( auto meshHolder = dynamic_cast<const ObjectMeshHolder*>( &obj ) )
+    {
+        add( "selected faces", MemoryKind::Attributes, meshHolder->getSelectedFaces().heapBytes() );
+        add( "selected edges", MemoryKind::Attributes, meshHolder->getSelectedEdges().heapBytes() );
+        add( "creases", MemoryKind::Attributes, meshHolder->creases().heapBytes() );
+        add( "face colors", MemoryKind::Attributes, meshHolder->getFacesColorMap().heapBytes() );
+        reportedBytes += addSharedData_( res, "mesh", meshHolder->mesh(), meshComponents );
+    }
+    if ( auto pointsHolder = dynamic_cast<const ObjectPointsHolder*>( &obj ) )
+    {
+        add( "selected points", MemoryKind::Attributes, pointsHolder->getSelectedPoints().heapBytes() );
+        reportedBytes += addSharedData_( res, "point cloud", pointsHolder->pointCloud(), pointCloudComponents );
+    }
+    if ( auto linesHolder = dynamic_cast<const ObjectLinesHolder*>( &obj ) )
+    {
+        add( "line colors", MemoryKind::Attributes, linesHolder->getLinesColorMap().heapBytes() );
+        reportedBytes += addSharedData_( res, "polyline", linesHolder->polyline(), polylineComponents );
+    }
+    if ( auto distanceMapObj = dynamic_cast<const ObjectDistanceMap*>( &obj ) )
+    {
+        reportedBytes += addSharedData_( res, "distance map", distanceMapObj->getDistanceMap(), [] ( const DistanceMap& dmap )
+        {
+            MemoryReportNode res;
+            addChild( res, component( "values", MemoryKind::Points, dmap.heapBytes() ) );
+            return res;
+        } );
+    }
+    if ( ownBytes > reportedBytes )
+        add( "other", MemoryKind::Other, ownBytes - reportedBytes );
+
+    for ( const auto& child : obj.children() )
+        if ( child )
+            addChild( res, object( *child ) );
+    return res;
+}
+
+MemoryReportNode historyAction( const HistoryAction& action, const char* type )
+{
+    MemoryReportNode res;
+    res.name = action.name();
+    res.type = type;
+    res.kind = MemoryKind::History;
+    if ( auto combined = dynamic_cast<const CombinedHistoryAction*>( &action ) )
+        for ( const auto& subAction : combined->getActions() )
+            if ( subAction )
+                res.children.push_back( historyAction( *subAction, type ) );
+    // the size of combined action includes its children
+    res.bytes = action.heapBytes();
+    return res;
+}
+
+void sumByKind( const MemoryReportNode& node, MemoryReport& report )
+{
+    if ( node.children.empty() )
+    {
+        report.byKind[int( node.kind )] += node.bytes;
+        return;
+    }
+    for ( const auto& child : node.children )
+        sumByKind( child, report );
+}
+
+void printNode( const MemoryReportNode& node, int indent, size_t minBytes )
+{
+    if ( node.bytes < minBytes && !( node.shared && minBytes == 0 ) )
+        return;
+    std::string line = fmt::format( "{:>12}{}{}", bytesString( node.bytes ), std::string( indent, ' ' ), node.name );
+    if ( !node.type.empty() )
+        line += fmt::format( " [{}]", node.type );
+    if ( node.shared )
+        line += " (shared, counted above)";
+    spdlog::info( line );
+    for ( const auto& child : node.children )
+        printNode( child, indent + 4, minBytes );
+}
+
+} // anonymous namespace
+
+MemoryReport makeMemoryReport( const Object& root, const HistoryStore* history )
+{
+    MR_TIMER
+    MemoryReport res;
+    res.scene = MemoryReporter().object( root );
+    sumByKind( res.scene, res );
+
+    res.history.name = "history";
+    if ( history )
+    {
+        const auto& stack = history->getStack();
+        for ( size_t i = 0; i < stack.size(); ++i )
+        {
+            if ( !stack[i] )
+                continue;
+            auto node = historyAction( *stack[i], i < history->getStackPointer() ? "undo" : "redo" );
+            res.history.bytes += node.bytes;
+            res.byKind[int( MemoryKind::History )] += node.bytes;
+            res.history.children.push_back( std::move( node ) );
+        }
+    }
+    res.totalBytes = res.scene.bytes + res.history.bytes;
+    return res;
+}
+
+MemoryReport makeSceneMemoryReport( const HistoryStore* history )
+{
+    return makeMemoryReport( SceneRoot::constGet(), history );
+}
+
+void printMemoryReport( const MemoryReport& report, size_t minBytes )
+{
+    spdlog::info( "Memory report: {} total", bytesString( report.totalBytes ) );
+    for ( int k = 0; k < int( MemoryKind::Count ); ++k )
+        spdlog::info( "{:>12}    {}", bytesString( report.byKind[k] ), asString( MemoryKind( k ) ) );
+    spdlog::info( "Scene:" );
+    printNode( report.scene, 4, minBytes );
+    if ( !report.history.children.empty() )
+    {
+        spdlog::info( "History:" );
+        printNode( report.history, 4, minBytes );
+    }
+}
+
+TEST( MRMesh, MemoryReport )
+{
+    auto root = std::make_shared<Object>();
+    auto objMesh = std::make_shared<ObjectMesh>();
+    objMesh->setName( "sphere" );
+    objMesh->setMesh( std::make_shared<Mesh>( makeUVSphere( 1.0f, 32, 32 ) ) );
+    root->addChild( objMesh );
+    // shares the mesh with objMesh
+    auto clone = objMesh->shallowClone();
+    root->addChild( clone );
+
+    const auto& mesh = *objMesh->mesh();
+    const auto reportNoTree = makeMemoryReport( *root );
+    EXPECT_EQ( reportNoTree.byKind[int( MemoryKind::Caches )], 0 );
+    EXPECT_EQ( reportNoTree.byKind[int( MemoryKind::Points )], mesh.points.heapBytes() );
+    EXPECT_EQ( reportNoTree.byKind[int( MemoryKind::Topology )], mesh.topology.heapBytes() );
+    // the shared mesh is counted once
+    EXPECT_EQ( reportNoTree.scene.bytes, root->heapBytes() - MR::heapBytes( objMesh->mesh() ) );
+
+    const auto treeBytes = sizeof( AABBTree ) + mesh.getAABBTree().heapBytes();
+    HistoryStore history;
+    history.appendAction( std::make_shared<ChangeMeshAction>( "change mesh", objMesh ) );
+    const auto report = makeMemoryReport( *root, &history );
+    EXPECT_EQ( report.byKind[int( MemoryKind::Caches )], treeBytes );
+    EXPECT_EQ( report.history.children.size(), 1 );
+    EXPECT_EQ( report.history.bytes, history.getStack()[0]->heapBytes() );
+    EXPECT_EQ( report.byKind[int( MemoryKind::History )], report.history.bytes );
+    EXPECT_EQ( report.totalBytes, report.scene.bytes + report.history.bytes );
+
+    size_t sumByKinds = 0;
+    for ( auto bytes : report.byKind )
+        sumByKinds += bytes;
+    EXPECT_EQ( sumByKinds, report.totalBytes );
+
+    // the components of root object precede its children
+    ASSERT_GE( report.scene.children.size(), 2 );
+    const auto& sphereNode = report.scene.children[report.scene.children.size() - 2];
+    EXPECT_EQ( sphereNode.name, "sphere" );
+    EXPECT_EQ( sphereNode.type, ObjectMesh::TypeName() );
+    const auto& cloneNode = report.scene.children.back();
+    EXPECT_TRUE( std::any_of( cloneNode.children.begin(), cloneNode.children.end(), [] ( const MemoryReportNode& n ) { return n.shared; } ) );
+}
+
+} // namespace MR
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace MR
+{
+
+/// \addtogroup DataModelGroup
+/// \{
+
+/// kinds of data occupying memory in memory report
+enum class MemoryKind
+{
+    Points,        ///< coordinates of mesh vertices, point cloud points and normals, polyline points, distance maps
+    Topology,      ///< connectivity of meshes and polylines, valid points of point clouds
+    Attributes,    ///< selections, colors, textures, UV-coordinates, labels
+    Caches,        ///< the data computed on demand: AABB trees, normals
+    RenderBuffers, ///< the data prepared for rendering
+    History,       ///< undo/redo actions
+    Other,         ///< the rest of objects data (names, voxel grids, ...)
+    Count
+};
+
+/// returns the name of given kind of memory
+[[nodiscard]] MRMESH_API const char* asString( MemoryKind kind );
+
+/// the amount of heap memory occupied by an object, its component or a history action
+struct MemoryReportNode
+{
+    /// the name of the object, the component or the history action
+    std::string name;
+    /// the type name of the object, empty for components
+    std::string type;
+    /// the kind of the component (for the nodes without children)
+    MemoryKind kind = MemoryKind::Other;
+    /// the size of heap memory including all children
+    size_t bytes = 0;
+    /// true if the data is shared with a node reported before, then its size is counted only there
+    bool shared = false;
+    std::vector<MemoryReportNode> children;
+};
+
+/// hierarchical report of heap memory occupied by the scene and the history
+struct MemoryReport
+{
+    /// the root object with child objects and their components
+    MemoryReportNode scene;
+    /// the actions of history store, combined actions have children
+    MemoryReportNode history;
+    /// the total size of each kind of memory over the scene and the history
+    std::array<size_t, size_t( MemoryKind::Count )> byKind{};
+    /// the total size of the scene and the history
+    size_t totalBytes = 0;
+};
+
+/// makes the report about the memory occupied by the objects of given scene and optional history store;
+/// the data shared by several objects (e.g. the mesh of shallow cloned object) is counted only once
+[[nodiscard]] MRMESH_API MemoryReport makeMemoryReport( const Object& root, const HistoryStore* history = nullptr );
+
+/// makes the report about the memory occupied by SceneRoot and optional history store
+[[nodiscard]] MRMESH_API MemoryReport makeSceneMemoryReport( const HistoryStore* history = nullptr );
+
+/// prints the report in the log skipping the nodes smaller than minBytes
+MRMESH_API void printMemoryReport( const MemoryReport& report, size_t minBytes = 0 );
+
+/// \}
+
+} // namespace MR
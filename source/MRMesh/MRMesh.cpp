@@ -1,4 +1,5 @@
 #include "MRMesh.h"
+#include "MRMeshNormals.h"
 #include "MRMeshBuilder.h"
 #include "MRBox.h"
 #include "MRAffineXf3.h"
@@ -713,16 +714,29 @@ const AABBTree & Mesh::getAABBTree() const
     return res;
 }
 
+const MeshNormals & Mesh::getNormals() const
+{
+    return normalsOwner_.getOrCreate( [this]{ return computeMeshNormals( *this ); } );
+}
+
 void Mesh::invalidateCaches()
 {
     AABBTreeOwner_.reset();
+    normalsOwner_.reset();
+}
+
+void Mesh::updateCaches( const VertBitSet & changedVerts )
+{
+    AABBTreeOwner_.reset();
+    normalsOwner_.update( [&]( MeshNormals & normals ) { updateMeshNormals( *this, changedVerts, normals ); } );
 }
 
 size_t Mesh::heapBytes() const
 {
     return topology.heapBytes()
         + points.heapBytes()
-        + AABBTreeOwner_.heapBytes();
+        + AABBTreeOwner_.heapBytes()
+        + normalsOwner_.heapBytes();
 }
 
 Vector3f Mesh::findCenterFromPoints() const
@@ -227,14 +227,23 @@ struct [[nodiscard]] Mesh
     /// returns cached aabb-tree for this mesh, but does not create it if it did not exist
     const AABBTree * getAABBTreeNotCreate() const { return AABBTreeOwner_.get(); }
 
+    /// returns cached normals of all faces and vertices of this mesh, computing them if they did not exist in a thread-safe manner
+    MRMESH_API const MeshNormals & getNormals() const;
+    /// returns cached normals for this mesh, but does not create them if they did not exist
+    const MeshNormals * getNormalsNotCreate() const { return normalsOwner_.get(); }
+
     // Invalidates caches (e.g. aabb-tree) after a change in mesh geometry or topology
     MRMESH_API void invalidateCaches();
+    /// updates caches after the coordinates of given vertices were changed without a change in topology:
+    /// cached normals are recomputed only around changed vertices, and aabb-tree is invalidated
+    MRMESH_API void updateCaches( const VertBitSet & changedVerts );
 
     // returns the amount of memory this object occupies on heap
     [[nodiscard]] MRMESH_API size_t heapBytes() const;
 
 private:
     mutable UniqueThreadSafeOwner<AABBTree> AABBTreeOwner_;
+    mutable UniqueThreadSafeOwner<MeshNormals> normalsOwner_;
 };
 
 // deprecated, please use MR_WRITER directly
@@ -7,103 +7,165 @@
 #include "MRRegionBoundary.h"
 #include "MRMeshBuilder.h"
 #include "MREdgeIterator.h"
+#include "MRCube.h"
+#include "MRSphere.h"
 #include "MRGTest.h"
 #include "MRPch/MRTBB.h"
-#include <parallel_hashmap/phmap.h>
 
 namespace MR
 {
 namespace MeshComponents
 {
 
-std::pair<std::vector<int>, int> getUniqueRoots( const FaceMap& allRoots, const FaceBitSet& region )
+namespace
 {
-    constexpr int InvalidRoot = -1;
-    std::vector<int> uniqueRootsMap( allRoots.size(), InvalidRoot );
-    int k = 0;
-    int curRoot;
-    for ( auto f : region )
+
+/// calls given callback for each face of the region incident to f0 according to given incidence (f0 itself can be passed too)
+template<typename F>
+void forEachNeighborFace( const MeshPart& meshPart, FaceId f0, FaceIncidence incidence, F&& callback )
+{
+    const auto& topology = meshPart.mesh.topology;
+    auto test = [reg = meshPart.region]( FaceId f )
     {
-        curRoot = allRoots[f];
-        auto& uniqIndex = uniqueRootsMap[curRoot];
-        if ( uniqIndex == InvalidRoot )
+        return f.valid() && ( !reg || reg->test( f ) );
+    };
+    EdgeId e = topology.edgeWithLeft( f0 );
+    if ( incidence == FaceIncidence::PerEdge )
+    {
+        for ( int i = 0; i < 3; ++i )
         {
-            uniqIndex = k;
-            ++k;
+            assert( topology.left( e ) == f0 );
+            if ( auto f1 = topology.right( e ); test( f1 ) )
+                callback( f1 );
+            e = topology.prev( e.sym() );
+        }
+    }
+    else if ( incidence == FaceIncidence::PerVertex )
+    {
+        VertId vid[3];
+        topology.getLeftTriVerts( e, vid );
+        for ( auto faceVert : vid )
+        {
+            for ( auto edge : orgRing( topology, faceVert ) )
+            {
+                if ( auto f1 = topology.left( edge ); test( f1 ) )
+                    callback( f1 );
+            }
         }
     }
-    return { std::move( uniqueRootsMap ),k };
 }
 
-FaceBitSet getComponent( const MeshPart& meshPart, FaceId id, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
+/// calls given callback for each vertex of the region connected with v0 by an edge
+template<typename F>
+void forEachNeighborVert( const Mesh& mesh, VertId v0, const VertBitSet* region, F&& callback )
 {
-    MR_TIMER;
-    auto unionFindStruct = getUnionFindStructureFaces( meshPart, incidence );
-    const FaceBitSet& region = meshPart.mesh.topology.getFaceIds( meshPart.region );
+    for ( auto e : orgRing( mesh.topology, v0 ) )
+    {
+        auto v1 = mesh.topology.dest( e );
+        if ( v1.valid() && ( !region || region->test( v1 ) ) )
+            callback( v1 );
+    }
+}
 
-    int faceRoot = unionFindStruct.find( id );
-    const auto& allRoots = unionFindStruct.roots();
-    FaceBitSet res;
-    res.resize( allRoots.size() );
-    for ( auto f : region )
+/// marks all elements reachable from the seeds (which must be in the region) in res
+template<typename T, typename F>
+void floodFill( TaggedBitSet<T>& res, std::vector<Id<T>> stack, F&& forEachNeighbor )
+{
+    for ( auto s : stack )
+        res.set( s );
+    while ( !stack.empty() )
     {
-        if ( allRoots[f] == faceRoot )
-            res.set( f );
+        const auto i = stack.back();
+        stack.pop_back();
+        forEachNeighbor( i, [&]( Id<T> n )
+        {
+            if ( !res.test_set( n ) )
+                stack.push_back( n );
+        } );
     }
-    return res;
 }
 
-VertBitSet getComponentVerts( const Mesh& mesh, VertId id, const VertBitSet* region /*= nullptr */ )
+/// assigns component indices in the order of roots (which are the smallest elements of components) and counts component sizes
+template<typename T>
+ComponentLabels<Id<T>> makeLabels( AtomicUnionFind<Id<T>>& unionFind, const TaggedBitSet<T>& region )
 {
     MR_TIMER;
-    auto unionFindStruct = getUnionFindStructureVerts( mesh, region );
-    const VertBitSet& vertsRegion = mesh.topology.getVertIds( region );
+    ComponentLabels<Id<T>> res;
+    res.labels.resize( unionFind.size(), -1 );
+    for ( auto i : region )
+    {
+        if ( unionFind.find( i ) == i )
+        {
+            res.labels[i] = int( res.sizes.size() );
+            res.sizes.push_back( 0 );
+        }
+    }
+    BitSetParallelFor( region, [&]( Id<T> i )
+    {
+        res.labels[i] = res.labels[unionFind.find( i )];
+    } );
+    for ( auto i : region )
+        ++res.sizes[res.labels[i]];
+    return res;
+}
 
-    int vertRoot = unionFindStruct.find( id );
-    const auto& allRoots = unionFindStruct.roots();
-    VertBitSet res;
-    res.resize( allRoots.size() );
-    for ( auto v : vertsRegion )
+/// makes a bitset for each component, each bitset has the size enough for its last element only
+template<typename T>
+std::vector<TaggedBitSet<T>> makeComponentBitSets( const ComponentLabels<Id<T>>& labels, const TaggedBitSet<T>& region )
+{
+    MR_TIMER;
+    const int k = int( labels.sizes.size() );
+    std::vector<TaggedBitSet<T>> res( k );
+    // this block is needed to limit allocations for not packed meshes
+    std::vector<int> resSizes( k, 0 );
+    for ( auto i : region )
     {
-        if ( allRoots[v] == vertRoot )
-            res.set( v );
+        int index = labels.labels[i];
+        if ( i > resSizes[index] )
+            resSizes[index] = i;
     }
+    for ( int i = 0; i < k; ++i )
+        res[i].resize( resSizes[i] + 1 );
+    // end of allocation block
+    for ( auto i : region )
+        res[labels.labels[i]].set( i );
     return res;
+}
+
+} // anonymous namespace
+
+FaceBitSet getComponent( const MeshPart& meshPart, FaceId id, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
+{
+    FaceBitSet seeds( id + 1 );
+    seeds.set( id );
+    return getComponents( meshPart, seeds, incidence );
+}
 
+VertBitSet getComponentVerts( const Mesh& mesh, VertId id, const VertBitSet* region /*= nullptr */ )
+{
+    VertBitSet seeds( id + 1 );
+    seeds.set( id );
+    return getComponentsVerts( mesh, seeds, region );
 }
 
 FaceBitSet getLargestComponent( const MeshPart& meshPart, FaceIncidence incidence /*= FaceIncidence::PerEdge */ )
 {
     MR_TIMER;
 
-    auto unionFindStruct = getUnionFindStructureFaces( meshPart, incidence );
     const auto& mesh = meshPart.mesh;
     const FaceBitSet& region = mesh.topology.getFaceIds( meshPart.region );
+    const auto labels = getAllComponentsLabels( meshPart, incidence );
 
-    const auto& allRoots = unionFindStruct.roots();
-    auto [uniqueRootsMap, k] = getUniqueRoots( allRoots, region );
-
-    double maxArea = -DBL_MAX;
-    int maxI = 0;
-    std::vector<double> areas( k, 0.0 );
+    std::vector<double> areas( labels.sizes.size(), 0.0 );
     for ( auto f : region )
-    {
-        auto index = uniqueRootsMap[allRoots[f]];
-        auto& area = areas[index];
-        area += meshPart.mesh.dblArea( f );
-        if ( area > maxArea )
-        {
-            maxI = index;
-            maxArea = area;
-        }
-    }
+        areas[labels.labels[f]] += mesh.dblArea( f );
+    const int maxI = int( std::max_element( areas.begin(), areas.end() ) - areas.begin() );
+
     FaceBitSet maxAreaComponent( region.find_last() + 1 );
     for ( auto f : region )
     {
-        auto index = uniqueRootsMap[allRoots[f]];
-        if ( index != maxI )
-            continue;
-        maxAreaComponent.set( f );
+        if ( labels.labels[f] == maxI )
+            maxAreaComponent.set( f );
     }
     return maxAreaComponent;
 }
@@ -112,15 +174,19 @@ VertBitSet getLargestComponentVerts( const Mesh& mesh, const VertBitSet* region
 {
     MR_TIMER;
 
-    auto allComponents = getAllComponentsVerts( mesh, region );
-
-    if ( allComponents.empty() )
+    const VertBitSet& vertsRegion = mesh.topology.getVertIds( region );
+    const auto labels = getAllComponentsVertsLabels( mesh, region );
+    if ( labels.sizes.empty() )
         return {};
+    const int maxI = int( std::max_element( labels.sizes.begin(), labels.sizes.end() ) - labels.sizes.begin() );
 
-    return *std::max_element( allComponents.begin(), allComponents.end(), []( const VertBitSet& a, const VertBitSet& b )
+    VertBitSet res( labels.labels.size() );
+    for ( auto v : vertsRegion )
     {
-        return a.count() < b.count();
-    } );
+        if ( labels.labels[v] == maxI )
+            res.set( v );
+    }
+    return res;
 }
 
 FaceBitSet getComponents( const MeshPart& meshPart, const FaceBitSet & seeds, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
@@ -131,25 +197,17 @@ FaceBitSet getComponents( const MeshPart& meshPart, const FaceBitSet & seeds, Fa
     if ( seeds.empty() )
         return res;
 
-    auto unionFindStruct = getUnionFindStructureFaces( meshPart, incidence );
     const FaceBitSet& region = meshPart.mesh.topology.getFaceIds( meshPart.region );
-
-    FaceId faceRoot;
+    res.resize( region.find_last() + 1 );
+    std::vector<FaceId> stack;
     for ( auto s : seeds )
-    {
-        if ( faceRoot < 0 )
-            faceRoot = unionFindStruct.find( s );
-        else
-            faceRoot = unionFindStruct.unite( faceRoot, s );
-    }
+        if ( region.test( s ) )
+            stack.push_back( s );
 
-    const auto& allRoots = unionFindStruct.roots();
-    res.resize( allRoots.size() );
-    for ( auto f : region )
+    floodFill( res, std::move( stack ), [&]( FaceId f, auto&& visit )
     {
-        if ( allRoots[f] == faceRoot )
-            res.set( f );
-    }
+        forEachNeighborFace( meshPart, f, incidence, visit );
+    } );
     return res;
 }
 
@@ -161,71 +219,56 @@ VertBitSet getComponentsVerts( const Mesh& mesh, const VertBitSet& seeds, const
     if ( seeds.empty() )
         return res;
 
-    auto unionFindStruct = getUnionFindStructureVerts( mesh, region );
     const VertBitSet& vertRegion = mesh.topology.getVertIds( region );
-
-    VertId vertRoot;
+    res.resize( mesh.topology.lastValidVert() + 1 );
+    std::vector<VertId> stack;
     for ( auto s : seeds )
-    {
-        if ( vertRoot < 0 )
-            vertRoot = unionFindStruct.find( s );
-        else
-            vertRoot = unionFindStruct.unite( vertRoot, s );
-    }
+        if ( vertRegion.test( s ) )
+            stack.push_back( s );
 
-    const auto& allRoots = unionFindStruct.roots();
-    res.resize( allRoots.size() );
-    for ( auto v : vertRegion )
+    floodFill( res, std::move( stack ), [&]( VertId v, auto&& visit )
     {
-        if ( allRoots[v] == vertRoot )
-            res.set( v );
-    }
+        forEachNeighborVert( mesh, v, region, visit );
+    } );
     return res;
-
 }
 
 size_t getNumComponents( const MeshPart& meshPart, FaceIncidence incidence )
 {
     MR_TIMER;
-    auto unionFindStruct = getUnionFindStructureFaces( meshPart, incidence );
-    const auto& mesh = meshPart.mesh;
-    const FaceBitSet& region = mesh.topology.getFaceIds( meshPart.region );
+    auto unionFindStruct = getAtomicUnionFindStructureFaces( meshPart, incidence );
+    const FaceBitSet& region = meshPart.mesh.topology.getFaceIds( meshPart.region );
 
-    const auto& allRoots = unionFindStruct.roots();
-    FaceHashSet componentRoots;
-    for ( auto f : region )
+    // each component has exactly one root
+    return tbb::parallel_reduce( tbb::blocked_range<int>( 0, int( unionFindStruct.size() ) ), size_t( 0 ),
+        [&]( const tbb::blocked_range<int>& range, size_t num )
     {
-        componentRoots.insert( allRoots[f] );
-    }
-    return componentRoots.size();
+        for ( FaceId f{ range.begin() }; f < range.end(); ++f )
+            if ( region.test( f ) && unionFindStruct.find( f ) == f )
+                ++num;
+        return num;
+    }, std::plus<size_t>() );
 }
 
 std::vector<FaceBitSet> getAllComponents( const MeshPart& meshPart, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
 {
     MR_TIMER;
-    auto unionFindStruct = getUnionFindStructureFaces( meshPart, incidence );
-    const auto& mesh = meshPart.mesh;
-    const FaceBitSet& region = mesh.topology.getFaceIds( meshPart.region );
+    const FaceBitSet& region = meshPart.mesh.topology.getFaceIds( meshPart.region );
+    return makeComponentBitSets( getAllComponentsLabels( meshPart, incidence ), region );
+}
 
-    const auto& allRoots = unionFindStruct.roots();
-    auto [uniqueRootsMap, k] = getUniqueRoots( allRoots, region );
-    std::vector<FaceBitSet> res( k );
-    // this block is needed to limit allocations for not packed meshes
-    std::vector<int> resSizes( k, 0 );
-    for ( auto f : region )
-    {
-        int index = uniqueRootsMap[allRoots[f]];
-        if ( f > resSizes[index] )
-            resSizes[index] = f;
-    }
-    for ( int i = 0; i < k; ++i )
-        res[i].resize( resSizes[i] + 1 );
-    // end of allocation block
-    for ( auto f : region )
-    {
-        res[uniqueRootsMap[allRoots[f]]].set( f );
-    }
-    return res;
+ComponentLabels<FaceId> getAllComponentsLabels( const MeshPart& meshPart, FaceIncidence incidence /*= FaceIncidence::PerEdge*/ )
+{
+    MR_TIMER;
+    auto unionFindStruct = getAtomicUnionFindStructureFaces( meshPart, incidence );
+    return makeLabels( unionFindStruct, meshPart.mesh.topology.getFaceIds( meshPart.region ) );
+}
+
+ComponentLabels<VertId> getAllComponentsVertsLabels( const Mesh& mesh, const VertBitSet* region /*= nullptr*/ )
+{
+    MR_TIMER;
+    auto unionFindStruct = getAtomicUnionFindStructureVerts( mesh, region );
+    return makeLabels( unionFindStruct, mesh.topology.getVertIds( region ) );
 }
 
 static std::vector<VertBitSet> getAllComponentsVerts( UnionFind<VertId>& unionFindStruct, const VertBitSet& vertsRegion, const VertBitSet* doNotOutput )
@@ -263,9 +306,12 @@ static std::vector<VertBitSet> getAllComponentsVerts( UnionFind<VertId>& unionFi
 std::vector<VertBitSet> getAllComponentsVerts( const Mesh& mesh, const VertBitSet* region )
 {
     MR_TIMER;
-    auto unionFindStruct = getUnionFindStructureVerts( mesh, region );
     const VertBitSet& vertsRegion = mesh.topology.getVertIds( region );
-    return getAllComponentsVerts( unionFindStruct, vertsRegion, nullptr );
+    const auto labels = getAllComponentsVertsLabels( mesh, region );
+    std::vector<VertBitSet> res( labels.sizes.size(), VertBitSet( labels.labels.size() ) );
+    for ( auto v : vertsRegion )
+        res[labels.labels[v]].set( v );
+    return res;
 }
 
 std::vector<VertBitSet> getAllComponentsVertsSeparatedByPath( const Mesh& mesh, const SurfacePath& path )
@@ -307,6 +353,40 @@ std::vector<EdgeBitSet> getAllComponentsEdges( const Mesh& mesh, const EdgeBitSe
     return res;
 }
 
+AtomicUnionFind<FaceId> getAtomicUnionFindStructureFaces( const MeshPart& meshPart, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
+{
+    MR_TIMER;
+
+    const FaceBitSet& region = meshPart.mesh.topology.getFaceIds( meshPart.region );
+    AtomicUnionFind<FaceId> unionFindStructure( region.find_last() + 1 );
+    BitSetParallelFor( region, [&]( FaceId f0 )
+    {
+        forEachNeighborFace( meshPart, f0, incidence, [&]( FaceId f1 )
+        {
+            if ( f1 < f0 )
+                unionFindStructure.unite( f0, f1 );
+        } );
+    } );
+    return unionFindStructure;
+}
+
+AtomicUnionFind<VertId> getAtomicUnionFindStructureVerts( const Mesh& mesh, const VertBitSet* region )
+{
+    MR_TIMER;
+
+    const VertBitSet& vertsRegion = mesh.topology.getVertIds( region );
+    AtomicUnionFind<VertId> unionFindStructure( mesh.topology.lastValidVert() + 1 );
+    BitSetParallelFor( vertsRegion, [&]( VertId v0 )
+    {
+        forEachNeighborVert( mesh, v0, region, [&]( VertId v1 )
+        {
+            if ( v1 < v0 )
+                unionFindStructure.unite( v0, v1 );
+        } );
+    } );
+    return unionFindStructure;
+}
+
 UnionFind<FaceId> getUnionFindStructureFaces( const MeshPart& meshPart, FaceIncidence incidence/* = FaceIncidence::PerEdge*/ )
 {
     MR_TIMER;
@@ -477,6 +557,73 @@ TEST(MRMesh, getAllComponentsEdges)
     ASSERT_EQ( comp[0].count(), 5 );
 }
 
+TEST( MRMesh, AtomicUnionFind )
+{
+    constexpr int n = 100000;
+    AtomicUnionFind<VertId> uf( n );
+    // two interleaved chains united in parallel
+    tbb::parallel_for( tbb::blocked_range<int>( 0, n - 2 ), [&]( const tbb::blocked_range<int>& range )
+    {
+        for ( int i = range.begin(); i < range.end(); ++i )
+            uf.unite( VertId( i + 2 ), VertId( i ) );
+    } );
+    for ( int i = 0; i < n; ++i )
+        ASSERT_EQ( uf.find( VertId( i ) ), VertId( i % 2 ) );
+    EXPECT_TRUE( uf.united( 10_v, 1000_v ) );
+    EXPECT_FALSE( uf.united( 10_v, 1001_v ) );
+}
+
+TEST( MRMesh, ComponentsLabels )
+{
+    auto mesh = makeSphere( { .numMeshVertices = 2000 } );
+    mesh.addPart( makeCube( Vector3f::diagonal( 1 ), Vector3f::diagonal( 3 ) ) );
+    mesh.addPart( makeCube( Vector3f::diagonal( 2 ), Vector3f::diagonal( -6 ) ) );
+
+    // the region splits the sphere on two parts touching by vertices
+    FaceBitSet region = mesh.topology.getValidFaces();
+    const auto sphereFaces = region.count() - 24;
+    for ( auto f : region )
+    {
+        if ( f >= sphereFaces )
+            break;
+        if ( std::abs( mesh.triCenter( f ).z ) < 0.1f )
+            region.reset( f );
+    }
+
+    for ( auto incidence : { FaceIncidence::PerEdge, FaceIncidence::PerVertex } )
+    {
+        const MeshPart mp{ mesh, &region };
+        const auto labels = getAllComponentsLabels( mp, incidence );
+        const auto components = getAllComponents( mp, incidence );
+        ASSERT_EQ( labels.sizes.size(), components.size() );
+        EXPECT_EQ( getNumComponents( mp, incidence ), components.size() );
+        EXPECT_EQ( components.size(), 4 );
+
+        // compare with sequential union-find
+        auto uf = getUnionFindStructureFaces( mp, incidence );
+        for ( int i = 0; i < components.size(); ++i )
+        {
+            EXPECT_EQ( components[i].count(), labels.sizes[i] );
+            const auto first = components[i].find_first();
+            EXPECT_EQ( getComponent( mp, first, incidence ), components[i] | FaceBitSet( region.find_last() + 1 ) );
+            for ( auto f : components[i] )
+            {
+                EXPECT_EQ( labels.labels[f], i );
+                EXPECT_TRUE( uf.united( f, first ) );
+            }
+        }
+        EXPECT_EQ( getLargestComponent( mp, incidence ).count(), 12 ); // the bigger cube
+    }
+
+    const auto vertLabels = getAllComponentsVertsLabels( mesh );
+    ASSERT_EQ( vertLabels.sizes.size(), 3 );
+    EXPECT_EQ( vertLabels.sizes[1], 8 );
+    EXPECT_EQ( vertLabels.sizes[2], 8 );
+    EXPECT_EQ( getLargestComponentVerts( mesh ).count(), vertLabels.sizes[0] );
+    EXPECT_EQ( getComponentVerts( mesh, 0_v ).count(), vertLabels.sizes[0] );
+    EXPECT_EQ( getAllComponentsVerts( mesh ).size(), 3 );
+}
+
 } // namespace MeshComponents
 
 } // namespace MR
@@ -19,11 +19,22 @@ enum FaceIncidence
     PerVertex ///< face can have neighbor via vertex
 };
 
-/// returns one connected component containing given face, 
-/// not effective to call more than once, if several components are needed use getAllComponents
+/// compact labeling of connected components
+template <typename I>
+struct ComponentLabels
+{
+    /// the index of component for each element, -1 for the elements outside of the region;
+    /// the components are numbered in the order of their smallest elements
+    Vector<int, I> labels;
+    /// the number of elements in each component
+    std::vector<int> sizes;
+};
+
+/// returns one connected component containing given face, found by local traversal from this face;
+/// not effective to call more than once, if several components are needed use getAllComponents or getAllComponentsLabels
 MRMESH_API FaceBitSet getComponent( const MeshPart& meshPart, FaceId id, FaceIncidence incidence = FaceIncidence::PerEdge );
-/// returns one connected component containing given vertex, 
-/// not effective to call more than once, if several components are needed use getAllComponentsVerts
+/// returns one connected component containing given vertex, found by local traversal from this vertex;
+/// not effective to call more than once, if several components are needed use getAllComponentsVerts or getAllComponentsVertsLabels
 MRMESH_API VertBitSet getComponentVerts( const Mesh& mesh, VertId id, const VertBitSet* region = nullptr );
 
 /// returns largest by surface area component
@@ -42,6 +53,10 @@ MRMESH_API size_t getNumComponents( const MeshPart& meshPart, FaceIncidence inci
 /// gets all connected components of mesh part
 MRMESH_API std::vector<FaceBitSet> getAllComponents( const MeshPart& meshPart, FaceIncidence incidence = FaceIncidence::PerEdge );
 MRMESH_API std::vector<VertBitSet> getAllComponentsVerts( const Mesh& mesh, const VertBitSet* region = nullptr );
+/// gets the component index of each face of mesh part and the sizes of all components without allocating a bitset per component
+MRMESH_API ComponentLabels<FaceId> getAllComponentsLabels( const MeshPart& meshPart, FaceIncidence incidence = FaceIncidence::PerEdge );
+/// gets the component index of each vertex in the region and the sizes of all components without allocating a bitset per component
+MRMESH_API ComponentLabels<VertId> getAllComponentsVertsLabels( const Mesh& mesh, const VertBitSet* region = nullptr );
 /// gets all connected components, separating vertices by given path (either closed or from boundary to boundary)
 MRMESH_API std::vector<VertBitSet> getAllComponentsVertsSeparatedByPath( const Mesh& mesh, const SurfacePath& path );
 /// subdivides given edges on connected components
@@ -50,6 +65,10 @@ MRMESH_API std::vector<EdgeBitSet> getAllComponentsEdges( const Mesh& mesh, cons
 /// gets union-find structure for given mesh part
 MRMESH_API UnionFind<FaceId> getUnionFindStructureFaces( const MeshPart& meshPart, FaceIncidence incidence = FaceIncidence::PerEdge );
 MRMESH_API UnionFind<VertId> getUnionFindStructureVerts( const Mesh& mesh, const VertBitSet* region = nullptr );
+/// gets union-find structure for given mesh part filled in parallel, its roots are the smallest faces of components
+MRMESH_API AtomicUnionFind<FaceId> getAtomicUnionFindStructureFaces( const MeshPart& meshPart, FaceIncidence incidence = FaceIncidence::PerEdge );
+/// gets union-find structure for vertices in the region filled in parallel, its roots are the smallest vertices of components
+MRMESH_API AtomicUnionFind<VertId> getAtomicUnionFindStructureVerts( const Mesh& mesh, const VertBitSet* region = nullptr );
 /// gets union-find structure for vertices, considering connections by given edges only
 MRMESH_API UnionFind<VertId> getUnionFindStructureVerts( const Mesh& mesh, const EdgeBitSet & edges );
 /// gets union-find structure for vertices, considering connections by all edges excluding given ones
@@ -10,6 +10,8 @@
 #include "MRGTest.h"
 #include "MRMeshDelone.h"
 #include "MRMeshSubdivide.h"
+#include "MRMeshDecimateParallel.h"
+#include "MRProgressiveMesh.h"
 #include "MRPch/MRTBB.h"
 #include <queue>
 
@@ -125,7 +127,7 @@ private:
     bool initializeQueue_();
     std::optional<QueueElement> computeQueueElement_( UndirectedEdgeId ue, QuadraticForm3f * outCollapseForm = nullptr, Vector3f * outCollapsePos = nullptr ) const;
     void addInQueueIfMissing_( UndirectedEdgeId ue );
-    VertId collapse_( EdgeId edgeToCollapse, const Vector3f & collapsePos );
+    VertId collapse_( EdgeId edgeToCollapse, const Vector3f & collapsePos, float error );
 };
 
 MeshDecimator::MeshDecimator( Mesh & mesh, const DecimateSettings & settings )
@@ -313,7 +315,7 @@ void MeshDecimator::addInQueueIfMissing_( UndirectedEdgeId ue )
         queue_.push( *qe );
 }
 
-VertId MeshDecimator::collapse_( EdgeId edgeToCollapse, const Vector3f & collapsePos )
+VertId MeshDecimator::collapse_( EdgeId edgeToCollapse, const Vector3f & collapsePos, float error )
 {
     auto & topology = mesh_.topology;
     // cannot collapse edge if its left and right faces share another edge
@@ -409,6 +411,14 @@ VertId MeshDecimator::collapse_( EdgeId edgeToCollapse, const Vector3f & collaps
         ++res_.facesDeleted;
     if ( vr )
         ++res_.facesDeleted;
+    if ( settings_.outCollapses )
+    {
+        if ( topology.next( edgeToCollapse ) == edgeToCollapse )
+            // origin vertex has the only edge: collapseEdge deletes it and leaves destination vertex in place
+            settings_.outCollapses->push_back( { vd, vo, pd, error, 0 } );
+        else
+            settings_.outCollapses->push_back( { vo, vd, collapsePos, error, int( vl.valid() ) + int( vr.valid() ) } );
+    }
 
     mesh_.points[vo] = collapsePos;
     if ( settings_.region )
@@ -474,7 +484,7 @@ DecimateResult MeshDecimator::run()
         }
 
         presentInQueue_.reset( topQE.uedgeId );
-        VertId collapseVert = collapse_( topQE.uedgeId, collapsePos );
+        VertId collapseVert = collapse_( topQE.uedgeId, collapsePos, std::sqrt( qe->c ) );
         if ( !collapseVert )
             continue;
 
@@ -537,6 +547,7 @@ bool remesh( MR::Mesh& mesh, const RemeshSettings & settings )
     subs.maxAngleChangeAfterFlip = settings.maxAngleChangeAfterFlip;
     subs.useCurvature = settings.useCurvature;
     subs.region = settings.region;
+    subs.subdivideParts = settings.subdivideParts;
     if ( settings.progressCallback )
         subs.progressCallback = [settings] ( float arg ) { return settings.progressCallback( arg * 0.5f ); };
     subdivideMesh( mesh, subs );
@@ -544,6 +555,27 @@ bool remesh( MR::Mesh& mesh, const RemeshSettings & settings )
     if ( settings.progressCallback && !settings.progressCallback( 0.5f ) )
         return false;
 
+    if ( settings.subdivideParts > 1 )
+    {
+        DecimateParallelSettings decs;
+        decs.strategy = DecimateStrategy::ShortestEdgeFirst;
+        decs.maxError = settings.targetEdgeLen / 2;
+        decs.region = settings.region;
+        decs.subdivideParts = settings.subdivideParts;
+        if ( settings.progressCallback )
+            decs.progressCallback = [settings] ( float arg ) { return settings.progressCallback( 0.5f + arg * 0.5f ); };
+        if ( decimateParallelMesh( mesh, decs ).cancelled )
+            return false;
+        if ( settings.packMesh )
+        {
+            FaceMap fmap;
+            mesh.pack( settings.region ? &fmap : nullptr );
+            if ( settings.region )
+                *settings.region = settings.region->getMapping( fmap, mesh.topology.faceSize() );
+        }
+        return !settings.progressCallback || settings.progressCallback( 1.0f );
+    }
+
     DecimateSettings decs;
     decs.strategy = DecimateStrategy::ShortestEdgeFirst;
     decs.maxError = settings.targetEdgeLen / 2;
@@ -581,4 +613,19 @@ TEST( MRMesh, MeshDecimate )
     ASSERT_GT(decimateResults.facesDeleted, 0);
 }
 
+TEST( MRMesh, RemeshParallel )
+{
+    Mesh mesh = makeCylinderAdvanced( 0.5f, 0.5f, 0.0f, 2 * PI_F, 1.0f, 64 );
+    FaceBitSet region = mesh.topology.getValidFaces();
+    RemeshSettings settings;
+    settings.targetEdgeLen = 0.05f;
+    settings.region = &region;
+    settings.packMesh = true;
+    settings.subdivideParts = 8;
+    EXPECT_TRUE( remesh( mesh, settings ) );
+    EXPECT_TRUE( mesh.topology.checkValidity() );
+    EXPECT_EQ( region, mesh.topology.getValidFaces() );
+    EXPECT_GT( mesh.topology.numValidFaces(), 1000 );
+}
+
 } //namespace MR
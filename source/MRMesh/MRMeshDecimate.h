@@ -77,6 +77,9 @@ struct DecimateSettings
     Vector<QuadraticForm3f, VertId> * vertForms = nullptr;
     ///  whether to pack mesh at the end
     bool packMesh = false;
+    /// if not null, then all performed edge collapses are appended there in the order of their application,
+    /// see ProgressiveMesh to extract any level of detail from them; packMesh must be false for the records to be meaningful
+    std::vector<EdgeCollapseRecord> * outCollapses = nullptr;
     /// callback to report algorithm progress and cancel it by user request
     ProgressCallback progressCallback = {};
 };
@@ -148,6 +151,9 @@ struct RemeshSettings
     bool packMesh = false;
     /// callback to report algorithm progress and cancel it by user request
     ProgressCallback progressCallback;
+    /// if greater than 1, then both splitting and elimination of edges are done in parallel in this number of mesh parts,
+    /// see SubdivideSettings::subdivideParts and DecimateParallelSettings::subdivideParts
+    int subdivideParts = 1;
 };
 // Splits too long and eliminates too short edges from the mesh
 MRMESH_API bool remesh( Mesh& mesh, const RemeshSettings & settings );
@@ -3,56 +3,105 @@
 #include "MRAABBTree.h"
 #include "MRTimer.h"
 #include "MRMeshBuilder.h"
+#include "MRProgressiveMesh.h"
 #include "MRQuadraticForm.h"
 #include "MRBitSetParallelFor.h"
 #include "MRPch/MRTBB.h"
+#include "MRTorus.h"
+#include "MRGTest.h"
+#include <algorithm>
 
 namespace MR
 {
 
-DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSettings & settings )
+namespace
+{
+
+// splits valid faces of the mesh on the cells of regular grid with about numParts cells in the mesh bounding box,
+// the grid is shifted on (shift) fraction of cell size in each dimension
+std::vector<FaceBitSet> subdivideByGrid( const Mesh & mesh, int numParts, float shift )
 {
     MR_TIMER;
+    const auto box = mesh.computeBoundingBox();
+    const auto size = box.size();
+    const float maxDim = std::max( { size.x, size.y, size.z } );
+    if ( !( maxDim > 0 ) )
+        return { mesh.topology.getValidFaces() };
 
-    DecimateSettings seqSettings;
-    seqSettings.strategy = settings.strategy;
-    seqSettings.maxError = settings.maxError;
-    seqSettings.maxEdgeLen = settings.maxEdgeLen;
-    seqSettings.maxTriangleAspectRatio = settings.maxTriangleAspectRatio;
-    seqSettings.stabilizer = settings.stabilizer;
-    seqSettings.optimizeVertexPos = settings.optimizeVertexPos;
-    seqSettings.region = settings.region;
-    seqSettings.touchBdVertices = settings.touchBdVertices;
-    if ( settings.preCollapse )
+    // cubic cells, ignoring degenerate dimensions of the box
+    double volume = 1;
+    int numDims = 0;
+    for ( int i = 0; i < 3; ++i )
     {
-        seqSettings.preCollapse = [&mesh, cb = settings.preCollapse]( MR::EdgeId edgeToCollapse, const MR::Vector3f & newEdgeOrgPos ) -> bool
+        if ( size[i] > 1e-3f * maxDim )
         {
-            return cb( mesh.topology.org( edgeToCollapse ), mesh.topology.dest( edgeToCollapse ), newEdgeOrgPos );
-        };
+            volume *= size[i];
+            ++numDims;
+        }
     }
-    if ( settings.adjustCollapse )
+    const float cellSize = float( std::pow( volume / numParts, 1.0 / numDims ) );
+    Vector3i dims;
+    for ( int i = 0; i < 3; ++i )
+        dims[i] = int( size[i] / cellSize + shift ) + 1;
+
+    const auto & topology = mesh.topology;
+    std::vector<int> faceCell( topology.faceSize(), -1 );
+    BitSetParallelFor( topology.getValidFaces(), [&] ( FaceId f )
     {
-        seqSettings.adjustCollapse = [&mesh, cb = settings.adjustCollapse]( MR::EdgeId edgeToCollapse, float & collapseErrorSq, Vector3f & collapsePos )
+        const auto p = ( mesh.triCenter( f ) - box.min ) / cellSize;
+        Vector3i c;
+        for ( int i = 0; i < 3; ++i )
+            c[i] = std::clamp( int( p[i] + shift ), 0, dims[i] - 1 );
+        faceCell[f] = c.x + dims.x * ( c.y + dims.y * c.z );
+    } );
+
+    std::vector<int> cellPart( size_t( dims.x ) * dims.y * dims.z, -1 );
+    std::vector<FaceBitSet> res;
+    for ( FaceId f{ 0 }; f < faceCell.size(); ++f )
+    {
+        const auto cell = faceCell[f];
+        if ( cell < 0 )
+            continue;
+        auto & part = cellPart[cell];
+        if ( part < 0 )
         {
-            cb( mesh.topology.org( edgeToCollapse ), mesh.topology.dest( edgeToCollapse ), collapseErrorSq, collapsePos );
-        };
+            part = int( res.size() );
+            res.emplace_back( topology.faceSize() );
+        }
+        res[part].set( f );
     }
+    return res;
+}
 
-    DecimateResult res;
-    if ( settings.subdivideParts <= 1 )
+DecimateParallelRoundStats makeRoundStats( int numParts, const std::vector<EdgeCollapseRecord> & collapses, double seconds )
+{
+    DecimateParallelRoundStats res;
+    res.numParts = numParts;
+    res.vertsDeleted = int( collapses.size() );
+    double sumError = 0;
+    for ( const auto & c : collapses )
     {
-        seqSettings.progressCallback = settings.progressCallback;
-        res = decimateMesh( mesh, seqSettings );
-        return res;
+        res.facesDeleted += c.facesDeleted;
+        res.maxCollapseError = std::max( res.maxCollapseError, c.error );
+        sumError += c.error;
     }
+    if ( !collapses.empty() )
+        res.avgCollapseError = float( sumError / collapses.size() );
+    res.seconds = seconds;
+    return res;
+}
 
-    MR_WRITER( mesh );
-    const auto & tree = mesh.getAABBTree();
-    const auto subroots = tree.getSubtrees( settings.subdivideParts );
-    const auto sz = subroots.size();
-
-    if ( settings.progressCallback && !settings.progressCallback( 0.05f ) )
-        return res;
+// decimates given parts of the mesh in parallel with locked part boundaries and recombines the mesh from them;
+// vertForms: on input quadratic forms of all mesh vertices or empty to compute them, on output the forms of all remaining vertices;
+// returns false if the operation was canceled
+bool decimatePartsInParallel( Mesh & mesh, const std::vector<FaceBitSet> & parts, const DecimateSettings & seqSettings,
+    const DecimateParallelSettings & settings, Vector<QuadraticForm3f, VertId> & vertForms,
+    float progressFrom, float progressTo, DecimateResult & res )
+{
+    MR_TIMER;
+    const auto sz = parts.size();
+    const bool inVertForms = !vertForms.empty();
+    auto progress = [&] ( float p ) { return progressFrom + ( progressTo - progressFrom ) * p; };
 
     struct alignas(64) SubMesh
     {
@@ -62,6 +111,7 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
         VertMap subVertToOriginal;
         FaceBitSet region;
         DecimateResult decimRes;
+        std::vector<EdgeCollapseRecord> collapses;
     };
     std::vector<SubMesh> submeshes( sz );
 
@@ -78,7 +128,7 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
             {
                 if ( cancelled.load( std::memory_order_relaxed ) )
                     return false;
-                if ( reportProgressFromThisThread && !settings.progressCallback( 0.05f + 0.7f * ( finishedSubmeshes.load( std::memory_order_relaxed ) + p ) / sz ) )
+                if ( reportProgressFromThisThread && !settings.progressCallback( progress( 0.85f * ( finishedSubmeshes.load( std::memory_order_relaxed ) + p ) / sz ) ) )
                 {
                     cancelled.store( true, std::memory_order_relaxed );
                     return false;
@@ -87,7 +137,6 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
             };
             if ( !reportThreadProgress( 0 ) )
                 break;
-            auto faces = tree.getSubtreeFaces( subroots[i] );
             auto & submesh = submeshes[i];
             VertMap vertSubToFull;
             FaceHashMap faceFullToSub;
@@ -95,7 +144,13 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
             map.tgt2srcVerts = &vertSubToFull;
             if ( settings.region )
                 map.src2tgtFaces = &faceFullToSub;
-            submesh.m.addPartByMask( mesh, faces, map );
+            submesh.m.addPartByMask( mesh, parts[i], map );
+            if ( inVertForms )
+            {
+                submesh.mVertForms.resize( submesh.m.topology.vertSize() );
+                for ( auto v : submesh.m.topology.getValidVerts() )
+                    submesh.mVertForms[v] = vertForms[vertSubToFull[v]];
+            }
 
             if ( !reportThreadProgress( 0.1f ) )
                 break;
@@ -103,6 +158,8 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
             auto subSeqSettings = seqSettings;
             subSeqSettings.touchBdVertices = false;
             subSeqSettings.vertForms = &submesh.mVertForms;
+            if ( settings.outRoundStats )
+                subSeqSettings.outCollapses = &submesh.collapses;
             if ( settings.region )
             {
                 submesh.region = settings.region->getMapping( faceFullToSub );
@@ -161,8 +218,8 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
         }
     } );
 
-    if ( cancelled.load( std::memory_order_relaxed ) || ( settings.progressCallback && !settings.progressCallback( 0.75f ) ) )
-        return res;
+    if ( cancelled.load( std::memory_order_relaxed ) || ( settings.progressCallback && !settings.progressCallback( progress( 0.85f ) ) ) )
+        return false;
 
     // recombine mesh from parts
     MR::Vector<MR::QuadraticForm3f, MR::VertId> unitedVertForms( mesh.topology.vertSize() );
@@ -196,36 +253,161 @@ DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSett
                 unitedVertForms[fv] = submesh.mVertForms[v];
             }
         }
+        res.facesDeleted += submesh.decimRes.facesDeleted;
+        res.vertsDeleted += submesh.decimRes.vertsDeleted;
     }
 
-    if ( settings.progressCallback && !settings.progressCallback( 0.8f ) )
-        return res;
+    if ( settings.progressCallback && !settings.progressCallback( progress( 0.9f ) ) )
+        return false;
 
     mesh.topology = MeshBuilder::fromTriangles( t );
+    mesh.invalidateCaches();
 
-    if ( settings.progressCallback && !settings.progressCallback( 0.85f ) )
-        return res;
+    if ( settings.progressCallback && !settings.progressCallback( progress( 0.95f ) ) )
+        return false;
 
+    // the forms of locked vertices computed inside the parts do not take into account the faces of other parts
     BitSetParallelFor( bdOfSomePiece, [&]( VertId v )
     {
-        unitedVertForms[v] = computeFormAtVertex( { mesh, settings.region }, v, settings.stabilizer );
+        unitedVertForms[v] = inVertForms ? vertForms[v] : computeFormAtVertex( { mesh, settings.region }, v, settings.stabilizer );
     } );
+    vertForms = std::move( unitedVertForms );
+
+    if ( settings.outRoundStats )
+    {
+        std::vector<EdgeCollapseRecord> collapses;
+        for ( auto & submesh : submeshes )
+            collapses.insert( collapses.end(), submesh.collapses.begin(), submesh.collapses.end() );
+        settings.outRoundStats->back() = makeRoundStats( int( sz ), collapses, 0 );
+    }
+    return true;
+}
+
+} //anonymous namespace
+
+DecimateResult decimateParallelMesh( MR::Mesh & mesh, const DecimateParallelSettings & settings )
+{
+    MR_TIMER;
+
+    DecimateSettings seqSettings;
+    seqSettings.strategy = settings.strategy;
+    seqSettings.maxError = settings.maxError;
+    seqSettings.maxEdgeLen = settings.maxEdgeLen;
+    seqSettings.maxTriangleAspectRatio = settings.maxTriangleAspectRatio;
+    seqSettings.stabilizer = settings.stabilizer;
+    seqSettings.optimizeVertexPos = settings.optimizeVertexPos;
+    seqSettings.region = settings.region;
+    seqSettings.touchBdVertices = settings.touchBdVertices;
+    if ( settings.preCollapse )
+    {
+        seqSettings.preCollapse = [&mesh, cb = settings.preCollapse]( MR::EdgeId edgeToCollapse, const MR::Vector3f & newEdgeOrgPos ) -> bool
+        {
+            return cb( mesh.topology.org( edgeToCollapse ), mesh.topology.dest( edgeToCollapse ), newEdgeOrgPos );
+        };
+    }
+    if ( settings.adjustCollapse )
+    {
+        seqSettings.adjustCollapse = [&mesh, cb = settings.adjustCollapse]( MR::EdgeId edgeToCollapse, float & collapseErrorSq, Vector3f & collapsePos )
+        {
+            cb( mesh.topology.org( edgeToCollapse ), mesh.topology.dest( edgeToCollapse ), collapseErrorSq, collapsePos );
+        };
+    }
+    if ( settings.outRoundStats )
+        settings.outRoundStats->clear();
+
+    DecimateResult res;
+    std::vector<EdgeCollapseRecord> finalCollapses;
+    if ( settings.outRoundStats )
+        seqSettings.outCollapses = &finalCollapses;
+    if ( settings.subdivideParts <= 1 )
+    {
+        Timer timer( "final pass" );
+        seqSettings.progressCallback = settings.progressCallback;
+        res = decimateMesh( mesh, seqSettings );
+        if ( settings.outRoundStats )
+            settings.outRoundStats->push_back( makeRoundStats( 1, finalCollapses, timer.secondsPassed().count() ) );
+        return res;
+    }
 
-    if ( settings.progressCallback && !settings.progressCallback( 0.9f ) )
+    MR_WRITER( mesh );
+    if ( settings.progressCallback && !settings.progressCallback( 0.05f ) )
         return res;
 
-    seqSettings.vertForms = &unitedVertForms;
+    Vector<QuadraticForm3f, VertId> vertForms;
+    const int numRounds = std::max( 1, settings.numParallelRounds );
+    for ( int round = 0; round < numRounds; ++round )
+    {
+        Timer timer( "parallel round" );
+        std::vector<FaceBitSet> parts;
+        if ( round == 0 )
+        {
+            const auto & tree = mesh.getAABBTree();
+            const auto subroots = tree.getSubtrees( settings.subdivideParts );
+            parts.resize( subroots.size() );
+            tbb::parallel_for( tbb::blocked_range<size_t>( 0, subroots.size() ), [&]( const tbb::blocked_range<size_t>& range )
+            {
+                for ( size_t i = range.begin(); i < range.end(); ++i )
+                    parts[i] = tree.getSubtreeFaces( subroots[i] );
+            } );
+        }
+        else
+        {
+            // the parts of AABB tree and the cells of not-shifted grid have boundaries in different places,
+            // and the grid shifted on half of the cell has boundaries inside the cells of not-shifted grid
+            parts = subdivideByGrid( mesh, settings.subdivideParts, round % 2 == 1 ? 0.5f : 0.0f );
+        }
+
+        if ( settings.outRoundStats )
+            settings.outRoundStats->emplace_back();
+        const float progressFrom = 0.05f + 0.85f * round / numRounds;
+        const float progressTo = 0.05f + 0.85f * ( round + 1 ) / numRounds;
+        if ( !decimatePartsInParallel( mesh, parts, seqSettings, settings, vertForms, progressFrom, progressTo, res ) )
+            return res;
+        if ( settings.outRoundStats )
+            settings.outRoundStats->back().seconds = timer.secondsPassed().count();
+    }
+
+    Timer timer( "final pass" );
+    seqSettings.vertForms = &vertForms;
     if ( settings.progressCallback )
         seqSettings.progressCallback = [cb = settings.progressCallback](float p) { return cb( 0.9f + 0.1f * p ); };
+    const auto parallelRes = res;
     res = decimateMesh( mesh, seqSettings );
-    // update res from submesh decimations
-    for ( const auto & submesh : submeshes )
-    {
-        res.facesDeleted += submesh.decimRes.facesDeleted;
-        res.vertsDeleted += submesh.decimRes.vertsDeleted;
-    }
+    res.facesDeleted += parallelRes.facesDeleted;
+    res.vertsDeleted += parallelRes.vertsDeleted;
+    if ( settings.outRoundStats )
+        settings.outRoundStats->push_back( makeRoundStats( 1, finalCollapses, timer.secondsPassed().count() ) );
 
     return res;
 }
 
+TEST( MRMesh, DecimateParallel )
+{
+    Mesh torus = makeTorus( 2.0f, 1.0f, 64, 64 );
+    const int numFaces = torus.topology.numValidFaces();
+    std::vector<DecimateParallelRoundStats> stats;
+    DecimateParallelSettings settings;
+    settings.maxError = 0.05f;
+    settings.subdivideParts = 8;
+    settings.numParallelRounds = 3;
+    settings.outRoundStats = &stats;
+    const auto res = decimateParallelMesh( torus, settings );
+    EXPECT_FALSE( res.cancelled );
+    EXPECT_TRUE( torus.topology.checkValidity() );
+    EXPECT_EQ( torus.topology.numValidFaces(), numFaces - res.facesDeleted );
+
+    ASSERT_EQ( stats.size(), 4 );
+    int vertsDeleted = 0;
+    for ( const auto & s : stats )
+    {
+        EXPECT_LE( s.maxCollapseError, settings.maxError );
+        EXPECT_LE( s.avgCollapseError, s.maxCollapseError );
+        vertsDeleted += s.vertsDeleted;
+    }
+    EXPECT_EQ( vertsDeleted, res.vertsDeleted );
+    EXPECT_EQ( stats.back().numParts, 1 );
+    // the final pass has less work than the first parallel round
+    EXPECT_LT( stats.back().vertsDeleted, stats.front().vertsDeleted );
+}
+
 } //namespace MR
@@ -5,6 +5,24 @@
 namespace MR
 {
 
+/**
+ * \struct MR::DecimateParallelRoundStats
+ * \brief Statistics of one round of MR::decimateParallelMesh
+ * \ingroup DecimateGroup
+ */
+struct DecimateParallelRoundStats
+{
+    /// the number of mesh parts decimated in parallel, 1 for the final pass over whole mesh
+    int numParts = 0;
+    int vertsDeleted = 0;
+    int facesDeleted = 0;
+    /// maximal and average errors introduced by the edge collapses of this round
+    float maxCollapseError = 0;
+    float avgCollapseError = 0;
+    /// wall time of the round
+    double seconds = 0;
+};
+
 /**
  * \struct MR::DecimateParallelSettings
  * \brief Parameters structure for MR::decimateParallelMesh
@@ -36,6 +54,13 @@ struct DecimateParallelSettings
     bool touchBdVertices = true;
     /// Subdivides mesh on given number of parts to process them in parallel
     int subdivideParts = 32;
+    /// The number of rounds of parallel decimation before the final pass over whole mesh;
+    /// each next round subdivides the mesh shifted relative to the previous one,
+    /// so the locked boundaries of the parts of the previous round appear inside the parts of the next round,
+    /// and the final single-threaded pass has little to do
+    int numParallelRounds = 1;
+    /// If not null, receives the statistics of each parallel round followed by the final pass
+    std::vector<DecimateParallelRoundStats> * outRoundStats = nullptr;
     /**
      * \brief  The user can provide this optional callback that is invoked immediately before edge collapse;
      * \details It receives both vertices of the edge being collapsed: v1 will disappear,
@@ -8,6 +8,8 @@
 #include "MRMeshBuilder.h"
 #include "MRMeshDelone.h"
 #include "MRHash.h"
+#include "MRTorus.h"
+#include "MRConstants.h"
 #include "MRPch/MRTBB.h"
 #include "MRGTest.h"
 #include <parallel_hashmap/phmap.h>
@@ -457,26 +459,25 @@ bool buildCylinderBetweenTwoHoles( Mesh & mesh, const StitchHolesParams& params
     return true;
 }
 
+// triangulation of one hole found without any modification of the mesh
+struct HoleFillPlan
+{
+    // the number of edges in the hole
+    unsigned numEdges = 0;
+    // optimal triangulation was not found, so the hole must be filled trivially
+    bool trivial = false;
+    // connections between hole vertices in the order of new triangles creation,
+    // each connection (a,b) makes triangle with the vertex prevA (given by indices of hole edges)
+    std::vector<WeightedConn> conns;
+};
+
 // Sub cubic complexity
-void fillHole( Mesh& mesh, EdgeId a0, const FillHoleParams& params )
+HoleFillPlan getHoleFillPlan( const Mesh& mesh, EdgeId a0, const FillHoleParams& params )
 {
-    if ( params.maxPolygonSubdivisions < 2 )
-    {
-        assert( false );
-        return;
-    }
     MR_TIMER;
-    MR_WRITER( mesh );
+    HoleFillPlan res;
     if ( mesh.topology.left( a0 ) )
-        return;
-    assert( !mesh.topology.left( a0 ) );
-    auto newFace = [&]()
-    {
-        auto res = mesh.topology.addFaceId();
-        if ( params.outNewFaces )
-            params.outNewFaces->autoResizeSet( res );
         return res;
-    };
 
     unsigned loopEdgesCounter = 0;
     EdgeId a = a0;
@@ -485,15 +486,11 @@ void fillHole( Mesh& mesh, EdgeId a0, const FillHoleParams& params )
         a = mesh.topology.prev( a.sym() );
         ++loopEdgesCounter;
     } while ( a != a0 );
+    res.numEdges = loopEdgesCounter;
 
-    if ( loopEdgesCounter < 3 )
-        return;
+    if ( loopEdgesCounter <= 3 )
+        return res;
 
-    if ( loopEdgesCounter == 3)
-    {
-        mesh.topology.setLeft( a, newFace() );
-        return;
-    }
     // Fill EdgeMaps
     std::vector<EdgeId> edgeMap( loopEdgesCounter );
     a = a0;
@@ -559,54 +556,226 @@ void fillHole( Mesh& mesh, EdgeId a0, const FillHoleParams& params )
         }
     }
 
-    if ( params.makeDegenerateBand )
+    if ( finConn.a == -1 || finConn.b == -1 )
     {
-        a = a0 = makeDegenerateBandAroundHole( mesh, a0, params.outNewFaces );
-        for ( unsigned i = 0; i < loopEdgesCounter; ++i )
-        {
-            edgeMap[i] = a;
-            a = mesh.topology.prev( a.sym() );
-        }
+        res.trivial = true;
+        return res;
     }
 
-    if ( finConn.a == -1 || finConn.b == -1 )
+    // walk the triangulation in the same order as executeHoleFillPlan will create the edges
+    WeightedConn fictiveLastConn( finConn.a, ( finConn.b + 1 ) % loopEdgesCounter, 0.0 );
+    fictiveLastConn.prevA = finConn.b;
+    std::queue<WeightedConn> newEdgesQueue;
+    newEdgesQueue.push( fictiveLastConn );
+    res.conns.reserve( loopEdgesCounter - 2 );
+    while ( !newEdgesQueue.empty() )
+    {
+        const auto & curConn = res.conns.emplace_back( newEdgesQueue.front() );
+        newEdgesQueue.pop();
+
+        auto distA = ( curConn.a - curConn.prevA + loopEdgesCounter ) % loopEdgesCounter;
+        auto distB = ( curConn.b - curConn.prevA + loopEdgesCounter ) % loopEdgesCounter;
+
+        if ( distA >= 2 && distA <= loopEdgesCounter - 2 )
+            newEdgesQueue.push( newEdgesMap[curConn.a][curConn.prevA] );
+        if ( distB >= 2 && distB <= loopEdgesCounter - 2 )
+            newEdgesQueue.push( newEdgesMap[curConn.prevA][curConn.b] );
+    }
+    return res;
+}
+
+// creates the triangles of given plan in the hole represented by edge a0
+void executeHoleFillPlan( Mesh& mesh, EdgeId a0, const HoleFillPlan& plan, const FillHoleParams& params )
+{
+    const unsigned loopEdgesCounter = plan.numEdges;
+    if ( loopEdgesCounter < 3 )
+        return;
+    assert( !mesh.topology.left( a0 ) );
+    auto newFace = [&]()
+    {
+        auto res = mesh.topology.addFaceId();
+        if ( params.outNewFaces )
+            params.outNewFaces->autoResizeSet( res );
+        return res;
+    };
+
+    if ( loopEdgesCounter == 3 )
+    {
+        mesh.topology.setLeft( a0, newFace() );
+        return;
+    }
+
+    if ( params.makeDegenerateBand )
+        a0 = makeDegenerateBandAroundHole( mesh, a0, params.outNewFaces );
+
+    if ( plan.trivial )
     {
         fillHoleTrivially( mesh, a0, params.outNewFaces );
         return;
     }
 
+    std::vector<EdgeId> edgeMap( loopEdgesCounter );
+    EdgeId a = a0;
+    for ( unsigned i = 0; i < loopEdgesCounter; ++i )
+    {
+        edgeMap[i] = a;
+        a = mesh.topology.prev( a.sym() );
+    }
+    assert( a == a0 );
 
-    // queue for adding new edges (not to make tree like recursive logic)
-    WeightedConn fictiveLastConn( finConn.a, ( finConn.b + 1 ) % loopEdgesCounter, 0.0 );
-    fictiveLastConn.prevA = finConn.b;
-    std::queue<std::pair<WeightedConn, EdgeId>> newEdgesQueue;
-    newEdgesQueue.push( {fictiveLastConn,edgeMap[fictiveLastConn.b]} );
-    std::pair<WeightedConn, EdgeId> curConn;
-    while ( !newEdgesQueue.empty() )
+    // queue for adding new edges (not to make tree like recursive logic),
+    // it receives the edges in the same order as the connections are stored in the plan
+    std::queue<EdgeId> newEdgesQueue;
+    newEdgesQueue.push( edgeMap[plan.conns.front().b] );
+    for ( const auto & curConn : plan.conns )
     {
-        curConn = std::move( newEdgesQueue.front() );
+        assert( !newEdgesQueue.empty() );
+        const auto curEdge = newEdgesQueue.front();
         newEdgesQueue.pop();
 
-        auto distA = ( curConn.first.a - curConn.first.prevA + loopEdgesCounter ) % loopEdgesCounter;
-        auto distB = ( curConn.first.b - curConn.first.prevA + loopEdgesCounter ) % loopEdgesCounter;
+        auto distA = ( curConn.a - curConn.prevA + loopEdgesCounter ) % loopEdgesCounter;
+        auto distB = ( curConn.b - curConn.prevA + loopEdgesCounter ) % loopEdgesCounter;
 
         if ( distA >= 2 && distA <= loopEdgesCounter - 2 )
         {
             EdgeId newEdge = mesh.topology.makeEdge();
-            mesh.topology.splice( edgeMap[curConn.first.prevA], newEdge );
-            mesh.topology.splice( edgeMap[curConn.first.a], newEdge.sym() );
-            newEdgesQueue.push( {newEdgesMap[curConn.first.a][curConn.first.prevA],newEdge} );
+            mesh.topology.splice( edgeMap[curConn.prevA], newEdge );
+            mesh.topology.splice( edgeMap[curConn.a], newEdge.sym() );
+            newEdgesQueue.push( newEdge );
         }
 
         if ( distB >= 2 && distB <= loopEdgesCounter - 2 )
         {
             EdgeId newEdge = mesh.topology.makeEdge();
-            mesh.topology.splice( curConn.second, newEdge );
-            mesh.topology.splice( edgeMap[curConn.first.prevA], newEdge.sym() );
-            newEdgesQueue.push( {newEdgesMap[curConn.first.prevA][curConn.first.b],newEdge} );
+            mesh.topology.splice( curEdge, newEdge );
+            mesh.topology.splice( edgeMap[curConn.prevA], newEdge.sym() );
+            newEdgesQueue.push( newEdge );
+        }
+
+        mesh.topology.setLeft( curEdge, newFace() );
+    }
+    assert( newEdgesQueue.empty() );
+}
+
+// splits given hole by new edges connecting nearly opposite hole vertices until each hole has at most maxEdges edges,
+// appends one edge of each resulting hole in (holes)
+void splitHoleForFill( Mesh& mesh, EdgeId a0, int maxEdges, std::vector<EdgeId>& holes )
+{
+    std::vector<EdgeId> toSplit{ a0 };
+    std::vector<EdgeId> loop;
+    while ( !toSplit.empty() )
+    {
+        const auto a = toSplit.back();
+        toSplit.pop_back();
+        loop.clear();
+        for ( auto e : leftRing( mesh.topology, a ) )
+            loop.push_back( e );
+        const int n = int( loop.size() );
+        if ( maxEdges <= 0 || n <= maxEdges )
+        {
+            holes.push_back( a );
+            continue;
+        }
+
+        // the shortest connection among the ones dividing the hole in halves
+        const int half = n / 2;
+        float bestDistSq = FLT_MAX;
+        int bestI = -1;
+        for ( int i = 0; i < n; ++i )
+        {
+            const auto ei = loop[i];
+            const auto ej = loop[( i + half ) % n];
+            const auto distSq = ( mesh.orgPnt( ei ) - mesh.orgPnt( ej ) ).lengthSq();
+            if ( distSq >= bestDistSq || mesh.topology.org( ei ) == mesh.topology.org( ej ) || sameEdgeExists( mesh.topology, ei, ej ) )
+                continue;
+            bestDistSq = distSq;
+            bestI = i;
         }
+        if ( bestI < 0 )
+        {
+            holes.push_back( a );
+            continue;
+        }
+        const auto bridge = makeBridgeEdge( mesh.topology, loop[bestI], loop[( bestI + half ) % n] );
+        assert( bridge );
+        toSplit.push_back( bridge.sym() );
+        toSplit.push_back( bridge );
+    }
+}
 
-        mesh.topology.setLeft( curConn.second, newFace() );
+void fillHole( Mesh& mesh, EdgeId a0, const FillHoleParams& params )
+{
+    if ( params.maxPolygonSubdivisions < 2 )
+    {
+        assert( false );
+        return;
+    }
+    MR_TIMER;
+    MR_WRITER( mesh );
+    if ( mesh.topology.left( a0 ) )
+        return;
+
+    std::vector<EdgeId> holes;
+    splitHoleForFill( mesh, a0, params.maxHoleEdgesForOptimalFill, holes );
+    for ( auto h : holes )
+        executeHoleFillPlan( mesh, h, getHoleFillPlan( mesh, h, params ), params );
+}
+
+void fillHoles( Mesh& mesh, const std::vector<EdgeId>& as, const FillHoleParams& params )
+{
+    if ( params.maxPolygonSubdivisions < 2 )
+    {
+        assert( false );
+        return;
+    }
+    if ( as.size() <= 1 )
+    {
+        for ( auto a : as )
+            fillHole( mesh, a, params );
+        return;
+    }
+    MR_TIMER;
+    MR_WRITER( mesh );
+
+    // the holes sharing vertices with previous holes are triangulated only after previous holes are filled,
+    // otherwise the triangulation can repeat the edges just created
+    std::vector<EdgeId> holes, dependentHoles;
+    VertHashSet holeVerts;
+    for ( auto a : as )
+    {
+        if ( mesh.topology.left( a ) )
+            continue;
+        bool dependent = false;
+        for ( auto e : leftRing( mesh.topology, a ) )
+            if ( !holeVerts.insert( mesh.topology.org( e ) ).second )
+                dependent = true;
+        if ( dependent )
+            dependentHoles.push_back( a );
+        else
+            splitHoleForFill( mesh, a, params.maxHoleEdgesForOptimalFill, holes );
+    }
+
+    // independent holes are triangulated in parallel and filled in the given order
+    std::vector<HoleFillPlan> plans( holes.size() );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, holes.size(), 1 ), [&] ( const tbb::blocked_range<size_t>& range )
+    {
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+            plans[i] = getHoleFillPlan( mesh, holes[i], params );
+    } );
+    for ( size_t i = 0; i < holes.size(); ++i )
+    {
+        executeHoleFillPlan( mesh, holes[i], plans[i], params );
+        plans[i] = {};
+    }
+
+    for ( auto a : dependentHoles )
+    {
+        if ( mesh.topology.left( a ) )
+            continue; // the same hole was given twice
+        holes.clear();
+        splitHoleForFill( mesh, a, params.maxHoleEdgesForOptimalFill, holes );
+        for ( auto h : holes )
+            executeHoleFillPlan( mesh, h, getHoleFillPlan( mesh, h, params ), params );
     }
 }
 
@@ -940,4 +1109,57 @@ TEST( MRMesh, makeBridgeEdge )
     EXPECT_FALSE( x.valid() );
 }
 
+TEST( MRMesh, fillHoles )
+{
+    Mesh torus = makeTorus( 2.0f, 0.5f, 64, 32 );
+    FaceBitSet toDelete( torus.topology.faceSize() );
+    for ( auto f : torus.topology.getValidFaces() )
+    {
+        const auto c = torus.triCenter( f );
+        if ( c.z > 0.35f ) // band along whole torus top bounded by two long holes
+            toDelete.set( f );
+        for ( int k = 0; k < 6; ++k ) // small holes on torus bottom
+        {
+            const float t = k * PI_F / 3;
+            if ( ( c - Vector3f( 2.5f * std::cos( t ), 2.5f * std::sin( t ), -0.1f ) ).length() < 0.3f )
+                toDelete.set( f );
+        }
+    }
+    torus.topology.deleteFaces( toDelete );
+    torus.invalidateCaches();
+    auto holes = torus.topology.findHoleRepresentiveEdges();
+    EXPECT_EQ( holes.size(), 8 );
+    int numHoleEdges = 0;
+    for ( auto e : holes )
+        for ( [[maybe_unused]] auto x : leftRing( torus.topology, e ) )
+            ++numHoleEdges;
+
+    Mesh one = torus;
+    FillHoleParams params;
+    for ( auto e : holes )
+        fillHole( one, e, params );
+    EXPECT_TRUE( one.topology.findHoleRepresentiveEdges().empty() );
+
+    Mesh batch = torus;
+    FaceBitSet newFaces;
+    params.outNewFaces = &newFaces;
+    holes.push_back( holes.front() ); // the same hole given twice must be filled only once
+    fillHoles( batch, holes, params );
+    EXPECT_TRUE( batch.topology.findHoleRepresentiveEdges().empty() );
+    EXPECT_TRUE( batch.topology.checkValidity() );
+    EXPECT_EQ( batch.topology.numValidFaces(), one.topology.numValidFaces() );
+    // no new vertices are introduced, so each hole with n edges gets n-2 triangles
+    EXPECT_EQ( newFaces.count(), numHoleEdges - 2 * 8 );
+
+    // large holes are split on smaller ones before triangulation
+    Mesh split = torus;
+    newFaces.clear();
+    params.maxHoleEdgesForOptimalFill = 20;
+    fillHoles( split, holes, params );
+    EXPECT_TRUE( split.topology.findHoleRepresentiveEdges().empty() );
+    EXPECT_TRUE( split.topology.checkValidity() );
+    EXPECT_EQ( split.topology.numValidVerts(), torus.topology.numValidVerts() );
+    EXPECT_EQ( newFaces.count(), numHoleEdges - 2 * 8 );
+}
+
 } //namespace MR
@@ -54,6 +54,13 @@ struct FillHoleParams
       * must be 2 or larger
       */
     int maxPolygonSubdivisions{ 20 };
+
+    /** Time and memory of the optimal triangulation grow quadratically with the number of hole edges,
+      * so the holes having more edges are first split on smaller holes by new edges connecting nearly opposite hole vertices;
+      * zero or negative value disables the splitting (default, so the triangulation of any hole is optimal);
+      * set it (e.g. to 2000) to bound the memory when filling huge holes, especially in parallel by \ref fillHoles
+      */
+    int maxHoleEdgesForOptimalFill{ 0 };
 };
 
 /** \struct MR::StitchHolesParams
@@ -125,6 +132,21 @@ MRMESH_API bool buildCylinderBetweenTwoHoles( Mesh & mesh, const StitchHolesPara
   */
 MRMESH_API void fillHole( Mesh& mesh, EdgeId a, const FillHoleParams& params = {} );
 
+/** \brief Fills many holes in mesh\n
+  *
+  * Same as \ref fillHole for each hole, but the triangulations of independent holes are computed in parallel
+  * and then applied to the mesh one by one in the given order;
+  * the holes sharing vertices with previous holes are triangulated only after previous holes are filled;
+  * since many huge holes can be triangulated simultaneously, consider setting FillHoleParams::maxHoleEdgesForOptimalFill
+  *
+  * \param mesh mesh with holes
+  * \param as EdgeIds each representing a hole, e.g. from MeshTopology::findHoleRepresentiveEdges
+  * \param params parameters of holes filling, the metric is shared by all holes
+  *
+  * \sa \ref fillHole
+  */
+MRMESH_API void fillHoles( Mesh& mesh, const std::vector<EdgeId>& as, const FillHoleParams& params = {} );
+
 /** \brief Fills hole in mesh trivially\n
   * \ingroup FillHoleGroup
   *
@@ -21,6 +21,7 @@
 #endif
 
 #include <array>
+#include <cstdint>
 #include <vector>
 #include <parallel_hashmap/phmap_fwd_decl.h>
 
@@ -80,6 +81,10 @@ using UndirectedEdgeBitSet = TaggedBitSet<UndirectedEdgeTag>;
 using PixelBitSet = TaggedBitSet<PixelTag>;
 using VoxelBitSet = TaggedBitSet<VoxelTag>;
 
+template <typename T> class SparseIdSet;
+using SparseFaceSet = SparseIdSet<FaceTag>;
+using SparseVertSet = SparseIdSet<VertTag>;
+
 template <typename T> class SetBitIteratorT;
 
 using SetBitIterator     = SetBitIteratorT<BitSet>;
@@ -229,6 +234,8 @@ struct MeshEdgePoint;
 using SurfacePath = std::vector<MeshEdgePoint>;
 struct MeshTriPoint;
 struct MeshProjectionResult;
+struct MeshNormals;
+struct PointsProjectionResult;
 struct MeshIntersectionResult;
 template <typename T> struct IntersectionPrecomputes;
 
@@ -264,7 +271,11 @@ template <typename T, typename I, typename P> class Heap;
 class MeshTopology;
 struct Mesh;
 struct MeshPart;
+class MeshOrPoints;
+struct EdgeCollapseRecord;
+struct ProgressiveMesh;
 struct PointCloud;
+class PointNeighbors;
 class MRMESH_CLASS AABBTree;
 class MRMESH_CLASS AABBTreePoints;
 template<typename T> class UniqueThreadSafeOwner;
@@ -298,6 +309,8 @@ class CircleObject;
 class PlaneObject;
 class SphereObject;
 struct SimpleVolume;
+template <typename T> struct TypedSimpleVolume;
+using SimpleVolumeU16 = TypedSimpleVolume<uint16_t>;
 
 struct OpenVdbFloatGrid;
 using FloatGrid = std::shared_ptr<OpenVdbFloatGrid>;
@@ -3,7 +3,12 @@
 #include "MRRingIterator.h"
 #include "MRBuffer.h"
 #include "MRVector4.h"
+#include "MRRegionBoundary.h"
+#include "MRBitSetParallelFor.h"
 #include "MRTimer.h"
+#include "MRTorus.h"
+#include "MRMeshRelax.h"
+#include "MRGTest.h"
 #include "MRPch/MRTBB.h"
 
 namespace MR
@@ -122,6 +127,25 @@ MeshNormals computeMeshNormals( const Mesh & mesh )
     return res;
 }
 
+void updateMeshNormals( const Mesh & mesh, const VertBitSet & changedVerts, MeshNormals & normals )
+{
+    MR_TIMER
+    const auto changedFaces = getIncidentFaces( mesh.topology, changedVerts );
+    if ( changedFaces.none() )
+        return; // isolated or no changed vertices
+    const auto affectedVerts = getIncidentVerts( mesh.topology, changedFaces );
+    assert( normals.faceNormals.size() > changedFaces.find_last() );
+    assert( normals.vertNormals.size() > affectedVerts.find_last() );
+    BitSetParallelFor( changedFaces, [&]( FaceId f )
+    {
+        normals.faceNormals[f] = mesh.normal( f );
+    } );
+    BitSetParallelFor( affectedVerts, [&]( VertId v )
+    {
+        normals.vertNormals[v] = mesh.normal( v );
+    } );
+}
+
 Vector<TriangleCornerNormals, FaceId> computePerCornerNormals( const Mesh & mesh, const UndirectedEdgeBitSet * creases )
 {
     MR_TIMER
@@ -211,4 +235,46 @@ Vector<TriangleCornerNormals, FaceId> computePerCornerNormals( const Mesh & mesh
     return res;
 }
 
+TEST( MRMesh, MeshNormalsCache )
+{
+    Mesh torus = makeTorus( 2.0f, 1.0f, 16, 16 );
+    const auto & normals = torus.getNormals();
+    EXPECT_EQ( &normals, torus.getNormalsNotCreate() );
+    EXPECT_GE( torus.heapBytes(), normals.heapBytes() );
+
+    VertBitSet changed( torus.topology.vertSize() );
+    for ( VertId v : { 0_v, 7_v, 100_v } )
+    {
+        torus.points[v] += Vector3f( 0.1f, -0.2f, 0.3f );
+        changed.set( v );
+    }
+    torus.updateCaches( changed );
+    EXPECT_EQ( &normals, torus.getNormalsNotCreate() );
+    const auto expected = computeMeshNormals( torus );
+    for ( auto f : torus.topology.getValidFaces() )
+        EXPECT_LT( ( normals.faceNormals[f] - expected.faceNormals[f] ).length(), 1e-6f );
+    for ( auto v : torus.topology.getValidVerts() )
+        EXPECT_LT( ( normals.vertNormals[v] - expected.vertNormals[v] ).length(), 1e-6f );
+
+    // empty set of changed vertices keeps normals as is
+    torus.updateCaches( VertBitSet() );
+    torus.updateCaches( VertBitSet( torus.topology.vertSize() ) );
+    EXPECT_EQ( &normals, torus.getNormalsNotCreate() );
+    for ( auto f : torus.topology.getValidFaces() )
+        EXPECT_LT( ( normals.faceNormals[f] - expected.faceNormals[f] ).length(), 1e-6f );
+
+    // relaxation updates the normals around moved vertices
+    VertBitSet region( torus.topology.vertSize() );
+    region.set( 5_v );
+    region.set( 50_v );
+    relax( torus, { { 2, &region } } );
+    EXPECT_EQ( &normals, torus.getNormalsNotCreate() );
+    const auto relaxed = computeMeshNormals( torus );
+    for ( auto v : torus.topology.getValidVerts() )
+        EXPECT_LT( ( normals.vertNormals[v] - relaxed.vertNormals[v] ).length(), 1e-6f );
+
+    torus.invalidateCaches();
+    EXPECT_EQ( torus.getNormalsNotCreate(), nullptr );
+}
+
 } //namespace MR
@@ -18,6 +18,9 @@ struct [[nodiscard]] MeshNormals
 {
     FaceNormals faceNormals;
     VertexNormals vertNormals;
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return faceNormals.heapBytes() + vertNormals.heapBytes(); }
 };
 
 /// returns a vector with face-normal in every element for valid mesh faces
@@ -32,6 +35,10 @@ MRMESH_API void computePerFaceNormals4( const Mesh & mesh, Vector4f* faceNormals
 /// computes both per-face and per-vertex normals more efficiently then just calling both previous functions
 [[nodiscard]] MRMESH_API MeshNormals computeMeshNormals( const Mesh & mesh );
 
+/// recomputes given normals of all faces incident to changedVerts and of all vertices of these faces,
+/// after the coordinates of changedVerts were modified without any change in mesh topology
+MRMESH_API void updateMeshNormals( const Mesh & mesh, const VertBitSet & changedVerts, MeshNormals & normals );
+
 /// normals in three corner of a triangle
 using TriangleCornerNormals = std::array<Vector3f, 3>;
 /// returns a vector with corner normals in every element for valid mesh faces;
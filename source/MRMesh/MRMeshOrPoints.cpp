@@ -0,0 +1,106 @@
+#include "MRMeshOrPoints.h"
+#include "MRMesh.h"
+#include "MRPointCloud.h"
+#include "MRMeshProject.h"
+#include "MRMeshNormals.h"
+#include "MRPointsProject.h"
+#include "MRGridSampling.h"
+#include "MRClosestPointInTriangle.h"
+#include "MRBox.h"
+
+namespace MR
+{
+
+const VertCoords& MeshOrPoints::points() const
+{
+    if ( auto mp = asMeshPart() )
+        return mp->mesh.points;
+    return asPointCloud()->points;
+}
+
+Box3f MeshOrPoints::computeBoundingBox() const
+{
+    if ( auto mp = asMeshPart() )
+        return mp->mesh.computeBoundingBox( mp->region );
+    return asPointCloud()->getBoundingBox();
+}
+
+VertBitSet MeshOrPoints::gridSampling( float voxelSize ) const
+{
+    if ( auto mp = asMeshPart() )
+        return verticesGridSampling( *mp, voxelSize );
+    return pointGridSampling( *asPointCloud(), voxelSize );
+}
+
+bool MeshOrPoints::hasNormals() const
+{
+    if ( asMeshPart() )
+        return true;
+    const auto& pc = *asPointCloud();
+    return pc.normals.size() >= pc.points.size() || ( normals_ && normals_->size() >= pc.points.size() );
+}
+
+Vector3f MeshOrPoints::normal( VertId v ) const
+{
+    assert( hasNormals() );
+    if ( auto mp = asMeshPart() )
+        return mp->mesh.getNormals().vertNormals[v];
+    const auto& pc = *asPointCloud();
+    return pc.normals.size() >= pc.points.size() ? pc.normals[v] : ( *normals_ )[v];
+}
+
+float MeshOrPoints::weight( VertId v ) const
+{
+    if ( auto mp = asMeshPart() )
+        return mp->mesh.dblArea( v );
+    return 1.0f;
+}
+
+MeshOrPoints::ProjectionResult MeshOrPoints::project( const Vector3f& pt, int hintElem ) const
+{
+    ProjectionResult res;
+    if ( auto mp = asMeshPart() )
+    {
+        const auto& mesh = mp->mesh;
+        const FaceId hintFace( hintElem );
+        MeshProjectionResult mpr;
+        mpr.distSq = FLT_MAX;
+        if ( hintFace && mesh.topology.hasFace( hintFace ) && ( !mp->region || mp->region->test( hintFace ) ) )
+        {
+            Vector3f a, b, c;
+            mesh.getTriPoints( hintFace, a, b, c );
+            const auto [proj, bary] = closestPointInTriangle( pt, a, b, c );
+            mpr.proj = { hintFace, proj };
+            mpr.mtp = MeshTriPoint{ mesh.topology.edgeWithLeft( hintFace ), bary };
+            mpr.distSq = ( proj - pt ).lengthSq();
+        }
+        auto found = findProjection( pt, *mp, mpr.distSq );
+        if ( found.proj.face )
+            mpr = found; // otherwise nothing is closer than the hint face
+        if ( !mpr.proj.face )
+            return res;
+        res.point = mpr.proj.point;
+        res.normal = mesh.getNormals().faceNormals[mpr.proj.face];
+        res.distSq = mpr.distSq;
+        res.elem = mpr.proj.face;
+        res.isBd = mpr.mtp.isBd( mesh.topology );
+        return res;
+    }
+
+    const auto& pc = *asPointCloud();
+    const VertId hintVert( hintElem );
+    float upDistLimitSq = FLT_MAX;
+    if ( hintVert && hintVert < pc.points.size() && pc.validPoints.test( hintVert ) )
+        upDistLimitSq = std::nextafter( ( pc.points[hintVert] - pt ).lengthSq(), FLT_MAX ); // to find the hint point itself
+    const auto found = findProjectionOnPoints( pt, pc, upDistLimitSq );
+    if ( !found.vId )
+        return res;
+    res.point = pc.points[found.vId];
+    if ( hasNormals() )
+        res.normal = normal( found.vId );
+    res.distSq = found.distSq;
+    res.elem = found.vId;
+    return res;
+}
+
+} // namespace MR
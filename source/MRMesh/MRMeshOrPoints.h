@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MRMeshPart.h"
+#include "MRVector3.h"
+#include <cfloat>
+#include <variant>
+
+namespace MR
+{
+
+/// \addtogroup DataModelGroup
+/// \{
+
+/// a reference to either a mesh part or a point cloud,
+/// it allows algorithms like ICP to be written once for both kinds of geometry
+class MeshOrPoints
+{
+public:
+    MeshOrPoints( const Mesh& mesh ) : var_( MeshPart( mesh ) ) { }
+    MeshOrPoints( const MeshPart& mp ) : var_( mp ) { }
+    /// \param normals if the cloud has no own normals, these ones will be used instead
+    MeshOrPoints( const PointCloud& pc, const VertCoords* normals = nullptr ) : var_( &pc ), normals_( normals ) { }
+
+    /// if this object holds a mesh part then returns pointer on it, otherwise returns nullptr
+    [[nodiscard]] const MeshPart* asMeshPart() const { return std::get_if<MeshPart>( &var_ ); }
+    /// if this object holds a point cloud then returns pointer on it, otherwise returns nullptr
+    [[nodiscard]] const PointCloud* asPointCloud() const
+        { auto pp = std::get_if<const PointCloud*>( &var_ ); return pp ? *pp : nullptr; }
+
+    /// returns coordinates of mesh vertices or cloud points
+    [[nodiscard]] MRMESH_API const VertCoords& points() const;
+    /// returns the minimal bounding box containing the mesh region or all valid points
+    [[nodiscard]] MRMESH_API Box3f computeBoundingBox() const;
+    /// subdivides the bounding box on voxels of approximately given size and returns at most one vertex or point per voxel
+    [[nodiscard]] MRMESH_API VertBitSet gridSampling( float voxelSize ) const;
+
+    /// sets the normals to use for a point cloud without own normals
+    void setPointNormals( const VertCoords* normals ) { normals_ = normals; }
+
+    /// returns false for point clouds without normals
+    [[nodiscard]] MRMESH_API bool hasNormals() const;
+    /// returns unit normal in given vertex or point, hasNormals() must be true
+    [[nodiscard]] MRMESH_API Vector3f normal( VertId v ) const;
+    /// returns the importance of given vertex or point: the doubled area of adjacent triangles for meshes, 1 for clouds
+    [[nodiscard]] MRMESH_API float weight( VertId v ) const;
+
+    struct ProjectionResult
+    {
+        /// the closest point on the mesh or the closest point of the cloud
+        Vector3f point;
+        /// the normal in the closest point (the face normal for meshes), zero if the cloud has no normals
+        Vector3f normal;
+        /// squared distance from query point to the closest point
+        float distSq = FLT_MAX;
+        /// the face of the mesh or the point of the cloud, which is the closest; negative if nothing was found
+        int elem = -1;
+        /// true if the closest point is located on mesh boundary
+        bool isBd = false;
+    };
+    /// finds the closest point on the mesh region or among valid points of the cloud
+    /// \param hintElem the element (ProjectionResult::elem) found for a nearby point, e.g. on previous iteration of some algorithm;
+    /// the distance to it bounds the search and makes it much faster
+    [[nodiscard]] MRMESH_API ProjectionResult project( const Vector3f& pt, int hintElem = -1 ) const;
+
+private:
+    std::variant<MeshPart, const PointCloud*> var_;
+    const VertCoords* normals_ = nullptr;
+};
+
+/// \}
+
+} // namespace MR
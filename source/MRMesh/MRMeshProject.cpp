@@ -2,20 +2,25 @@
 #include "MRAABBTree.h"
 #include "MRMesh.h"
 #include "MRClosestPointInTriangle.h"
+#include "MRTriangleBatch.h"
+#include "MRRingIterator.h"
+#include "MRBox.h"
+#include "MRTimer.h"
+#include "MRTorus.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 
 namespace MR
 {
 
-MeshProjectionResult findProjection( const Vector3f & pt, const MeshPart & mp, float upDistLimitSq, const AffineXf3f * xf, float loDistLimitSq )
+// searches for the closest point on mesh closer than res.distSq, which is not modified if nothing is found
+static void findProjectionCloserThan( const Vector3f & pt, const MeshPart & mp, MeshProjectionResult & res, const AffineXf3f * xf, float loDistLimitSq )
 {
     const AABBTree & tree = mp.mesh.getAABBTree();
-
-    MeshProjectionResult res;
-    res.distSq = upDistLimitSq;
     if ( tree.nodes().empty() )
     {
         assert( false );
-        return res;
+        return;
     }
 
     struct SubTask
@@ -90,7 +95,13 @@ MeshProjectionResult findProjection( const Vector3f & pt, const MeshPart & mp, f
         addSubTask( s1 ); // larger distance to look later
         addSubTask( s2 ); // smaller distance to look first
     }
+}
 
+MeshProjectionResult findProjection( const Vector3f & pt, const MeshPart & mp, float upDistLimitSq, const AffineXf3f * xf, float loDistLimitSq )
+{
+    MeshProjectionResult res;
+    res.distSq = upDistLimitSq;
+    findProjectionCloserThan( pt, mp, res, xf, loDistLimitSq );
     return res;
 }
 
@@ -110,4 +121,182 @@ std::optional<SignedDistanceToMeshResult> findSignedDistance( const Vector3f & p
     return res;
 }
 
+// spreads the lower 10 bits of x so that there are two zero bits between each pair of them
+static inline unsigned spreadBits3( unsigned x )
+{
+    x &= 0x3ff;
+    x = ( x | ( x << 16 ) ) & 0x030000ff;
+    x = ( x | ( x << 8 ) ) & 0x0300f00f;
+    x = ( x | ( x << 4 ) ) & 0x030c30c3;
+    x = ( x | ( x << 2 ) ) & 0x09249249;
+    return x;
+}
+
+// returns the indices of the points sorted by their Morton codes in the bounding box of all points
+static std::vector<size_t> mortonOrder( std::span<const Vector3f> pts )
+{
+    MR_TIMER
+    Box3f box;
+    for ( const auto & p : pts )
+        box.include( p );
+    const auto size = box.valid() ? box.size() : Vector3f{};
+    const float maxSize = std::max( { size.x, size.y, size.z } );
+    const float scale = maxSize > 0 ? 1023 / maxSize : 0;
+
+    std::vector<std::pair<unsigned, size_t>> codes( pts.size() );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, pts.size() ), [&]( const tbb::blocked_range<size_t> & range )
+    {
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+        {
+            const auto q = ( pts[i] - box.min ) * scale;
+            codes[i] = { spreadBits3( unsigned( q.x ) ) | ( spreadBits3( unsigned( q.y ) ) << 1 ) | ( spreadBits3( unsigned( q.z ) ) << 2 ), i };
+        }
+    } );
+    std::sort( codes.begin(), codes.end() );
+
+    std::vector<size_t> res( pts.size() );
+    for ( size_t i = 0; i < codes.size(); ++i )
+        res[i] = codes[i].second;
+    return res;
+}
+
+// finds in parallel the projections of all points and passes them to onResult( index, result )
+template<typename F>
+static void findProjectionsInMortonOrder( std::span<const Vector3f> pts, const MeshPart & mp, float upDistLimitSq, const AffineXf3f * xf, F && onResult )
+{
+    MR_TIMER
+    if ( pts.empty() )
+        return;
+    mp.mesh.getAABBTree(); // build the tree before parallel queries
+    const auto order = mortonOrder( pts );
+
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, order.size(), 1024 ), [&]( const tbb::blocked_range<size_t> & range )
+    {
+        // the face closest to the previous point and the faces around it
+        FaceId prevFace;
+        TriangleBatch batch;
+        FaceId batchFaces[TriangleBatch::Size];
+        auto collectBatch = [&]()
+        {
+            batch.clear();
+            auto addFace = [&]( FaceId f )
+            {
+                if ( std::find( batchFaces, batchFaces + batch.count, f ) != batchFaces + batch.count )
+                    return;
+                Vector3f a, b, c;
+                mp.mesh.getTriPoints( f, a, b, c );
+                if ( xf )
+                {
+                    a = ( *xf )( a );
+                    b = ( *xf )( b );
+                    c = ( *xf )( c );
+                }
+                batchFaces[batch.count] = f;
+                batch.add( a, b, c );
+            };
+            addFace( prevFace );
+            VertId vs[3];
+            mp.mesh.topology.getTriVerts( prevFace, vs );
+            for ( auto v : vs )
+            {
+                for ( auto e : orgRing( mp.mesh.topology, v ) )
+                {
+                    if ( batch.full() )
+                        return;
+                    const auto f = mp.mesh.topology.left( e );
+                    if ( f && ( !mp.region || mp.region->test( f ) ) )
+                        addFace( f );
+                }
+            }
+        };
+
+        for ( size_t j = range.begin(); j < range.end(); ++j )
+        {
+            const auto i = order[j];
+            const auto & pt = pts[i];
+            MeshProjectionResult res;
+            res.distSq = upDistLimitSq;
+            if ( prevFace )
+            {
+                // the faces near the previous point are likely close to this one, and give tight initial upper bound
+                const auto hit = closestPointInTriangles( pt, batch );
+                const auto face = batchFaces[hit.index];
+                // the point in the found face is computed as in findProjectionCloserThan to get exactly the same distance
+                const auto [proj, bary] = closestPointInTriangle( pt, batch.vert( hit.index, 0 ), batch.vert( hit.index, 1 ), batch.vert( hit.index, 2 ) );
+                const float distSq = ( proj - pt ).lengthSq();
+                if ( distSq < res.distSq )
+                {
+                    res.distSq = distSq;
+                    res.proj.point = proj;
+                    res.proj.face = face;
+                    res.mtp = MeshTriPoint{ mp.mesh.topology.edgeWithLeft( face ), bary };
+                }
+            }
+            findProjectionCloserThan( pt, mp, res, xf, 0 );
+            if ( res.proj.face && res.proj.face != prevFace )
+            {
+                prevFace = res.proj.face;
+                collectBatch();
+            }
+            onResult( i, res );
+        }
+    } );
+}
+
+std::vector<MeshProjectionResult> findProjections( std::span<const Vector3f> pts, const MeshPart & mp, float upDistLimitSq, const AffineXf3f * xf )
+{
+    MR_TIMER
+    std::vector<MeshProjectionResult> res( pts.size() );
+    findProjectionsInMortonOrder( pts, mp, upDistLimitSq, xf, [&]( size_t i, const MeshProjectionResult & r )
+    {
+        res[i] = r;
+    } );
+    return res;
+}
+
+std::vector<std::optional<SignedDistanceToMeshResult>> findSignedDistances( std::span<const Vector3f> pts, const MeshPart & mp, float upDistLimitSq )
+{
+    MR_TIMER
+    std::vector<std::optional<SignedDistanceToMeshResult>> res( pts.size() );
+    findProjectionsInMortonOrder( pts, mp, upDistLimitSq, nullptr, [&]( size_t i, const MeshProjectionResult & r )
+    {
+        if ( !( r.distSq < upDistLimitSq ) )
+            return;
+        auto & sd = res[i].emplace();
+        sd.proj = r.proj;
+        sd.mtp = r.mtp;
+        sd.dist = mp.mesh.signedDistance( pts[i], r.mtp, mp.region );
+    } );
+    return res;
+}
+
+TEST( MRMesh, FindProjections )
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 32, 32 );
+    std::vector<Vector3f> pts;
+    for ( int i = 0; i < 2000; ++i )
+        pts.emplace_back( 4.0f * std::sin( 0.37f * i ), 4.0f * std::cos( 0.21f * i ), 2.0f * std::sin( 0.13f * i ) );
+
+    const auto xf = AffineXf3f::translation( Vector3f( 0.1f, 0.2f, 0.3f ) );
+    const auto projs = findProjections( pts, torus, FLT_MAX, &xf );
+    const auto limited = findProjections( pts, torus, 0.25f );
+    const auto signedDists = findSignedDistances( pts, torus );
+    ASSERT_EQ( projs.size(), pts.size() );
+    ASSERT_EQ( signedDists.size(), pts.size() );
+    for ( size_t i = 0; i < pts.size(); ++i )
+    {
+        const auto ref = findProjection( pts[i], torus, FLT_MAX, &xf );
+        EXPECT_EQ( projs[i].distSq, ref.distSq );
+        EXPECT_TRUE( projs[i].proj.face.valid() );
+
+        const auto refLimited = findProjection( pts[i], torus, 0.25f );
+        EXPECT_EQ( limited[i].distSq, refLimited.distSq );
+        EXPECT_EQ( limited[i].proj.face.valid(), refLimited.proj.face.valid() );
+
+        const auto refSigned = findSignedDistance( pts[i], torus );
+        ASSERT_TRUE( signedDists[i].has_value() );
+        EXPECT_NEAR( signedDists[i]->dist, refSigned->dist, 1e-6f );
+    }
+}
+
 } //namespace MR
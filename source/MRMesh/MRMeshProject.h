@@ -4,6 +4,8 @@
 #include "MRMeshTriPoint.h"
 #include "MRMeshPart.h"
 #include <cfloat>
+#include <span>
+#include <vector>
 
 namespace MR
 {
@@ -51,6 +53,26 @@ struct SignedDistanceToMeshResult
 MRMESH_API std::optional<SignedDistanceToMeshResult> findSignedDistance( const Vector3f & pt, const MeshPart & mp,
     float upDistLimitSq = FLT_MAX );
 
+/**
+ * \brief computes in parallel the closest points on mesh (or its region) to all given points;
+ * the queries are processed in Morton order of the points, and the face found for the previous point together with its neighbor faces
+ * (tested at once by closestPointInTriangles) gives the initial upper bound for the next one,
+ * so the distances are the same as returned by findProjection, but the face can differ if there are several closest faces
+ * \param upDistLimitSq upper limit on the distance in question, the points farther than it get results with upDistLimitSq and no valid point
+ * \param xf mesh-to-point transformation, if not specified then identity transformation is assumed
+ */
+[[nodiscard]] MRMESH_API std::vector<MeshProjectionResult> findProjections( std::span<const Vector3f> pts, const MeshPart & mp,
+    float upDistLimitSq = FLT_MAX,
+    const AffineXf3f * xf = nullptr );
+
+/**
+ * \brief computes in parallel the closest points on mesh (or its region) to all given points, and the distances with sign to them,
+ * see findProjections for the details
+ * \param upDistLimitSq upper limit on the distance in question, the points farther than it get nullopt
+ */
+[[nodiscard]] MRMESH_API std::vector<std::optional<SignedDistanceToMeshResult>> findSignedDistances( std::span<const Vector3f> pts, const MeshPart & mp,
+    float upDistLimitSq = FLT_MAX );
+
 /// \}
 
 } // namespace MR
@@ -19,7 +19,6 @@ bool relax( Mesh& mesh, const MeshRelaxParams& params, ProgressCallback cb )
         return true;
 
     MR_TIMER;
-    MR_WRITER( mesh );
 
     VertCoords newPoints;
     const VertBitSet& zone = mesh.topology.getVertIds( params.region );
@@ -67,6 +66,8 @@ bool relax( Mesh& mesh, const MeshRelaxParams& params, ProgressCallback cb )
             mesh.points[v] = center / 3.0f;
         } );
     }
+    // instead of MR_WRITER, which drops all caches: only the vertices of the zone were moved
+    mesh.updateCaches( zone );
     return keepGoing;
 }
 
@@ -76,7 +77,6 @@ bool relaxKeepVolume( Mesh& mesh, const MeshRelaxParams& params, ProgressCallbac
         return true;
 
     MR_TIMER;
-    MR_WRITER( mesh );
 
     VertCoords newPoints;
 
@@ -145,6 +145,7 @@ bool relaxKeepVolume( Mesh& mesh, const MeshRelaxParams& params, ProgressCallbac
             mesh.points[v] = center / 3.0f;
         } );
     }
+    mesh.updateCaches( zone );
     return keepGoing;
 }
 
@@ -153,7 +154,6 @@ bool relaxApprox( Mesh& mesh, const MeshApproxRelaxParams& params, ProgressCallb
     if ( params.iterations <= 0 )
         return true;
     MR_TIMER;
-    MR_WRITER( mesh );
 
     float surfaceRadius = ( params.surfaceDilateRadius <= 0.0f ) ?
         ( float( std::sqrt( mesh.area() ) ) * 1e-3f ) : params.surfaceDilateRadius;
@@ -239,6 +239,7 @@ bool relaxApprox( Mesh& mesh, const MeshApproxRelaxParams& params, ProgressCallb
             mesh.points[v] = center / 3.0f;
         } );
     }
+    mesh.updateCaches( zone );
     return keepGoing;
 }
 
@@ -7,6 +7,9 @@
 #include "MRTimer.h"
 #include "MRMeshBuilder.h"
 #include "MRTriMath.h"
+#include "MRAABBTree.h"
+#include "MRTorus.h"
+#include "MRPch/MRTBB.h"
 #include <queue>
 #include "MRGTest.h"
 
@@ -29,7 +32,10 @@ inline bool operator < ( const EdgeLength & a, const EdgeLength & b )
     return a.asPair() < b.asPair();
 }
 
-int subdivideMesh( Mesh & mesh, const SubdivideSettings & settings )
+// serial subdivision of the mesh, which never splits the edges from lockedEdges (if given);
+// as near not subdivided border, the edges of narrow triangles are not split there: otherwise each triangle with long locked edge
+// would always have another long edge to split
+static int subdivideMeshSerial( Mesh & mesh, const SubdivideSettings & settings, const UndirectedEdgeBitSet * lockedEdges = nullptr )
 {
     MR_TIMER;
 
@@ -42,10 +48,29 @@ int subdivideMesh( Mesh & mesh, const SubdivideSettings & settings )
     if ( settings.region )
         *settings.region &= mesh.topology.getValidFaces();
 
+    auto isLocked = [&]( EdgeId e )
+    {
+        return e.undirected() < lockedEdges->size() && lockedEdges->test( e.undirected() );
+    };
+    // whether the edge is locked or belongs to a triangle with a locked edge
+    auto touchesLocked = [&]( EdgeId e )
+    {
+        if ( !lockedEdges )
+            return false;
+        if ( isLocked( e ) )
+            return true;
+        for ( auto ei : { e, e.sym() } )
+            if ( mesh.topology.left( ei ) && ( isLocked( mesh.topology.next( ei ) ) || isLocked( mesh.topology.prev( ei.sym() ) ) ) )
+                return true;
+        return false;
+    };
+
     auto addInQueue = [&]( UndirectedEdgeId e )
     {
+        if ( touchesLocked( e ) )
+            return;
         bool canSubdivide = settings.subdivideBorder ? mesh.topology.isInnerOrBdEdge( e, settings.region ) : mesh.topology.isInnerEdge( e, settings.region );
-        if ( !settings.subdivideBorder && canSubdivide )
+        if ( ( !settings.subdivideBorder || lockedEdges ) && canSubdivide )
         {
             EdgeId eDir = EdgeId( e << 1 );
             auto f = mesh.topology.left( eDir );
@@ -128,6 +153,167 @@ int subdivideMesh( Mesh & mesh, const SubdivideSettings & settings )
     return splitsDone;
 }
 
+// subdivides the parts of the mesh in parallel with locked edges between them, and then the whole mesh serially
+static int subdivideMeshParallel( Mesh & mesh, const SubdivideSettings & settings )
+{
+    MR_TIMER;
+    MR_WRITER( mesh );
+
+    if ( settings.region )
+        *settings.region &= mesh.topology.getValidFaces();
+
+    const auto & tree = mesh.getAABBTree();
+    const auto subroots = tree.getSubtrees( settings.subdivideParts );
+    const auto sz = subroots.size();
+    const int numFaces = settings.region ? int( settings.region->count() ) : mesh.topology.numValidFaces();
+
+    struct alignas(64) SubMesh
+    {
+        Mesh m;
+        VertMap vertSubToFull;
+        FaceBitSet faces; // of full mesh
+        int splitsDone = 0;
+    };
+    std::vector<SubMesh> submeshes( sz );
+
+    const auto mainThreadId = std::this_thread::get_id();
+    std::atomic<bool> cancelled{ false };
+    std::atomic<int> finishedSubmeshes{ 0 };
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, sz, 1 ), [&]( const tbb::blocked_range<size_t>& range )
+    {
+        const bool reportProgressFromThisThread = settings.progressCallback && mainThreadId == std::this_thread::get_id();
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+        {
+            auto reportThreadProgress = [&]( float p )
+            {
+                if ( cancelled.load( std::memory_order_relaxed ) )
+                    return false;
+                if ( reportProgressFromThisThread && !settings.progressCallback( 0.8f * ( finishedSubmeshes.load( std::memory_order_relaxed ) + p ) / sz ) )
+                {
+                    cancelled.store( true, std::memory_order_relaxed );
+                    return false;
+                }
+                return true;
+            };
+            if ( !reportThreadProgress( 0 ) )
+                break;
+
+            auto & submesh = submeshes[i];
+            submesh.faces = tree.getSubtreeFaces( subroots[i] );
+            if ( settings.region )
+                submesh.faces &= *settings.region;
+            const int partFaces = int( submesh.faces.count() );
+            if ( partFaces == 0 )
+                continue;
+
+            EdgeMap edgeSubToFull;
+            PartMapping map;
+            map.tgt2srcVerts = &submesh.vertSubToFull;
+            map.tgt2srcEdges = &edgeSubToFull;
+            submesh.m.addPartByMask( mesh, submesh.faces, map );
+
+            // the edges on the boundary of the part having faces of other parts (or not from the region) on the other side
+            const auto & subTopology = submesh.m.topology;
+            UndirectedEdgeBitSet lockedEdges( subTopology.undirectedEdgeSize() );
+            for ( auto ue : undirectedEdges( subTopology ) )
+            {
+                if ( subTopology.isInnerEdge( ue ) )
+                    continue;
+                const auto fe = edgeSubToFull[ue];
+                if ( mesh.topology.left( fe ) && mesh.topology.right( fe ) )
+                    lockedEdges.set( ue );
+            }
+
+            auto subSettings = settings;
+            subSettings.region = nullptr;
+            subSettings.newVerts = nullptr;
+            subSettings.subdivideParts = 1;
+            subSettings.maxEdgeSplits = int( (long long)settings.maxEdgeSplits * partFaces / std::max( 1, numFaces ) );
+            if ( reportProgressFromThisThread )
+                subSettings.progressCallback = [reportThreadProgress]( float p ) { return reportThreadProgress( p ); };
+            else if ( settings.progressCallback )
+                subSettings.progressCallback = [&cancelled]( float ) { return !cancelled.load( std::memory_order_relaxed ); };
+            submesh.splitsDone = subdivideMeshSerial( submesh.m, subSettings, &lockedEdges );
+            if ( !reportThreadProgress( 1 ) )
+                break;
+            finishedSubmeshes.fetch_add( 1, std::memory_order_relaxed );
+        }
+    } );
+
+    if ( cancelled.load( std::memory_order_relaxed ) || ( settings.progressCallback && !settings.progressCallback( 0.8f ) ) )
+        return 0;
+
+    // recombine mesh from parts, new vertices of parts get new ids after all vertices of the mesh
+    int splitsDone = 0;
+    Triangulation t;
+    FaceBitSet newRegion;
+    FaceBitSet inParts( mesh.topology.faceSize() );
+    for ( const auto & submesh : submeshes )
+    {
+        inParts |= submesh.faces;
+        splitsDone += submesh.splitsDone;
+    }
+    for ( auto f : mesh.topology.getValidFaces() )
+    {
+        if ( inParts.test( f ) )
+            continue;
+        ThreeVertIds tri;
+        mesh.topology.getTriVerts( f, tri );
+        t.push_back( tri );
+    }
+    for ( const auto & submesh : submeshes )
+    {
+        const auto & subTopology = submesh.m.topology;
+        VertMap vertSubToFull = submesh.vertSubToFull;
+        vertSubToFull.resize( subTopology.vertSize() );
+        for ( VertId v( submesh.vertSubToFull.size() ); v < vertSubToFull.size(); ++v )
+        {
+            if ( !subTopology.hasVert( v ) )
+                continue;
+            vertSubToFull[v] = VertId( mesh.points.size() );
+            mesh.points.push_back( submesh.m.points[v] );
+            if ( settings.newVerts )
+                settings.newVerts->autoResizeSet( vertSubToFull[v] );
+        }
+        for ( auto f : subTopology.getValidFaces() )
+        {
+            ThreeVertIds tri;
+            subTopology.getTriVerts( f, tri );
+            for ( int i = 0; i < 3; ++i )
+                tri[i] = vertSubToFull[tri[i]];
+            t.push_back( tri );
+            if ( settings.region )
+                newRegion.autoResizeSet( t.backId() );
+        }
+    }
+    mesh.topology = MeshBuilder::fromTriangles( t );
+    mesh.invalidateCaches();
+    if ( settings.region )
+    {
+        newRegion.resize( mesh.topology.faceSize() );
+        *settings.region = std::move( newRegion );
+    }
+
+    if ( settings.progressCallback && !settings.progressCallback( 0.85f ) )
+        return splitsDone;
+
+    // final pass over the edges between parts
+    auto seamSettings = settings;
+    seamSettings.maxEdgeSplits = settings.maxEdgeSplits - splitsDone;
+    if ( settings.progressCallback )
+        seamSettings.progressCallback = [cb = settings.progressCallback]( float p ) { return cb( 0.85f + 0.15f * p ); };
+    if ( seamSettings.maxEdgeSplits > 0 )
+        splitsDone += subdivideMeshSerial( mesh, seamSettings );
+    return splitsDone;
+}
+
+int subdivideMesh( Mesh & mesh, const SubdivideSettings & settings )
+{
+    if ( settings.subdivideParts > 1 && !settings.onVertCreated )
+        return subdivideMeshParallel( mesh, settings );
+    return subdivideMeshSerial( mesh, settings );
+}
+
 TEST(MRMesh, SubdivideMesh) 
 {
     std::vector<VertId> v{ 
@@ -162,4 +348,33 @@ TEST(MRMesh, SubdivideMesh)
     EXPECT_TRUE( region.count() * 2 - 3 > mesh.topology.numValidFaces() );
 }
 
+TEST(MRMesh, SubdivideMeshParallel)
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 32, 32 );
+    SubdivideSettings settings;
+    settings.maxEdgeLen = 0.1f;
+    settings.maxEdgeSplits = 10'000'000;
+
+    Mesh serial = torus;
+    const int serialSplits = subdivideMesh( serial, settings );
+
+    Mesh parallel = torus;
+    FaceBitSet region = torus.topology.getValidFaces();
+    VertBitSet newVerts;
+    settings.region = &region;
+    settings.newVerts = &newVerts;
+    settings.subdivideParts = 16;
+    const int parallelSplits = subdivideMesh( parallel, settings );
+
+    EXPECT_TRUE( parallel.topology.checkValidity() );
+    EXPECT_TRUE( parallel.topology.isClosed() );
+    EXPECT_EQ( parallel.topology.numValidVerts(), torus.topology.numValidVerts() + parallelSplits );
+    EXPECT_EQ( int( newVerts.count() ), parallelSplits );
+    EXPECT_EQ( region, parallel.topology.getValidFaces() );
+    EXPECT_NEAR( double( parallelSplits ), double( serialSplits ), 0.1 * serialSplits );
+    for ( auto e : undirectedEdges( parallel.topology ) )
+        EXPECT_LT( parallel.edgeLength( e ), settings.maxEdgeLen );
+    EXPECT_NEAR( parallel.area(), serial.area(), 1e-3 * serial.area() );
+}
+
 } // namespace MR
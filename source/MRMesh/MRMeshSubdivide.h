@@ -38,6 +38,11 @@ struct SubdivideSettings
     std::function<void(VertId)> onVertCreated;
     /// callback to report algorithm progress and cancel it by user request
     ProgressCallback progressCallback = {};
+    /// if greater than 1, then the mesh is split on at least this number of parts (subtrees of AABB tree),
+    /// which are subdivided in parallel keeping the edges between parts, and then the remaining long edges are subdivided in the final serial pass;
+    /// maxEdgeSplits is distributed between the parts proportionally to their number of faces;
+    /// the subdivision is always serial if onVertCreated is given
+    int subdivideParts = 1;
 };
 
 /// Split edges in mesh region according to the settings;\n
@@ -11,7 +11,7 @@ PointCloud meshToPointCloud( const Mesh& mesh, bool saveNormals /*= true */, con
     res.points = mesh.points;
     res.validPoints = mesh.topology.getVertIds( verts );
     if(saveNormals)
-        res.normals = computePerVertNormals( mesh );
+        res.normals = mesh.getNormals().vertNormals;
     return res;
 }
 
@@ -0,0 +1,226 @@
+#include "MRMultiwayICP.h"
+#include "MRPointCloud.h"
+#include "MRPointCloudMakeNormals.h"
+#include "MRBox.h"
+#include "MRQuaternion.h"
+#include "MRToFromEigen.h"
+#include "MRTorus.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace MR
+{
+
+namespace
+{
+
+// the result of pairwise ICP: the floating object in the frame of reference object
+struct PairConstraint
+{
+    int flt = -1;
+    int ref = -1;
+    AffineXf3d fltToRef;
+    // corners of the box of matched points of floating object in its local coordinates
+    std::array<Vector3d, 8> samples;
+    double weight = 0;
+};
+
+Matrix3d skew( const Vector3d& v )
+{
+    return Matrix3d( { 0, -v.z, v.y }, { v.z, 0, -v.x }, { -v.y, v.x, 0 } );
+}
+
+// finds world transformations of all objects minimizing the sum over constraints of squared distances
+// between samples transformed by floating object xf and by reference object xf combined with measured relative xf
+void optimizePoseGraph( std::vector<AffineXf3d>& xfs, const std::vector<PairConstraint>& constraints, int anchor, int iterLimit )
+{
+    MR_TIMER;
+    const int n = int( xfs.size() );
+    // index of first unknown of each object, the anchor has no unknowns
+    auto var = [anchor] ( int obj ) { return 6 * ( obj < anchor ? obj : obj - 1 ); };
+    const int numVars = 6 * ( n - 1 );
+    if ( numVars <= 0 || constraints.empty() )
+        return;
+
+    // rotations are linearized around this point to keep the system well conditioned
+    Vector3d center;
+    for ( const auto& xf : xfs )
+        center += xf.b;
+    center /= double( n );
+
+    for ( int iter = 0; iter < iterLimit; ++iter )
+    {
+        Eigen::MatrixXd H = Eigen::MatrixXd::Zero( numVars, numVars );
+        Eigen::VectorXd g = Eigen::VectorXd::Zero( numVars );
+        for ( const auto& c : constraints )
+        {
+            const auto& xfFlt = xfs[c.flt];
+            const auto xfRef = xfs[c.ref] * c.fltToRef;
+            for ( const auto& s : c.samples )
+            {
+                const auto a = xfFlt( s ) - center;
+                const auto b = xfRef( s ) - center;
+                // residual a - b, its derivatives by small rotation w and translation t of each object
+                const auto r = toEigen( a - b );
+                Eigen::Matrix<double, 3, 6> Ja, Jb;
+                Ja << toEigen( skew( -a ) ), Eigen::Matrix3d::Identity();
+                Jb << toEigen( skew( b ) ), -Eigen::Matrix3d::Identity();
+                if ( c.flt != anchor )
+                {
+                    H.block<6, 6>( var( c.flt ), var( c.flt ) ) += c.weight * Ja.transpose() * Ja;
+                    g.segment<6>( var( c.flt ) ) += c.weight * Ja.transpose() * r;
+                }
+                if ( c.ref != anchor )
+                {
+                    H.block<6, 6>( var( c.ref ), var( c.ref ) ) += c.weight * Jb.transpose() * Jb;
+                    g.segment<6>( var( c.ref ) ) += c.weight * Jb.transpose() * r;
+                }
+                if ( c.flt != anchor && c.ref != anchor )
+                {
+                    const Eigen::Matrix<double, 6, 6> Hab = c.weight * Ja.transpose() * Jb;
+                    H.block<6, 6>( var( c.flt ), var( c.ref ) ) += Hab;
+                    H.block<6, 6>( var( c.ref ), var( c.flt ) ) += Hab.transpose();
+                }
+            }
+        }
+        // small damping keeps the objects not connected with the anchor at their places
+        const double damping = 1e-9 * std::max( H.diagonal().maxCoeff(), 1.0 );
+        H.diagonal().array() += damping;
+        const Eigen::VectorXd dx = H.ldlt().solve( -g );
+
+        double maxStep = 0;
+        for ( int obj = 0; obj < n; ++obj )
+        {
+            if ( obj == anchor )
+                continue;
+            const auto w = fromEigen( Eigen::Vector3d( dx.segment<3>( var( obj ) ) ) );
+            const auto t = fromEigen( Eigen::Vector3d( dx.segment<3>( var( obj ) + 3 ) ) );
+            const auto step = AffineXf3d::translation( center ) * AffineXf3d( Matrix3d( Quaternion<double>( w, w.length() ) ), t )
+                * AffineXf3d::translation( -center );
+            xfs[obj] = step * xfs[obj];
+            maxStep = std::max( { maxStep, w.length(), t.length() } );
+        }
+        if ( maxStep < 1e-9 )
+            break;
+    }
+}
+
+} // anonymous namespace
+
+tl::expected<std::vector<AffineXf3f>, std::string> multiwayICP( const std::vector<MeshOrPoints>& inObjs,
+    const std::vector<AffineXf3f>& xfs, const MultiwayICPParams& params )
+{
+    MR_TIMER;
+    assert( inObjs.size() == xfs.size() );
+    const int n = int( inObjs.size() );
+    if ( n < 2 || params.anchorObject < 0 || params.anchorObject >= n )
+        return xfs;
+
+    // compute missing normals of point clouds once instead of in each pairwise run
+    std::vector<MeshOrPoints> objs = inObjs;
+    std::vector<VertCoords> cloudNormals( n );
+    std::vector<size_t> numSamples( n );
+    tbb::parallel_for( 0, n, [&] ( int i )
+    {
+        numSamples[i] = objs[i].gridSampling( params.samplingVoxelSize ).count();
+        if ( objs[i].hasNormals() )
+            return;
+        cloudNormals[i] = makeNormals( *objs[i].asPointCloud() );
+        objs[i].setPointNormals( &cloudNormals[i] );
+    } );
+
+    // find pairs of objects with close bounding boxes
+    std::vector<Box3f> worldBoxes( n );
+    for ( int i = 0; i < n; ++i )
+        worldBoxes[i] = transformed( objs[i].computeBoundingBox(), xfs[i] );
+    const float maxBoxDist = params.maxBoxDistance >= 0 ? params.maxBoxDistance : std::sqrt( params.icpProps.distTresholdSq );
+    std::vector<std::pair<int, int>> pairs;
+    for ( int i = 0; i < n; ++i )
+        for ( int j = i + 1; j < n; ++j )
+            if ( worldBoxes[i].valid() && worldBoxes[j].valid() && worldBoxes[i].getDistanceSq( worldBoxes[j] ) <= sqr( maxBoxDist ) )
+                pairs.emplace_back( i, j );
+
+    // pairwise registrations in parallel
+    std::vector<PairConstraint> constraints( pairs.size() );
+    const auto mainThreadId = std::this_thread::get_id();
+    std::atomic<bool> cancelled{ false };
+    std::atomic<int> finishedPairs{ 0 };
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, pairs.size(), 1 ), [&] ( const tbb::blocked_range<size_t>& range )
+    {
+        for ( size_t p = range.begin(); p < range.end(); ++p )
+        {
+            if ( cancelled.load( std::memory_order_relaxed ) )
+                return;
+            const auto [i, j] = pairs[p];
+            MeshICP icp( objs[i], objs[j], xfs[i], xfs[j], params.samplingVoxelSize );
+            icp.setParams( params.icpProps );
+            const auto xf = icp.calculateTransformation();
+
+            const auto& vertPairs = icp.getVertPairs();
+            auto& c = constraints[p];
+            if ( !vertPairs.empty() && vertPairs.size() >= params.minOverlapRatio * numSamples[i] )
+            {
+                Box3d box;
+                for ( const auto& vp : vertPairs )
+                    box.include( Vector3d( objs[i].points()[vp.vertId] ) );
+                c.flt = i;
+                c.ref = j;
+                c.fltToRef = AffineXf3d( xfs[j] ).inverse() * AffineXf3d( xf );
+                c.samples = getCorners( box );
+                c.weight = double( vertPairs.size() ) / 8;
+            }
+
+            ++finishedPairs;
+            if ( params.cb && mainThreadId == std::this_thread::get_id()
+                && !params.cb( 0.9f * float( finishedPairs.load( std::memory_order_relaxed ) ) / pairs.size() ) )
+                cancelled.store( true, std::memory_order_relaxed );
+        }
+    } );
+    if ( cancelled )
+        return tl::make_unexpected( "Operation was canceled." );
+    constraints.erase( std::remove_if( constraints.begin(), constraints.end(), [] ( const PairConstraint& c ) { return c.flt < 0; } ),
+        constraints.end() );
+
+    // global optimization of all transformations
+    std::vector<AffineXf3d> resXfs( n );
+    for ( int i = 0; i < n; ++i )
+        resXfs[i] = AffineXf3d( xfs[i] );
+    optimizePoseGraph( resXfs, constraints, params.anchorObject, params.globalIterLimit );
+
+    if ( params.cb && !params.cb( 1.0f ) )
+        return tl::make_unexpected( "Operation was canceled." );
+
+    std::vector<AffineXf3f> res( n );
+    for ( int i = 0; i < n; ++i )
+        res[i] = AffineXf3f( resXfs[i] );
+    return res;
+}
+
+TEST( MRMesh, MultiwayICP )
+{
+    const Mesh torus = makeTorus( 1.0f, 0.3f, 64, 32 );
+    std::vector<MeshOrPoints> objs( 3, MeshOrPoints( torus ) );
+    std::vector<AffineXf3f> xfs = {
+        AffineXf3f(),
+        AffineXf3f::translation( Vector3f( 0.03f, -0.02f, 0.01f ) ),
+        AffineXf3f( Matrix3f::rotation( Vector3f( 1, 1, 0 ).normalized(), 0.04f ), Vector3f( -0.02f, 0.0f, 0.02f ) )
+    };
+    MultiwayICPParams params;
+    params.samplingVoxelSize = 0.02f;
+    params.icpProps.iterLimit = 20;
+    auto res = multiwayICP( objs, xfs, params );
+    ASSERT_TRUE( res.has_value() );
+    ASSERT_EQ( res->size(), 3 );
+    for ( const auto& xf : *res )
+    {
+        // torus center is invariant to the rotation around its axis
+        EXPECT_LT( xf( Vector3f() ).length(), 1e-2f );
+    }
+}
+
+} // namespace MR
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "MRICP.h"
+#include "MRProgressCallback.h"
+#include <tl/expected.hpp>
+#include <string>
+
+namespace MR
+{
+
+struct MultiwayICPParams
+{
+    // parameters of each pairwise ICP run
+    ICPProperties icpProps;
+    // voxel size for the sampling of floating object in each pairwise ICP run, see MeshICP constructor
+    float samplingVoxelSize = 0;
+    // two objects are considered as possibly overlapping if the distance between their world bounding boxes is at most this value;
+    // negative value means sqrt( icpProps.distTresholdSq )
+    float maxBoxDistance = -1;
+    // the pair of objects is used in global optimization only if this fraction of floating samples found their pairs on reference object
+    float minOverlapRatio = 0.1f;
+    // maximal number of Gauss-Newton iterations in global pose-graph optimization
+    int globalIterLimit = 10;
+    // the transformation of this object is not changed, all other objects are aligned to it
+    int anchorObject = 0;
+    ProgressCallback cb;
+};
+
+// registers several overlapping objects (meshes or point clouds) simultaneously:
+// finds overlapping pairs by their bounding boxes, runs pairwise ICP for all pairs in parallel,
+// then finds all transformations at once by minimization of relative transformation errors in the graph of pairs;
+// \param xfs initial world transformations of objects
+// \return new world transformations of objects, or error if the operation was canceled
+MRMESH_API tl::expected<std::vector<AffineXf3f>, std::string> multiwayICP( const std::vector<MeshOrPoints>& objs,
+    const std::vector<AffineXf3f>& xfs, const MultiwayICPParams& params = {} );
+
+}
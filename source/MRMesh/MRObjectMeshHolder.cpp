@@ -1,6 +1,7 @@
 #include "MRObjectMeshHolder.h"
 #include "MRObjectFactory.h"
 #include "MRMesh.h"
+#include "MRMeshNormals.h"
 #include "MRMeshComponents.h"
 #include "MRMeshSave.h"
 #include "MRSerializer.h"
@@ -149,7 +150,7 @@ Vector<MR::Vector3f, MR::VertId> ObjectMeshHolder::computeVertsNormals_() const
 {
     if ( !mesh_ )
         return {};
-    return computePerVertNormals( *mesh_ );
+    return mesh_->getNormals().vertNormals;
 }
 
 const ViewportMask& ObjectMeshHolder::getVisualizePropertyMask( unsigned type ) const
@@ -35,6 +35,18 @@ void ObjectVoxels::construct( const SimpleVolume& volume, const ProgressCallback
     updateHistogram_( volume.min, volume.max );
 }
 
+void ObjectVoxels::construct( const SimpleVolumeU16& volume, const ProgressCallback& cb )
+{
+    mesh_.reset();
+    grid_ = simpleVolumeToDenseGrid( volume, cb );
+    dimensions_ = volume.dims;
+    indexer_ = VolumeIndexer( dimensions_ );
+    activeBox_ = Box3i( Vector3i(), dimensions_ );
+    voxelSize_ = volume.voxelSize;
+    reverseVoxelSize_ = { 1 / voxelSize_.x,1 / voxelSize_.y,1 / voxelSize_.z };
+    updateHistogram_( volume );
+}
+
 void ObjectVoxels::construct( const FloatGrid& grid, const Vector3f& voxelSize, const ProgressCallback& cb )
 {
     if ( !grid )
@@ -277,6 +289,24 @@ void ObjectVoxels::updateHistogram_( float min, float max )
     histogram_ = std::move( calc.hist );
 }
 
+void ObjectVoxels::updateHistogram_( const SimpleVolumeU16& volume )
+{
+    MR_TIMER;
+    histogram_ = tbb::parallel_reduce( tbb::blocked_range<size_t>( 0, volume.data.size() ),
+        Histogram( volume.min, volume.max, cVoxelsHistogramBinsNumber ),
+        [&] ( const tbb::blocked_range<size_t>& range, Histogram hist )
+    {
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+            hist.addSample( volume.value( i ) );
+        return hist;
+    },
+        [] ( Histogram a, const Histogram& b )
+    {
+        a.addHistogram( b );
+        return a;
+    } );
+}
+
 void ObjectVoxels::setDefaultColors_()
 {
     setFrontColor( SceneColors::get( SceneColors::SelectedObjectVoxels ) );
@@ -48,6 +48,10 @@ public:
 
     /// Clears all internal data and then creates grid and calculates histogram
     MRMESH_API void construct( const SimpleVolume& volume, const ProgressCallback& cb = {} );
+    /// Clears all internal data and then creates grid and calculates histogram directly from compact volume,
+    /// the grid is filled by slabs so no intermediate float volume is made;
+    /// the compact volume is not kept: iso-surface, slices and histogram updates use the float grid
+    MRMESH_API void construct( const SimpleVolumeU16& volume, const ProgressCallback& cb = {} );
     /// Clears all internal data and calculates histogram
     MRMESH_API void construct( const FloatGrid& grid, const Vector3f& voxelSize, const ProgressCallback& cb = {} );
     /// Updates histogram, by stored grid (evals min and max values from grid)
@@ -119,6 +123,7 @@ private:
     Vector3f reverseVoxelSize_;
 
     void updateHistogram_( float min, float max );
+    void updateHistogram_( const SimpleVolumeU16& volume );
 
 
     /// this is private function to set default colors of this type (ObjectVoxels) in constructor only
@@ -9,6 +9,7 @@
 #include "MRTimer.h"
 #include "MRPlane3.h"
 #include "MRPointCloudRadius.h"
+#include "MRPointNeighbors.h"
 #include <cfloat>
 #include <queue>
 
@@ -30,25 +31,19 @@ bool operator < ( const NormalCandidate& l, const NormalCandidate& r )
     return l.weight > r.weight;
 }
 
-VertCoords makeNormals( const PointCloud& pointCloud, int avgNeighborhoodSize )
+/// makes normals using given function to enumerate neighbors of a point (excluding the point itself)
+template <typename ForEachNeighbor>
+VertCoords makeNormalsT( const PointCloud& pointCloud, ForEachNeighbor&& forEachNeighbor )
 {
-    MR_TIMER;
-
     VertCoords normals( pointCloud.points.size() );
-    const auto& tree = pointCloud.getAABBTree();
-    AABBTreePoints::NodeId nodeId = tree.rootNodeId();
-    while ( !tree[nodeId].leaf() )
-        nodeId = tree[nodeId].leftOrFirst;
-
-    auto firstLeafRadius = findAvgPointsRadius( pointCloud, avgNeighborhoodSize );
 
     BitSetParallelFor( pointCloud.validPoints, [&]( VertId vid )
     {
         PointAccumulator accum;
-        findPointsInBall( pointCloud, pointCloud.points[vid], firstLeafRadius, 
-                          [&]( VertId, const Vector3f& coord )
+        accum.addPoint( Vector3d( pointCloud.points[vid] ) );
+        forEachNeighbor( vid, [&]( VertId v )
         {
-            accum.addPoint( Vector3d( coord ) );
+            accum.addPoint( Vector3d( pointCloud.points[v] ) );
         } );
         normals[vid] = Vector3f( accum.getBestPlane().n ).normalized();
     } );
@@ -64,11 +59,8 @@ VertCoords makeNormals( const PointCloud& pointCloud, int avgNeighborhoodSize )
 
     auto enqueueNeighbors = [&]( VertId base )
     {
-        findPointsInBall( pointCloud, pointCloud.points[base], firstLeafRadius,
-                          [&]( VertId v, const Vector3f& )
+        forEachNeighbor( base, [&]( VertId v )
         {
-            if ( v == base )
-                return;
             float weight = enweight( base, v );
             if ( weight < minWeights[v] )
             {
@@ -110,4 +102,28 @@ VertCoords makeNormals( const PointCloud& pointCloud, int avgNeighborhoodSize )
     return normals;
 }
 
+VertCoords makeNormals( const PointCloud& pointCloud, int avgNeighborhoodSize )
+{
+    MR_TIMER;
+    const auto radius = findAvgPointsRadius( pointCloud, avgNeighborhoodSize );
+    return makeNormalsT( pointCloud, [&]( VertId base, auto&& callback )
+    {
+        findPointsInBall( pointCloud, pointCloud.points[base], radius, [&]( VertId v, const Vector3f& )
+        {
+            if ( v != base )
+                callback( v );
+        } );
+    } );
+}
+
+VertCoords makeNormals( const PointCloud& pointCloud, const PointNeighbors& neighbors )
+{
+    MR_TIMER;
+    return makeNormalsT( pointCloud, [&]( VertId base, auto&& callback )
+    {
+        for ( auto v : neighbors.neighbors( base ) )
+            callback( v );
+    } );
+}
+
 }
@@ -12,4 +12,9 @@ struct PointCloud;
 /// \ingroup PointCloudGroup
 MRMESH_API VertCoords makeNormals( const PointCloud& pointCloud, 
                                    int avgNeighborhoodSize = 3 * AABBTreePoints::MaxNumPointsInLeaf );
-}
\ No newline at end of file
+
+/// \brief Makes consistent normals for valid points of given point cloud
+/// \param neighbors precomputed neighbors of each valid point, e.g. by findNearestNeighbors
+/// \ingroup PointCloudGroup
+MRMESH_API VertCoords makeNormals( const PointCloud& pointCloud, const PointNeighbors& neighbors );
+}
@@ -3,6 +3,7 @@
 #include "MRTimer.h"
 #include "MRBitSetParallelFor.h"
 #include "MRPointsInBall.h"
+#include "MRPointNeighbors.h"
 #include "MRBox.h"
 #include "MRBestFit.h"
 #include "MRBestFitQuadric.h"
@@ -11,6 +12,23 @@
 namespace MR
 {
 
+/// calls callback( VertId, const Vector3f& ) for each neighbor of point v (excluding v itself)
+template <typename F>
+void forEachNeighbor( const PointCloud& pointCloud, const PointCloudRelaxParams& params, float radius, VertId v, F&& callback )
+{
+    if ( params.neighbors )
+    {
+        for ( auto nv : params.neighbors->neighbors( v ) )
+            callback( nv, pointCloud.points[nv] );
+        return;
+    }
+    findPointsInBall( pointCloud, pointCloud.points[v], radius, [&] ( VertId nv, const Vector3f& position )
+    {
+        if ( nv != v )
+            callback( nv, position );
+    } );
+}
+
 bool relax( PointCloud& pointCloud, const PointCloudRelaxParams& params /*= {} */, ProgressCallback cb )
 {
     if ( params.iterations <= 0 )
@@ -41,14 +59,10 @@ bool relax( PointCloud& pointCloud, const PointCloudRelaxParams& params /*= {} *
         {
             Vector3d sumPos;
             int count = 0;
-            findPointsInBall( pointCloud, pointCloud.points[v], radius,
-                [&] ( VertId newV, const Vector3f& position )
+            forEachNeighbor( pointCloud, params, radius, v, [&] ( VertId, const Vector3f& position )
             {
-                if ( newV != v )
-                {
-                    sumPos += Vector3d( position );
-                    count++;
-                }
+                sumPos += Vector3d( position );
+                count++;
             } );
             if ( count == 0 )
                 return;
@@ -102,14 +116,10 @@ bool relaxKeepVolume( PointCloud& pointCloud, const PointCloudRelaxParams& param
             Vector3d sumPos;
             auto& neighs = neighbors[v];
             neighs.clear();
-            findPointsInBall( pointCloud, pointCloud.points[v], radius,
-                [&] ( VertId newV, const Vector3f& position )
+            forEachNeighbor( pointCloud, params, radius, v, [&] ( VertId newV, const Vector3f& position )
             {
-                if ( newV != v )
-                {
-                    neighs.push_back( newV );
-                    sumPos += Vector3d( position );
-                }
+                neighs.push_back( newV );
+                sumPos += Vector3d( position );
             } );
             if ( neighs.empty() )
                 return;
@@ -168,8 +178,7 @@ bool relaxApprox( PointCloud& pointCloud, const PointCloudApproxRelaxParams& par
             PointAccumulator accum;
             std::vector<std::pair<VertId, double>> weightedNeighbors;
 
-            findPointsInBall( pointCloud, pointCloud.points[v], radius,
-                [&] ( VertId newV, const Vector3f& position )
+            auto addNeighbor = [&] ( VertId newV, const Vector3f& position )
             {
                 double w = 1.0;
                 if ( hasNormals )
@@ -179,7 +188,14 @@ bool relaxApprox( PointCloud& pointCloud, const PointCloudApproxRelaxParams& par
                     weightedNeighbors.push_back( { newV,w } );
                     accum.addPoint( Vector3d( position ), w );
                 }
-            } );
+            };
+            if ( params.neighbors )
+            {
+                addNeighbor( v, pointCloud.points[v] );
+                forEachNeighbor( pointCloud, params, radius, v, addNeighbor );
+            }
+            else
+                findPointsInBall( pointCloud, pointCloud.points[v], radius, addNeighbor );
             if ( weightedNeighbors.size() < 6 )
                 return;
 
@@ -14,6 +14,9 @@ struct PointCloudRelaxParams : RelaxParams
     /// radius to find neighbors in,
     /// 0.0 - default, 0.1*boundibg box diagonal
     float neighborhoodRadius{ 0.0f };
+    /// if given, these precomputed neighbors (see findNearestNeighbors) are used on all iterations
+    /// instead of searching points in the ball of neighborhoodRadius on every iteration
+    const PointNeighbors* neighbors{ nullptr };
 };
 
 /// applies given number of relaxation iterations to the whole pointCloud ( or some region if it is specified )
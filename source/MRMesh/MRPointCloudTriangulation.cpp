@@ -4,6 +4,7 @@
 #include "MRId.h"
 #include "MRPointCloudRadius.h"
 #include "MRPointCloudMakeNormals.h"
+#include "MRPointNeighbors.h"
 #include "MRBitSetParallelFor.h"
 #include "MRMeshDelone.h"
 #include "MRMeshBuilder.h"
@@ -14,11 +15,193 @@
 #include "MRVector3.h"
 #include "MRTimer.h"
 #include "MRPointCloudTriangulationHelpers.h"
+#include "MRAABBTreePoints.h"
+#include "MRSphere.h"
+#include "MRMesh.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 #include <parallel_hashmap/phmap.h>
+#include <atomic>
+#include <thread>
 
 namespace MR
 {
 
+struct VertTriplet
+{
+    VertTriplet( VertId _a, VertId _b, VertId _c ) :
+        a{_a}, b{_b}, c{_c}
+    {
+        if ( b < a && b < c )
+        {
+            std::swap( a, b );
+            std::swap( b, c );
+        }
+        else if ( c < a && c < b )
+        {
+            std::swap( a, c );
+            std::swap( b, c );
+        }
+    }
+    VertId a, b, c;
+};
+
+bool operator==( const VertTriplet& a, const VertTriplet& b )
+{
+    return( a.a == b.a && a.b == b.b && a.c == b.c );
+}
+
+bool operator<( const VertTriplet& a, const VertTriplet& b )
+{
+    return std::tie( a.a, a.b, a.c ) < std::tie( b.a, b.b, b.c );
+}
+
+struct VertTripletHasher
+{
+    size_t operator()( const VertTriplet& triplet ) const
+    {
+        auto h1 = std::hash<int>{}(int( triplet.a ));
+        auto h2 = std::hash<int>{}(int( triplet.b ));
+        auto h3 = std::hash<int>{}(int( triplet.c ));
+        return h1 ^ (h2 << 1) ^ (h3 << 3);
+    }
+};
+
+using TripletMap = phmap::flat_hash_map<VertTriplet, int, VertTripletHasher>;
+
+// adds the triangles of local triangulation of v in the map, if they are accepted by given predicate
+template<typename Accept>
+void voteFan( VertId v, const TriangulationHelpers::TriangulatedFan& fan, TripletMap& map, Accept&& accept )
+{
+    for ( auto it = fan.optimized.begin(); it != fan.optimized.end(); ++it )
+    {
+        if ( fan.border.valid() && *it == fan.border )
+            continue;
+
+        auto next = std::next( it );
+        if ( next == fan.optimized.end() )
+            next = fan.optimized.begin();
+
+        VertTriplet triplet{ v,*next,*it };
+        if ( !accept( triplet ) )
+            continue;
+        auto mIt = map.find( triplet );
+        if ( mIt == map.end() )
+            map[triplet] = 1;
+        else
+            ++mIt->second;
+    }
+}
+
+// the subtree of AABB tree of points, which points are triangulated together
+struct PointsTile
+{
+    AABBTreePoints::NodeId node;
+    int firstPoint = 0;
+    int lastPoint = 0;
+};
+
+// returns the range of ordered points in the subtree of given node
+std::pair<int, int> subtreePointRange( const AABBTreePoints& tree, AABBTreePoints::NodeId n )
+{
+    auto first = n, last = n;
+    while ( !tree[first].leaf() )
+        first = tree[first].leftOrFirst;
+    while ( !tree[last].leaf() )
+        last = tree[last].rightOrLast;
+    return { tree[first].getLeafPointRange().first, tree[last].getLeafPointRange().second };
+}
+
+// returns the box of the subtree expanded on given margin in all directions
+Box3f expandedNodeBox( const AABBTreePoints& tree, AABBTreePoints::NodeId n, float margin )
+{
+    auto box = tree[n].box;
+    box.min -= Vector3f::diagonal( margin );
+    box.max += Vector3f::diagonal( margin );
+    return box;
+}
+
+// calls given function for each point of the tree inside the box
+template<typename F>
+void forEachPointInBox( const AABBTreePoints& tree, const Box3f& box, F&& f )
+{
+    const auto& orderedPoints = tree.orderedPoints();
+    std::vector<AABBTreePoints::NodeId> subtasks{ tree.rootNodeId() };
+    while ( !subtasks.empty() )
+    {
+        const auto& node = tree[subtasks.back()];
+        subtasks.pop_back();
+        if ( !box.intersects( node.box ) )
+            continue;
+        if ( node.leaf() )
+        {
+            const auto [first, last] = node.getLeafPointRange();
+            for ( int i = first; i < last; ++i )
+                if ( box.contains( orderedPoints[i].coord ) )
+                    f( orderedPoints[i].id );
+            continue;
+        }
+        subtasks.push_back( node.rightOrLast );
+        subtasks.push_back( node.leftOrFirst );
+    }
+}
+
+// returns the number of points of the tree inside the box
+int countPointsInBox( const AABBTreePoints& tree, const Box3f& box )
+{
+    const auto& orderedPoints = tree.orderedPoints();
+    int res = 0;
+    std::vector<AABBTreePoints::NodeId> subtasks{ tree.rootNodeId() };
+    while ( !subtasks.empty() )
+    {
+        const auto n = subtasks.back();
+        subtasks.pop_back();
+        const auto& node = tree[n];
+        if ( !box.intersects( node.box ) )
+            continue;
+        if ( box.contains( node.box.min ) && box.contains( node.box.max ) )
+        {
+            const auto [first, last] = subtreePointRange( tree, n );
+            res += last - first;
+            continue;
+        }
+        if ( node.leaf() )
+        {
+            const auto [first, last] = node.getLeafPointRange();
+            for ( int i = first; i < last; ++i )
+                if ( box.contains( orderedPoints[i].coord ) )
+                    ++res;
+            continue;
+        }
+        subtasks.push_back( node.rightOrLast );
+        subtasks.push_back( node.leftOrFirst );
+    }
+    return res;
+}
+
+// splits the points on the subtrees of AABB tree, so that each subtree together with the points within the margin around it
+// has at most maxTilePoints points (unless the subtree is a single leaf)
+std::vector<PointsTile> splitPointsInTiles( const AABBTreePoints& tree, float margin, int maxTilePoints )
+{
+    MR_TIMER;
+    std::vector<PointsTile> tiles;
+    std::vector<AABBTreePoints::NodeId> stack{ tree.rootNodeId() };
+    while ( !stack.empty() )
+    {
+        const auto n = stack.back();
+        stack.pop_back();
+        const auto [first, last] = subtreePointRange( tree, n );
+        if ( tree[n].leaf() || ( last - first <= maxTilePoints && countPointsInBox( tree, expandedNodeBox( tree, n, margin ) ) <= maxTilePoints ) )
+        {
+            tiles.push_back( { n, first, last } );
+            continue;
+        }
+        stack.push_back( tree[n].rightOrLast );
+        stack.push_back( tree[n].leftOrFirst ); // to process it first
+    }
+    return tiles;
+}
+
 class PointCloudTriangulator
 {
 public:
@@ -27,14 +210,32 @@ public:
     std::optional<Mesh> triangulate( ProgressCallback progressCb );
 
 private:
+    // finds the radius of local triangulations, the neighbors and the normals
+    void prepare_();
+    // returns the neighbors of given point within radius_
+    std::vector<VertId> findCandidates_( VertId v ) const;
+    // creates local triangulated fan for given point
+    TriangulationHelpers::TriangulatedFan makeFan_( VertId v ) const;
     // parallel creates local triangulated fans for each point
     bool optimizeAll_( ProgressCallback progressCb );
     // accumulate local funs to surface
     std::optional<Mesh> triangulate_( ProgressCallback progressCb );
+    // creates local triangulated fans and votes for triangles in spatial tiles independently
+    std::optional<Mesh> triangulateTiled_( ProgressCallback progressCb );
+    // builds the mesh from the triangles with their votes, and fills small holes (the progress is reported from given value)
+    template<typename Triplets>
+    std::optional<Mesh> makeMesh_( const Triplets& triplets, float startProgress, ProgressCallback progressCb ) const;
 
     const PointCloud& pointCloud_;
     TriangulationParameters params_;
 
+    float radius_ = 0;
+    // the neighbors of all points found once for normals and local triangulations,
+    // empty in tiled mode not to exceed memory limit
+    PointNeighbors neighbors_;
+    VertCoords computedNormals_;
+    const VertCoords* normals_ = nullptr;
+
     Vector<TriangulationHelpers::TriangulatedFan, VertId> optimizedFans_;
 };
 
@@ -47,36 +248,65 @@ PointCloudTriangulator::PointCloudTriangulator( const PointCloud& pointCloud, co
 std::optional<Mesh> PointCloudTriangulator::triangulate( ProgressCallback progressCb )
 {
     MR_TIMER;
+    prepare_();
+    if ( params_.memoryLimit > 0 )
+        return triangulateTiled_( progressCb );
     if ( !optimizeAll_( progressCb ) )
         return {};
     return triangulate_( progressCb );
 }
 
-bool PointCloudTriangulator::optimizeAll_( ProgressCallback progressCb )
+void PointCloudTriangulator::prepare_()
 {
     MR_TIMER;
-    float radius = findAvgPointsRadius( pointCloud_, params_.avgNumNeighbours );
-    // const ref should prolong makeNormals lifetime
-    const VertCoords& normals = pointCloud_.normals.empty() ? makeNormals( pointCloud_, params_.avgNumNeighbours ) : pointCloud_.normals;
+    radius_ = findAvgPointsRadius( pointCloud_, params_.avgNumNeighbours );
+    if ( params_.memoryLimit == 0 )
+        neighbors_ = findNeighborsInBall( pointCloud_, radius_ );
+    if ( pointCloud_.normals.empty() )
+    {
+        // makeNormals( pointCloud_, params_.avgNumNeighbours ) searches the neighbors within the same radius
+        computedNormals_ = neighbors_.numPoints() > 0 ?
+            makeNormals( pointCloud_, neighbors_ ) : makeNormals( pointCloud_, params_.avgNumNeighbours );
+        normals_ = &computedNormals_;
+    }
+    else
+        normals_ = &pointCloud_.normals;
+}
 
-    optimizedFans_.resize( pointCloud_.points.size() );
+std::vector<VertId> PointCloudTriangulator::findCandidates_( VertId v ) const
+{
+    if ( neighbors_.numPoints() == 0 )
+        return TriangulationHelpers::findNeighbors( pointCloud_, v, radius_ );
+    const auto range = neighbors_.neighbors( v );
+    return std::vector<VertId>( begin( range ), end( range ) );
+}
 
-    auto body = [&] ( VertId v )
+TriangulationHelpers::TriangulatedFan PointCloudTriangulator::makeFan_( VertId v ) const
+{
+    auto candidates = findCandidates_( v );
+    auto optimizedRes = TriangulationHelpers::trianglulateFan( pointCloud_.points, v, candidates, *normals_, params_.critAngle );
+    const auto& optimized = optimizedRes.optimized;
+
+    float maxRadius = ( candidates.size() < 2 ) ? radius_ * 2.0f :
+        TriangulationHelpers::updateNeighborsRadius( pointCloud_.points, v, optimized, radius_ );
+
+    if ( maxRadius > radius_ )
     {
-        auto candidates = TriangulationHelpers::findNeighbors( pointCloud_, v, radius );
-        auto optimizedRes = TriangulationHelpers::trianglulateFan( pointCloud_.points, v, candidates, normals, params_.critAngle );
-        const auto& optimized = optimizedRes.optimized;
+        // update triangulation if radius was increased
+        candidates = findCandidates_( v );
+        optimizedRes = TriangulationHelpers::trianglulateFan( pointCloud_.points, v, candidates, *normals_, params_.critAngle );
+    }
+    return optimizedRes;
+}
 
-        float maxRadius = ( candidates.size() < 2 ) ? radius * 2.0f :
-            TriangulationHelpers::updateNeighborsRadius( pointCloud_.points, v, optimized, radius );
+bool PointCloudTriangulator::optimizeAll_( ProgressCallback progressCb )
+{
+    MR_TIMER;
+    optimizedFans_.resize( pointCloud_.points.size() );
 
-        if ( maxRadius > radius )
-        {
-            // update triangulation if radius was increased
-            candidates = TriangulationHelpers::findNeighbors( pointCloud_, v, radius );
-            optimizedRes = TriangulationHelpers::trianglulateFan( pointCloud_.points, v, candidates, normals, params_.critAngle );
-        }
-        optimizedFans_[v] = optimizedRes;
+    auto body = [&] ( VertId v )
+    {
+        optimizedFans_[v] = makeFan_( v );
     };
 
     ProgressCallback partialProgressCb;
@@ -91,77 +321,129 @@ bool PointCloudTriangulator::optimizeAll_( ProgressCallback progressCb )
     return BitSetParallelFor( pointCloud_.validPoints, body, partialProgressCb );
 }
 
-struct VertTriplet
+std::optional<Mesh> PointCloudTriangulator::triangulate_( ProgressCallback progressCb )
 {
-    VertTriplet( VertId _a, VertId _b, VertId _c ) :
-        a{_a}, b{_b}, c{_c}
+    MR_TIMER;
+    // accumulate triplets
+    TripletMap map;
+    for ( auto cV : pointCloud_.validPoints )
     {
-        if ( b < a && b < c )
-        {
-            std::swap( a, b );
-            std::swap( b, c );
-        }
-        else if ( c < a && c < b )
+        voteFan( cV, optimizedFans_[cV], map, [] ( const VertTriplet& ) { return true; } );
+        if ( progressCb )
         {
-            std::swap( a, c );
-            std::swap( b, c );
+            if ( !progressCb( 0.35f + 0.30f * float( cV ) / float( pointCloud_.validPoints.size() ) ) ) // 35% - 65%
+                return {};
         }
     }
-    VertId a, b, c;
-};
-
-bool operator==( const VertTriplet& a, const VertTriplet& b )
-{
-    return( a.a == b.a && a.b == b.b && a.c == b.c );
+    optimizedFans_ = {};
+    return makeMesh_( map, 0.65f, progressCb );
 }
 
-struct VertTripletHasher
-{
-    size_t operator()( const VertTriplet& triplet ) const
-    {
-        auto h1 = std::hash<int>{}(int( triplet.a ));
-        auto h2 = std::hash<int>{}(int( triplet.b ));
-        auto h3 = std::hash<int>{}(int( triplet.c ));
-        return h1 ^ (h2 << 1) ^ (h3 << 3);
-    }
-};
-
-std::optional<Mesh> PointCloudTriangulator::triangulate_( ProgressCallback progressCb )
+std::optional<Mesh> PointCloudTriangulator::triangulateTiled_( ProgressCallback progressCb )
 {
     MR_TIMER;
-    // accumulate triplets
-    phmap::flat_hash_map<VertTriplet, int, VertTripletHasher> map;
-    for ( auto cV : pointCloud_.validPoints )
+    const auto& tree = pointCloud_.getAABBTree();
+    const auto& orderedPoints = tree.orderedPoints();
+    const int numPoints = int( orderedPoints.size() );
+    if ( numPoints == 0 )
+        return makeMesh_( std::vector<std::pair<VertTriplet, int>>{}, 0.65f, progressCb );
+
+    // approximate size of local triangulation and of its triangles in voting map per point
+    constexpr size_t bytesPerPoint = 320;
+    const int numThreads = std::max( 1, int( tbb::this_task_arena::max_concurrency() ) );
+    // the tiles are processed in parallel, and each thread has at least one tile to vote
+    const int maxTilePoints = int( std::max( size_t( 4 * AABBTreePoints::MaxNumPointsInLeaf ),
+        std::min( params_.memoryLimit / ( bytesPerPoint * numThreads ), size_t( ( numPoints + numThreads - 1 ) / numThreads ) ) ) );
+
+    // the vertices of a triangle are within this distance from each other, since all vertices of a fan are within radius from its center;
+    // so the fans of all vertices of the triangles with a vertex in the tile are built for the points within this distance from the tile
+    const float margin = 2 * radius_;
+    // the tiles are the subtrees of AABB tree, each subtree has contiguous range of ordered points
+    const auto tiles = splitPointsInTiles( tree, margin, maxTilePoints );
+
+    std::vector<std::vector<std::pair<VertTriplet, int>>> tileTriplets( tiles.size() );
+    const auto mainThreadId = std::this_thread::get_id();
+    std::atomic<bool> cancelled{ false };
+    std::atomic<int> finishedPoints{ 0 };
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, tiles.size(), 1 ), [&] ( const tbb::blocked_range<size_t>& range )
     {
-        const auto& disc = optimizedFans_[cV];
-        for ( auto it = disc.optimized.begin(); it != disc.optimized.end(); ++it )
-        {
-            if ( disc.border.valid() && *it == disc.border )
-                continue;
-
-            auto next = std::next( it );
-            if ( next == disc.optimized.end() )
-                next = disc.optimized.begin();
-
-            VertTriplet triplet{ cV,*next,*it };
-            auto mIt = map.find( triplet );
-            if ( mIt == map.end() )
-                map[triplet] = 1;
-            else
-                ++mIt->second;
-        }
-        if ( progressCb )
+        const bool reportProgressFromThisThread = progressCb && mainThreadId == std::this_thread::get_id();
+        for ( size_t t = range.begin(); t < range.end(); ++t )
         {
-            if ( !progressCb( 0.35f + 0.30f * float( cV ) / float( pointCloud_.validPoints.size() ) ) ) // 35% - 65%
-                return {};
+            if ( cancelled.load( std::memory_order_relaxed ) )
+                return;
+            const auto& tile = tiles[t];
+
+            // the points of the tile, sorted to find the owner of each triangle
+            std::vector<VertId> tilePoints;
+            tilePoints.reserve( tile.lastPoint - tile.firstPoint );
+            for ( int i = tile.firstPoint; i < tile.lastPoint; ++i )
+                tilePoints.push_back( orderedPoints[i].id );
+            std::sort( tilePoints.begin(), tilePoints.end() );
+
+            // the points of the tile and around it
+            std::vector<VertId> fanPoints;
+            forEachPointInBox( tree, expandedNodeBox( tree, tile.node, margin ), [&] ( VertId v ) { fanPoints.push_back( v ); } );
+
+            std::vector<TriangulationHelpers::TriangulatedFan> fans( fanPoints.size() );
+            // this thread shall not steal other tiles while waiting for the fans of this tile,
+            // otherwise the memory of many tiles can be occupied at once
+            tbb::this_task_arena::isolate( [&]
+            {
+                tbb::parallel_for( tbb::blocked_range<size_t>( 0, fanPoints.size() ), [&] ( const tbb::blocked_range<size_t>& fanRange )
+                {
+                    for ( size_t i = fanRange.begin(); i < fanRange.end(); ++i )
+                        fans[i] = makeFan_( fanPoints[i] );
+                } );
+            } );
+
+            // each triangle is voted only in the tile of its smallest vertex
+            TripletMap map;
+            for ( size_t i = 0; i < fanPoints.size(); ++i )
+            {
+                voteFan( fanPoints[i], fans[i], map, [&] ( const VertTriplet& triplet )
+                {
+                    return std::binary_search( tilePoints.begin(), tilePoints.end(), triplet.a );
+                } );
+            }
+            auto& triplets = tileTriplets[t];
+            for ( const auto& [triplet, count] : map )
+                if ( count == 2 || count == 3 )
+                    triplets.emplace_back( triplet, count );
+            // the order does not depend on hashing and on the number of threads
+            std::sort( triplets.begin(), triplets.end() );
+
+            finishedPoints.fetch_add( tile.lastPoint - tile.firstPoint, std::memory_order_relaxed );
+            if ( reportProgressFromThisThread && !progressCb( 0.65f * float( finishedPoints.load( std::memory_order_relaxed ) ) / numPoints ) ) // 0% - 65%
+                cancelled.store( true, std::memory_order_relaxed );
         }
+    } );
+    if ( cancelled || ( progressCb && !progressCb( 0.65f ) ) )
+        return {};
+
+    std::vector<std::pair<VertTriplet, int>> triplets;
+    size_t numTriplets = 0;
+    for ( const auto& t : tileTriplets )
+        numTriplets += t.size();
+    triplets.reserve( numTriplets );
+    for ( auto& t : tileTriplets )
+    {
+        triplets.insert( triplets.end(), t.begin(), t.end() );
+        t = {};
     }
+    return makeMesh_( triplets, 0.65f, progressCb );
+}
+
+template<typename Triplets>
+std::optional<Mesh> PointCloudTriangulator::makeMesh_( const Triplets& triplets, float startProgress, ProgressCallback progressCb ) const
+{
+    MR_TIMER;
     Mesh mesh;
     mesh.points = pointCloud_.points;
 
     Triangulation t;
     FaceBitSet region2, region3;
-    for ( const auto& triplet : map )
+    for ( const auto& triplet : triplets )
     {
         if ( triplet.second == 2 || triplet.second == 3 )
             t.push_back( { triplet.first.a, triplet.first.b, triplet.first.c, } );
@@ -174,11 +456,11 @@ std::optional<Mesh> PointCloudTriangulator::triangulate_( ProgressCallback progr
     MeshBuilder::addTriangles( mesh.topology, t, { .region = &region3, .allowNonManifoldEdge = false } );
     region2 |= region3;
     if ( progressCb )
-        if ( !progressCb( 0.67f ) ) // 67%
+        if ( !progressCb( startProgress + 0.02f ) ) // 67%
             return {};
     MeshBuilder::addTriangles( mesh.topology, t, { .region = &region2, .allowNonManifoldEdge = false } );
     if ( progressCb )
-        if ( !progressCb( 0.70f ) ) // 70%
+        if ( !progressCb( startProgress + 0.05f ) ) // 70%
             return {};
 
     // fill small holes
@@ -209,4 +491,53 @@ std::optional<Mesh> triangulatePointCloud( const PointCloud& pointCloud, const T
     return triangulator.triangulate( progressCb );
 }
 
+TEST( MRMesh, TriangulatePointCloudTiled )
+{
+    const auto sphere = makeSphere( { .numMeshVertices = 3000 } );
+    PointCloud pc;
+    pc.points = sphere.points;
+    pc.validPoints = sphere.topology.getValidVerts();
+
+    const auto whole = triangulatePointCloud( pc );
+    ASSERT_TRUE( whole.has_value() );
+
+    // tiny limit to get many small tiles
+    TriangulationParameters params;
+    params.memoryLimit = 1;
+    const auto tiled = triangulatePointCloud( pc, params );
+    ASSERT_TRUE( tiled.has_value() );
+
+    // the same triangles are voted, only the order of their addition in the mesh may differ
+    const auto wholeFaces = whole->topology.numValidFaces();
+    const auto tiledFaces = tiled->topology.numValidFaces();
+    EXPECT_LE( std::abs( wholeFaces - tiledFaces ), wholeFaces / 100 );
+    EXPECT_EQ( tiled->topology.findHoleRepresentiveEdges().size(), 0 );
+
+    // the result does not depend on the scheduling of tiles
+    const auto tiled2 = triangulatePointCloud( pc, params );
+    ASSERT_TRUE( tiled2.has_value() );
+    EXPECT_EQ( tiled2->topology, tiled->topology );
+
+    // each tile together with the points in its margin fits in the limit
+    const auto& tree = pc.getAABBTree();
+    const float margin = 0.1f;
+    const int maxTilePoints = 300;
+    const auto tiles = splitPointsInTiles( tree, margin, maxTilePoints );
+    EXPECT_GT( tiles.size(), 1 );
+    int numTilePoints = 0;
+    for ( const auto& tile : tiles )
+    {
+        numTilePoints += tile.lastPoint - tile.firstPoint;
+        const auto box = expandedNodeBox( tree, tile.node, margin );
+        int numFanPoints = 0;
+        forEachPointInBox( tree, box, [&] ( VertId ) { ++numFanPoints; } );
+        EXPECT_EQ( numFanPoints, countPointsInBox( tree, box ) );
+        if ( !tree[tile.node].leaf() )
+        {
+            EXPECT_LE( numFanPoints, maxTilePoints );
+        }
+    }
+    EXPECT_EQ( numTilePoints, int( pc.validPoints.count() ) );
+}
+
 } //namespace MR
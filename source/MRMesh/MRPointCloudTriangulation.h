@@ -54,6 +54,13 @@ struct TriangulationParameters
      * \details If value is subzero it is set automaticly to 0.7*bbox.diagonal()
      */
     float critHoleLength{-FLT_MAX};
+    /**
+     * \brief Approximate limit of memory (in bytes) for local triangulations and their voting, 0 - no limit
+     * \details If positive, the points are split on spatial tiles, which are processed in parallel independently:
+     * the local triangulations are built for the points of the tile and the points around it,
+     * and only the triangles with the smallest vertex from the tile are voted in it, so the same triangles are voted as without tiles
+     */
+    size_t memoryLimit{ 0 };
 };
 
 /**
@@ -0,0 +1,129 @@
+#include "MRPointNeighbors.h"
+#include "MRPointCloud.h"
+#include "MRAABBTreePoints.h"
+#include "MRPointsInBall.h"
+#include "MRBitSetParallelFor.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+
+namespace MR
+{
+
+PointNeighbors findNearestNeighbors( const PointCloud& pointCloud, int k, const VertBitSet* region )
+{
+    MR_TIMER;
+    PointNeighbors res;
+    const VertBitSet& zone = region ? *region : pointCloud.validPoints;
+    const auto& tree = pointCloud.getAABBTree();
+    // the point itself is always found first, so all points get the same number of neighbors
+    const int numNeighbors = std::clamp( int( tree.orderedPoints().size() ) - 1, 0, std::max( k, 0 ) );
+
+    res.firstNeighbor_.resize( pointCloud.points.size() + 1 );
+    size_t n = 0;
+    for ( VertId v{ 0 }; v < pointCloud.points.size(); ++v )
+    {
+        res.firstNeighbor_[v] = n;
+        if ( zone.test( v ) && pointCloud.validPoints.test( v ) )
+            n += numNeighbors;
+    }
+    res.firstNeighbor_.back() = n;
+    res.neighbors_.resize( n );
+    if ( numNeighbors == 0 )
+        return res;
+
+    tbb::enumerable_thread_specific<std::vector<NearestPoint>> threadFound;
+    BitSetParallelFor( zone, [&] ( VertId v )
+    {
+        if ( !pointCloud.validPoints.test( v ) )
+            return;
+        auto& found = threadFound.local();
+        findNearestPoints( tree, pointCloud.points[v], numNeighbors + 1, found );
+        auto* out = res.neighbors_.data() + res.firstNeighbor_[v];
+        int written = 0;
+        for ( const auto& p : found )
+        {
+            // if there are several coincident points, then v can be absent in found
+            if ( p.id == v || written == numNeighbors )
+                continue;
+            out[written++] = p.id;
+        }
+        assert( written == numNeighbors );
+    } );
+    return res;
+}
+
+PointNeighbors findNeighborsInBall( const PointCloud& pointCloud, float radius, const VertBitSet* region )
+{
+    MR_TIMER;
+    PointNeighbors res;
+    const VertBitSet& zone = region ? *region : pointCloud.validPoints;
+    const auto& tree = pointCloud.getAABBTree();
+
+    // first pass: count neighbors of each point
+    res.firstNeighbor_.resize( pointCloud.points.size() + 1, 0 );
+    BitSetParallelFor( zone, [&] ( VertId v )
+    {
+        if ( !pointCloud.validPoints.test( v ) )
+            return;
+        size_t count = 0;
+        findPointsInBall( tree, pointCloud.points[v], radius, [&] ( VertId nv, const Vector3f& )
+        {
+            if ( nv != v )
+                ++count;
+        } );
+        res.firstNeighbor_[v] = count;
+    } );
+
+    size_t n = 0;
+    for ( auto& first : res.firstNeighbor_ )
+    {
+        const auto count = first;
+        first = n;
+        n += count;
+    }
+    res.neighbors_.resize( n );
+
+    // second pass: store the neighbors
+    BitSetParallelFor( zone, [&] ( VertId v )
+    {
+        if ( !pointCloud.validPoints.test( v ) )
+            return;
+        auto* out = res.neighbors_.data() + res.firstNeighbor_[v];
+        findPointsInBall( tree, pointCloud.points[v], radius, [&] ( VertId nv, const Vector3f& )
+        {
+            if ( nv != v )
+                *out++ = nv;
+        } );
+        assert( out == res.neighbors_.data() + res.firstNeighbor_[v + 1] );
+    } );
+    return res;
+}
+
+TEST( MRMesh, PointNeighbors )
+{
+    PointCloud pc;
+    for ( int x = 0; x < 10; ++x )
+        for ( int y = 0; y < 10; ++y )
+            pc.addPoint( Vector3f( float( x ), float( y ), 0.0f ) );
+
+    auto nearest = findNearestPoints( pc, Vector3f( 2.1f, 3.0f, 0.0f ), 3 );
+    ASSERT_EQ( nearest.size(), 3 );
+    EXPECT_EQ( nearest[0].id, VertId( 23 ) );
+    EXPECT_NEAR( nearest[0].distSq, 0.01f, 1e-5f );
+    EXPECT_LE( nearest[1].distSq, nearest[2].distSq );
+
+    auto all = findNearestPoints( pc, Vector3f(), 1000 );
+    EXPECT_EQ( all.size(), 100 );
+
+    auto knn = findNearestNeighbors( pc, 4 );
+    EXPECT_EQ( knn.numPoints(), 100 );
+    EXPECT_EQ( knn.numNeighbors( VertId( 55 ) ), 4 );
+    for ( auto nv : knn.neighbors( VertId( 55 ) ) )
+        EXPECT_NEAR( ( pc.points[nv] - pc.points[VertId( 55 )] ).length(), 1.0f, 1e-5f );
+
+    auto ball = findNeighborsInBall( pc, 1.5f );
+    EXPECT_EQ( ball.numNeighbors( VertId( 0 ) ), 3 );
+    EXPECT_EQ( ball.numNeighbors( VertId( 55 ) ), 8 );
+}
+
+} // namespace MR
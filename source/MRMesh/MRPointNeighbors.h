@@ -0,0 +1,51 @@
+#pragma once
+
+#include "MRMeshFwd.h"
+#include "MRId.h"
+#include "MRVector.h"
+#include "MRIteratorRange.h"
+#include "MRHeapBytes.h"
+
+namespace MR
+{
+
+/// \addtogroup PointCloudGroup
+/// \{
+
+/// neighbors of every point of a cloud stored in one contiguous array;
+/// it is built once in parallel and then can be shared by several algorithms and iterations
+/// instead of searching the neighbors in AABB tree again and again
+class PointNeighbors
+{
+public:
+    PointNeighbors() = default;
+
+    /// returns the number of points this structure was built for
+    [[nodiscard]] size_t numPoints() const { return firstNeighbor_.empty() ? 0 : firstNeighbor_.size() - 1; }
+    /// returns the number of neighbors of given point
+    [[nodiscard]] int numNeighbors( VertId v ) const { return int( firstNeighbor_[v + 1] - firstNeighbor_[v] ); }
+    /// returns all neighbors of given point (the point itself is not included)
+    [[nodiscard]] IteratorRange<const VertId*> neighbors( VertId v ) const
+        { return { neighbors_.data() + firstNeighbor_[v], neighbors_.data() + firstNeighbor_[v + 1] }; }
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return firstNeighbor_.heapBytes() + MR::heapBytes( neighbors_ ); }
+
+private:
+    /// neighbors of point v are located in neighbors_ in the range [ firstNeighbor_[v], firstNeighbor_[v+1] )
+    Vector<size_t, VertId> firstNeighbor_;
+    std::vector<VertId> neighbors_;
+
+    friend MRMESH_API PointNeighbors findNearestNeighbors( const PointCloud& pointCloud, int k, const VertBitSet* region );
+    friend MRMESH_API PointNeighbors findNeighborsInBall( const PointCloud& pointCloud, float radius, const VertBitSet* region );
+};
+
+/// finds in parallel k nearest neighbors of each valid point of the cloud (or only of points from region if it is given)
+[[nodiscard]] MRMESH_API PointNeighbors findNearestNeighbors( const PointCloud& pointCloud, int k, const VertBitSet* region = nullptr );
+
+/// finds in parallel all neighbors within given radius of each valid point of the cloud (or only of points from region if it is given)
+[[nodiscard]] MRMESH_API PointNeighbors findNeighborsInBall( const PointCloud& pointCloud, float radius, const VertBitSet* region = nullptr );
+
+/// \}
+
+} // namespace MR
@@ -1,6 +1,8 @@
 #include "MRPointsInBall.h"
 #include "MRPointCloud.h"
 #include "MRAABBTreePoints.h"
+#include "MRPch/MRTBB.h"
+#include <algorithm>
 
 namespace MR
 {
@@ -81,4 +83,113 @@ void findPointsInBall( const AABBTreePoints& tree, const Vector3f& center, float
     }
 }
 
+void findNearestPoints( const AABBTreePoints& tree, const Vector3f& center, int k, std::vector<NearestPoint>& res, float maxDistSq )
+{
+    res.clear();
+    if ( k <= 0 || tree.nodes().empty() )
+        return;
+    res.reserve( k );
+
+    const auto& orderedPoints = tree.orderedPoints();
+    // res is kept as max-heap by distance while searching, so the farthest found point is in front
+    const auto farther = [] ( const NearestPoint& a, const NearestPoint& b )
+    {
+        return a.distSq < b.distSq;
+    };
+    // squared distance to k-th point found so far, all nodes and points farther than it are skipped
+    float boundSq = maxDistSq;
+
+    struct SubTask
+    {
+        AABBTreePoints::NodeId n;
+        float distSq = 0;
+        SubTask() = default;
+        SubTask( AABBTreePoints::NodeId n, float dd ) : n( n ), distSq( dd ){}
+    };
+
+    constexpr int MaxStackSize = 32; // to avoid allocations
+    SubTask subtasks[MaxStackSize];
+    int stackSize = 0;
+
+    auto addSubTask = [&]( const SubTask& s )
+    {
+        if ( s.distSq < boundSq )
+        {
+            assert( stackSize < MaxStackSize );
+            subtasks[stackSize++] = s;
+        }
+    };
+
+    auto getSubTask = [&]( AABBTreePoints::NodeId n )
+    {
+        float distSq = ( tree.nodes()[n].box.getBoxClosestPointTo( center ) - center ).lengthSq();
+        return SubTask( n, distSq );
+    };
+
+    addSubTask( getSubTask( tree.rootNodeId() ) );
+
+    while ( stackSize > 0 )
+    {
+        const auto s = subtasks[--stackSize];
+        if ( s.distSq >= boundSq )
+            continue; // the bound was decreased after this node has been added
+
+        const auto& node = tree[s.n];
+        if ( node.leaf() )
+        {
+            auto [first, last] = node.getLeafPointRange();
+            for ( int i = first; i < last; ++i )
+            {
+                const float distSq = ( orderedPoints[i].coord - center ).lengthSq();
+                if ( distSq >= boundSq )
+                    continue;
+                if ( res.size() == k )
+                {
+                    std::pop_heap( res.begin(), res.end(), farther );
+                    res.back() = { orderedPoints[i].id, distSq };
+                }
+                else
+                    res.push_back( { orderedPoints[i].id, distSq } );
+                std::push_heap( res.begin(), res.end(), farther );
+                if ( res.size() == k )
+                    boundSq = res.front().distSq;
+            }
+            continue;
+        }
+
+        auto s1 = getSubTask( node.leftOrFirst );
+        auto s2 = getSubTask( node.rightOrLast );
+        if ( s1.distSq < s2.distSq )
+            std::swap( s1, s2 );
+        assert( s1.distSq >= s2.distSq );
+        addSubTask( s1 ); // larger distance to look later
+        addSubTask( s2 ); // smaller distance to look first
+    }
+    std::sort_heap( res.begin(), res.end(), farther );
+}
+
+std::vector<NearestPoint> findNearestPoints( const PointCloud& pointCloud, const Vector3f& center, int k )
+{
+    std::vector<NearestPoint> res;
+    findNearestPoints( pointCloud.getAABBTree(), center, k, res );
+    return res;
+}
+
+std::vector<NearestPoint> findNearestPoints( const AABBTreePoints& tree, const std::vector<Vector3f>& centers, int k )
+{
+    if ( k <= 0 )
+        return {};
+    std::vector<NearestPoint> res( centers.size() * k );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, centers.size() ), [&] ( const tbb::blocked_range<size_t>& range )
+    {
+        std::vector<NearestPoint> found;
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+        {
+            findNearestPoints( tree, centers[i], k, found );
+            std::copy( found.begin(), found.end(), res.begin() + i * k );
+        }
+    } );
+    return res;
+}
+
 }
@@ -2,6 +2,7 @@
 #include "MRMeshFwd.h"
 #include "MRBitSet.h"
 #include "MRId.h"
+#include <cfloat>
 
 namespace MR
 {
@@ -16,4 +17,26 @@ MRMESH_API void findPointsInBall( const PointCloud& pointCloud, const Vector3f&
 /// \ingroup AABBTreeGroup
 MRMESH_API void findPointsInBall( const AABBTreePoints& tree, const Vector3f& center, float radius, const FoundPointCallback& foundCallback );
 
+/// point found by nearest neighbors search
+struct NearestPoint
+{
+    VertId id;
+    float distSq = FLT_MAX; ///< squared distance from the query center to the point
+};
+
+/// Finds at most k points of the tree nearest to given center and not farther than sqrt( maxDistSq ) from it,
+/// \param res receives found points sorted by increasing distance (its capacity is reused between calls)
+/// \ingroup AABBTreeGroup
+MRMESH_API void findNearestPoints( const AABBTreePoints& tree, const Vector3f& center, int k, std::vector<NearestPoint>& res,
+    float maxDistSq = FLT_MAX );
+
+/// Finds at most k valid points of pointCloud nearest to given center sorted by increasing distance
+/// \ingroup AABBTreeGroup
+[[nodiscard]] MRMESH_API std::vector<NearestPoint> findNearestPoints( const PointCloud& pointCloud, const Vector3f& center, int k );
+
+/// Finds in parallel at most k points of the tree nearest to each of given centers,
+/// \return k elements per center (sorted by increasing distance), missing points (if tree has less than k points) have invalid ids
+/// \ingroup AABBTreeGroup
+[[nodiscard]] MRMESH_API std::vector<NearestPoint> findNearestPoints( const AABBTreePoints& tree, const std::vector<Vector3f>& centers, int k );
+
 }
\ No newline at end of file
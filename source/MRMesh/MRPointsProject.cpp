@@ -0,0 +1,108 @@
+#include "MRPointsProject.h"
+#include "MRPointCloud.h"
+#include "MRAABBTreePoints.h"
+#include "MRAffineXf3.h"
+#include "MRGTest.h"
+
+namespace MR
+{
+
+PointsProjectionResult findProjectionOnPoints( const Vector3f& pt, const PointCloud& pc,
+    float upDistLimitSq, const AffineXf3f* xf, float loDistLimitSq )
+{
+    const auto& tree = pc.getAABBTree();
+    const auto& orderedPoints = tree.orderedPoints();
+
+    PointsProjectionResult res;
+    res.distSq = upDistLimitSq;
+    if ( tree.nodes().empty() )
+        return res;
+
+    struct SubTask
+    {
+        AABBTreePoints::NodeId n;
+        float distSq = 0;
+        SubTask() = default;
+        SubTask( AABBTreePoints::NodeId n, float dd ) : n( n ), distSq( dd ) { }
+    };
+
+    constexpr int MaxStackSize = 32; // to avoid allocations
+    SubTask subtasks[MaxStackSize];
+    int stackSize = 0;
+
+    auto addSubTask = [&]( const SubTask& s )
+    {
+        if ( s.distSq < res.distSq )
+        {
+            assert( stackSize < MaxStackSize );
+            subtasks[stackSize++] = s;
+        }
+    };
+
+    auto getSubTask = [&]( AABBTreePoints::NodeId n )
+    {
+        float distSq = ( transformed( tree.nodes()[n].box, xf ).getBoxClosestPointTo( pt ) - pt ).lengthSq();
+        return SubTask( n, distSq );
+    };
+
+    addSubTask( getSubTask( tree.rootNodeId() ) );
+
+    while ( stackSize > 0 )
+    {
+        const auto s = subtasks[--stackSize];
+        const auto& node = tree[s.n];
+        if ( s.distSq >= res.distSq )
+            continue;
+
+        if ( node.leaf() )
+        {
+            auto [first, last] = node.getLeafPointRange();
+            bool lowBoundReached = false;
+            for ( int i = first; i < last; ++i )
+            {
+                auto proj = xf ? ( *xf )( orderedPoints[i].coord ) : orderedPoints[i].coord;
+                float distSq = ( proj - pt ).lengthSq();
+                if ( distSq < res.distSq )
+                {
+                    res.distSq = distSq;
+                    res.vId = orderedPoints[i].id;
+                    if ( distSq <= loDistLimitSq )
+                    {
+                        lowBoundReached = true;
+                        break;
+                    }
+                }
+            }
+            if ( lowBoundReached )
+                break;
+            continue;
+        }
+
+        auto s1 = getSubTask( node.leftOrFirst );
+        auto s2 = getSubTask( node.rightOrLast );
+        if ( s1.distSq < s2.distSq )
+            std::swap( s1, s2 );
+        assert( s1.distSq >= s2.distSq );
+        addSubTask( s1 ); // larger distance to look later
+        addSubTask( s2 ); // smaller distance to look first
+    }
+
+    return res;
+}
+
+TEST( MRMesh, PointsProject )
+{
+    PointCloud pc;
+    pc.addPoint( Vector3f( 0, 0, 0 ) );
+    pc.addPoint( Vector3f( 1, 0, 0 ) );
+    pc.addPoint( Vector3f( 0, 2, 0 ) );
+
+    auto res = findProjectionOnPoints( Vector3f( 0.9f, 0.1f, 0 ), pc );
+    EXPECT_EQ( res.vId, VertId( 1 ) );
+    EXPECT_NEAR( res.distSq, 0.02f, 1e-6f );
+
+    res = findProjectionOnPoints( Vector3f( 0, 5, 0 ), pc, 1.0f );
+    EXPECT_FALSE( res.vId.valid() );
+}
+
+} // namespace MR
@@ -0,0 +1,217 @@
+#include "MRProgressiveMesh.h"
+#include "MRMeshBuilder.h"
+#include "MRHeapBytes.h"
+#include "MRProgressReadWrite.h"
+#include "MRTorus.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include <sstream>
+
+namespace MR
+{
+
+static_assert( sizeof( EdgeCollapseRecord ) == 28, "EdgeCollapseRecord is written in binary streams" );
+
+size_t ProgressiveMesh::numCollapsesForFaces( int maxFaces ) const
+{
+    int numFaces = base.topology.numValidFaces();
+    size_t res = 0;
+    while ( res < collapses.size() && numFaces > maxFaces )
+        numFaces -= collapses[res++].facesDeleted;
+    return res;
+}
+
+size_t ProgressiveMesh::numCollapsesForError( float maxError ) const
+{
+    size_t res = 0;
+    while ( res < collapses.size() && collapses[res].error <= maxError )
+        ++res;
+    return res;
+}
+
+Mesh ProgressiveMesh::extract( size_t numCollapses ) const
+{
+    MR_TIMER;
+    numCollapses = std::min( numCollapses, collapses.size() );
+
+    VertCoords points = base.points;
+    for ( size_t i = 0; i < numCollapses; ++i )
+        points[collapses[i].kept] = collapses[i].pos;
+
+    // the vertex remaining from each base vertex after all collapses:
+    // the kept vertex of a collapse is either alive in the end or removed by later collapse processed before
+    VertMap vmap( base.points.size() );
+    for ( VertId v{ 0 }; v < vmap.size(); ++v )
+        vmap[v] = v;
+    for ( size_t i = numCollapses; i-- > 0; )
+        vmap[collapses[i].removed] = vmap[collapses[i].kept];
+
+    FaceBitSet faces = base.topology.getValidFaces();
+    Triangulation t( base.topology.faceSize() );
+    for ( auto f : faces )
+    {
+        auto & vs = t[f];
+        base.topology.getTriVerts( f, vs );
+        for ( auto & v : vs )
+            v = vmap[v];
+        if ( vs[0] == vs[1] || vs[1] == vs[2] || vs[2] == vs[0] )
+            faces.reset( f ); // the face was deleted by one of the collapses
+    }
+
+    MeshBuilder::BuildSettings settings;
+    settings.region = &faces;
+    auto res = Mesh::fromTriangles( std::move( points ), t, settings );
+    assert( faces.none() );
+    return res;
+}
+
+tl::expected<void, std::string> ProgressiveMesh::write( std::ostream & out ) const
+{
+    MR_TIMER;
+    base.topology.write( out );
+
+    const auto numPoints = (std::uint32_t)base.points.size();
+    out.write( (const char*)&numPoints, 4 );
+    writeByBlocks( out, (const char*)base.points.data(), base.points.size() * sizeof( Vector3f ) );
+
+    const auto numCollapses = (std::uint64_t)collapses.size();
+    out.write( (const char*)&numCollapses, 8 );
+    writeByBlocks( out, (const char*)collapses.data(), collapses.size() * sizeof( EdgeCollapseRecord ) );
+
+    if ( !out )
+        return tl::make_unexpected( std::string( "Error saving progressive mesh" ) );
+    return {};
+}
+
+tl::expected<void, std::string> ProgressiveMesh::read( std::istream & in )
+{
+    MR_TIMER;
+    auto readRes = base.topology.read( in );
+    if ( !readRes.has_value() )
+        return tl::make_unexpected( "Error reading topology of progressive mesh:\n" + readRes.error() );
+
+    std::uint32_t numPoints = 0;
+    in.read( (char*)&numPoints, 4 );
+    if ( !in )
+        return tl::make_unexpected( std::string( "Error reading the number of points of progressive mesh" ) );
+    base.points.resize( numPoints );
+    readByBlocks( in, (char*)base.points.data(), base.points.size() * sizeof( Vector3f ) );
+
+    std::uint64_t numCollapses = 0;
+    in.read( (char*)&numCollapses, 8 );
+    if ( !in )
+        return tl::make_unexpected( std::string( "Error reading the number of collapses of progressive mesh" ) );
+    collapses.resize( numCollapses );
+    readByBlocks( in, (char*)collapses.data(), collapses.size() * sizeof( EdgeCollapseRecord ) );
+    if ( !in )
+        return tl::make_unexpected( std::string( "Error reading collapses of progressive mesh" ) );
+
+    auto validVert = [&] ( VertId v ) { return v.valid() && v < base.points.size(); };
+    for ( const auto & c : collapses )
+        if ( !validVert( c.kept ) || !validVert( c.removed ) )
+            return tl::make_unexpected( std::string( "Invalid vertex in collapses of progressive mesh" ) );
+    return {};
+}
+
+size_t ProgressiveMesh::heapBytes() const
+{
+    return base.heapBytes() + MR::heapBytes( collapses );
+}
+
+ProgressiveMesh makeProgressiveMesh( const Mesh & mesh, const DecimateSettings & settings )
+{
+    MR_TIMER;
+    ProgressiveMesh res;
+    res.base = mesh;
+    Mesh decimated = mesh;
+    DecimateSettings s = settings;
+    s.packMesh = false;
+    s.outCollapses = &res.collapses;
+    decimateMesh( decimated, s );
+    return res;
+}
+
+TEST( MRMesh, ProgressiveMesh )
+{
+    const Mesh torus = makeTorus( 2.0f, 1.0f, 32, 32 );
+    DecimateSettings settings;
+    settings.maxError = 0.1f;
+    settings.maxTriangleAspectRatio = 80.0f;
+
+    Mesh decimated = torus;
+    const auto decRes = decimateMesh( decimated, settings );
+    const auto pm = makeProgressiveMesh( torus, settings );
+    EXPECT_EQ( pm.collapses.size(), decRes.vertsDeleted );
+
+    // all collapses give the same mesh as ordinary decimation
+    const auto last = pm.extract( pm.collapses.size() );
+    EXPECT_EQ( last.topology.numValidFaces(), decimated.topology.numValidFaces() );
+    EXPECT_EQ( last.topology.numValidVerts(), decimated.topology.numValidVerts() );
+    for ( auto v : decimated.topology.getValidVerts() )
+    {
+        EXPECT_TRUE( last.topology.hasVert( v ) );
+        EXPECT_EQ( last.points[v], decimated.points[v] );
+    }
+
+    // no collapses give base mesh
+    const auto first = pm.extract( 0 );
+    EXPECT_EQ( first.topology.numValidFaces(), torus.topology.numValidFaces() );
+
+    const int targetFaces = torus.topology.numValidFaces() / 2;
+    const auto middle = pm.extract( pm.numCollapsesForFaces( targetFaces ) );
+    EXPECT_LE( middle.topology.numValidFaces(), targetFaces );
+    EXPECT_GT( middle.topology.numValidFaces(), targetFaces - 3 );
+    EXPECT_TRUE( middle.topology.checkValidity() );
+    EXPECT_LE( pm.numCollapsesForError( 0.01f ), pm.collapses.size() );
+
+    std::stringstream ss;
+    EXPECT_TRUE( pm.write( ss ).has_value() );
+    ProgressiveMesh loaded;
+    EXPECT_TRUE( loaded.read( ss ).has_value() );
+    EXPECT_EQ( loaded.base, pm.base );
+    EXPECT_EQ( loaded.collapses.size(), pm.collapses.size() );
+    EXPECT_EQ( loaded.extract( loaded.collapses.size() ).topology.numValidFaces(), last.topology.numValidFaces() );
+}
+
+TEST( MRMesh, ProgressiveMeshLoneEdge )
+{
+    // torus with a hole and a short dangling edge from the hole's vertex,
+    // the edge is collapsed into the torus vertex by deletion of its own lone origin
+    Mesh mesh = makeTorus( 2.0f, 1.0f, 16, 16 );
+    mesh.topology.deleteFace( FaceId( 0 ) );
+    const EdgeId h = mesh.topology.findHoleRepresentiveEdges().front();
+    const VertId torusVert = mesh.topology.org( h );
+    const VertId loneVert = mesh.topology.addVertId();
+    mesh.points.push_back( mesh.points[torusVert] + Vector3f( 0.001f, 0.001f, 0.001f ) );
+    const EdgeId e = mesh.topology.makeEdge();
+    mesh.topology.splice( h, e.sym() );
+    mesh.topology.setOrg( e, loneVert );
+
+    DecimateSettings settings;
+    settings.maxError = 0.01f;
+
+    Mesh decimated = mesh;
+    decimateMesh( decimated, settings );
+    EXPECT_FALSE( decimated.topology.hasVert( loneVert ) );
+    EXPECT_TRUE( decimated.topology.hasVert( torusVert ) );
+
+    const auto pm = makeProgressiveMesh( mesh, settings );
+    size_t loneCollapse = pm.collapses.size();
+    for ( size_t i = 0; i < pm.collapses.size(); ++i )
+        if ( pm.collapses[i].removed == loneVert )
+            loneCollapse = i;
+    ASSERT_LT( loneCollapse, pm.collapses.size() );
+    EXPECT_EQ( pm.collapses[loneCollapse].kept, torusVert );
+    EXPECT_EQ( pm.collapses[loneCollapse].facesDeleted, 0 );
+
+    // replay of the collapses gives the same vertices in the same places as the decimation
+    const auto last = pm.extract( pm.collapses.size() );
+    EXPECT_EQ( last.topology.numValidFaces(), decimated.topology.numValidFaces() );
+    for ( auto v : decimated.topology.getValidVerts() )
+    {
+        EXPECT_TRUE( last.topology.hasVert( v ) );
+        EXPECT_EQ( last.points[v], decimated.points[v] );
+    }
+}
+
+} //namespace MR
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "MRMesh.h"
+#include "MRMeshDecimate.h"
+#include <tl/expected.hpp>
+#include <iosfwd>
+
+namespace MR
+{
+
+/// \addtogroup DecimateGroup
+/// \{
+
+/// one edge collapse performed by decimation:
+/// vertex (removed) is merged into vertex (kept), which gets new position (pos)
+struct EdgeCollapseRecord
+{
+    VertId kept;
+    VertId removed;
+    Vector3f pos;
+    /// estimated distance deviation introduced by this collapse, see DecimateResult::errorIntroduced
+    float error = 0;
+    /// the number of faces deleted by this collapse (0, 1 or 2)
+    int facesDeleted = 0;
+};
+
+/// the original mesh and the ordered sequence of edge collapses recorded during single decimation run;
+/// the mesh of any level of detail can be extracted from it in linear time
+struct ProgressiveMesh
+{
+    /// the mesh before decimation
+    Mesh base;
+    /// all edge collapses in the order of their application
+    std::vector<EdgeCollapseRecord> collapses;
+
+    /// returns the minimal number of first collapses to get the mesh with at most given number of faces,
+    /// or all collapses if so many faces cannot be deleted
+    [[nodiscard]] MRMESH_API size_t numCollapsesForFaces( int maxFaces ) const;
+    /// returns the maximal number of first collapses each introducing the error not more than given value
+    [[nodiscard]] MRMESH_API size_t numCollapsesForError( float maxError ) const;
+
+    /// constructs the mesh after given number of first collapses;
+    /// the ids of remaining vertices and faces are the same as in the base mesh,
+    /// call Mesh::pack() on the result to get rid of the gaps
+    [[nodiscard]] MRMESH_API Mesh extract( size_t numCollapses ) const;
+
+    /// saves this in binary stream
+    MRMESH_API tl::expected<void, std::string> write( std::ostream & out ) const;
+    /// loads this from binary stream written by write()
+    MRMESH_API tl::expected<void, std::string> read( std::istream & in );
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] MRMESH_API size_t heapBytes() const;
+};
+
+/// decimates the copy of given mesh according to the settings (without packing) recording all collapses
+/// to get the progressive mesh from the original mesh till the coarsest level of detail permitted by the settings
+[[nodiscard]] MRMESH_API ProgressiveMesh makeProgressiveMesh( const Mesh & mesh, const DecimateSettings & settings );
+
+/// \}
+
+} //namespace MR
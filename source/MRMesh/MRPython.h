@@ -25,6 +25,11 @@ static MR::PythonFunctionAdder moduleName##_init_( #moduleName, &PyInit_##module
 #define MR_ADD_PYTHON_FUNCTION( moduleName , name , func , description ) \
     static MR::PythonFunctionAdder name##_adder_( #moduleName, [](pybind11::module_& m){ m.def(#name, func, description);} );
 
+// the same as MR_ADD_PYTHON_FUNCTION, but the GIL is released during the call, so other python threads can run meanwhile;
+// use it only for long functions that do not touch python objects
+#define MR_ADD_PYTHON_FUNCTION_NOGIL( moduleName , name , func , description ) \
+    static MR::PythonFunctionAdder name##_adder_( #moduleName, [](pybind11::module_& m){ m.def(#name, func, description, pybind11::call_guard<pybind11::gil_scoped_release>());} );
+
 #define MR_ADD_PYTHON_CUSTOM_DEF( moduleName , name , ... ) \
 _Pragma("warning(push)") \
 _Pragma("warning(disable:4459)") \
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "MRVector3.h"
+#include "MRHeapBytes.h"
 #include <cfloat>
+#include <cstdint>
 #include <vector>
 
 namespace MR
@@ -14,4 +16,25 @@ struct SimpleVolume
     float min = FLT_MAX;
     float max = -FLT_MAX;
 };
-}
\ No newline at end of file
+
+/// volume with voxels stored in their native (compact) type as it comes from scanner,
+/// real value of i-th voxel is data[i] * scale + offset
+template <typename T>
+struct TypedSimpleVolume
+{
+    std::vector<T> data;
+    Vector3i dims;
+    Vector3f voxelSize;
+    float scale = 1.0f;
+    float offset = 0.0f;
+    /// minimal and maximal real values of voxels
+    float min = FLT_MAX;
+    float max = -FLT_MAX;
+
+    /// returns real value of i-th voxel
+    float value( size_t i ) const { return data[i] * scale + offset; }
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return MR::heapBytes( data ); }
+};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "MRBitSet.h"
+#include "MRHeapBytes.h"
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace MR
+{
+
+/// \addtogroup BasicGroup
+/// \{
+
+/// sorted set of ids representing a very sparse region of a big mesh (e.g. a small selection):
+/// both the memory and the time of iteration are proportional to the number of elements in the set,
+/// rather than to the number of elements in the whole mesh as in TaggedBitSet
+template <typename T>
+class SparseIdSet
+{
+public:
+    using IndexType = Id<T>;
+
+    SparseIdSet() = default;
+    /// collects all set bits of given bit set
+    explicit SparseIdSet( const TaggedBitSet<T>& bs )
+    {
+        ids_.reserve( bs.count() );
+        for ( size_t b = 0; b < bs.num_blocks(); ++b )
+            for ( auto block = bs.m_bits[b]; block; block &= block - 1 )
+                ids_.emplace_back( b * BitSet::bits_per_block + std::countr_zero( block ) );
+    }
+    /// takes given ids in any order, repetitions are removed
+    explicit SparseIdSet( std::vector<IndexType> ids ) : ids_( std::move( ids ) )
+    {
+        std::sort( ids_.begin(), ids_.end() );
+        ids_.erase( std::unique( ids_.begin(), ids_.end() ), ids_.end() );
+    }
+
+    /// returns the number of ids in the set
+    [[nodiscard]] size_t count() const { return ids_.size(); }
+    [[nodiscard]] bool empty() const { return ids_.empty(); }
+    /// returns true if given id belongs to the set, log-time
+    [[nodiscard]] bool test( IndexType id ) const { return std::binary_search( ids_.begin(), ids_.end(), id ); }
+    /// adds given id in the set, linear-time in the worst case
+    void set( IndexType id )
+    {
+        auto it = std::lower_bound( ids_.begin(), ids_.end(), id );
+        if ( it == ids_.end() || *it != id )
+            ids_.insert( it, id );
+    }
+    /// removes given id from the set, linear-time in the worst case
+    void reset( IndexType id )
+    {
+        auto it = std::lower_bound( ids_.begin(), ids_.end(), id );
+        if ( it != ids_.end() && *it == id )
+            ids_.erase( it );
+    }
+
+    /// returns all ids of the set in increasing order
+    [[nodiscard]] const std::vector<IndexType>& ids() const { return ids_; }
+    [[nodiscard]] auto begin() const { return ids_.begin(); }
+    [[nodiscard]] auto end() const { return ids_.end(); }
+
+    /// converts this set into bit set of given size (or minimal size sufficient to keep all ids)
+    [[nodiscard]] TaggedBitSet<T> toBitSet( size_t size = 0 ) const
+    {
+        TaggedBitSet<T> res( std::max( size, ids_.empty() ? size_t( 0 ) : size_t( ids_.back() ) + 1 ) );
+        for ( auto id : ids_ )
+            res.set( id );
+        return res;
+    }
+
+    /// returns the amount of memory this object occupies on heap
+    [[nodiscard]] size_t heapBytes() const { return MR::heapBytes( ids_ ); }
+
+private:
+    std::vector<IndexType> ids_;
+};
+
+template <typename T>
+[[nodiscard]] inline bool contains( const SparseIdSet<T>& set, Id<T> id )
+{
+    return id.valid() && set.test( id );
+}
+
+/// \}
+
+} // namespace MR
@@ -13,6 +13,11 @@ struct TimeRecord
 {
     int count = 0;
     nanoseconds time = {};
+    // allocations made in all calls, valid if allocation tracking is enabled
+    size_t allocCount = 0;
+    size_t allocBytes = 0;
+    // maximal excess of allocated memory over its level at the start of one call
+    size_t peakBytes = 0;
     std::map<std::string, TimeRecord> children;
 
     // returns summed time of immediate children
@@ -36,6 +41,12 @@ void printTimeRecord( const TimeRecord& timeRecord, const std::string& name, int
     ss << std::setw( 9 )  << std::right << timeRecord.count;
     ss << std::setw( 12 ) << std::right << std::fixed << std::setprecision( 3 ) << timeRecord.seconds();
     ss << std::setw( 12 ) << std::right << std::fixed << std::setprecision( 3 ) << timeRecord.mySeconds();
+    if ( isAllocationTrackingEnabled() )
+    {
+        ss << std::setw( 12 ) << std::right << timeRecord.allocCount;
+        ss << std::setw( 12 ) << std::right << std::fixed << std::setprecision( 3 ) << timeRecord.allocBytes / 1048576.0;
+        ss << std::setw( 12 ) << std::right << std::fixed << std::setprecision( 3 ) << timeRecord.peakBytes / 1048576.0;
+    }
     ss << std::string( indent, ' ' ) << name;
     loggerHandle->info( ss.str() );
 
@@ -60,9 +71,22 @@ struct RootTimeRecord : TimeRecord
         ss << std::setw( 9 ) << std::right << "Count";
         ss << std::setw( 12 ) << std::right << "Time";
         ss << std::setw( 12 ) << std::right << "Self time";
+        if ( isAllocationTrackingEnabled() )
+        {
+            ss << std::setw( 12 ) << std::right << "Allocs";
+            ss << std::setw( 12 ) << std::right << "Alloc MB";
+            ss << std::setw( 12 ) << std::right << "Peak MB";
+        }
         ss << "    Name";
         loggerHandle->info( ss.str() );
         time = high_resolution_clock::now() - started;
+        if ( isAllocationTrackingEnabled() )
+        {
+            const auto stats = getAllocationStats();
+            allocCount = stats.count;
+            allocBytes = stats.bytes;
+            peakBytes = stats.peakBytes;
+        }
         printTimeRecord( *this, "(total)", 4, loggerHandle );
     }
     ~RootTimeRecord()
@@ -97,6 +121,10 @@ void Timer::restart( std::string name )
     start_ = high_resolution_clock::now();
     parent_ = currentRecord;
     currentRecord = &currentRecord->children[name_];
+    // started last not to count own allocations of the timer
+    trackAllocations_ = isAllocationTrackingEnabled();
+    if ( trackAllocations_ )
+        allocStart_ = startAllocationScope();
 }
 
 void Timer::finish()
@@ -104,6 +132,14 @@ void Timer::finish()
     if ( !parent_ )
         return;
 
+    if ( trackAllocations_ )
+    {
+        const auto allocs = finishAllocationScope( allocStart_ );
+        currentRecord->allocCount += allocs.count;
+        currentRecord->allocBytes += allocs.bytes;
+        currentRecord->peakBytes = std::max( currentRecord->peakBytes, allocs.peakBytes );
+        trackAllocations_ = false;
+    }
     currentRecord->time += high_resolution_clock::now() - start_;
     ++currentRecord->count;
     currentRecord = parent_;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MRMeshFwd.h"
+#include "MRAllocationTracker.h"
 #include <chrono>
 #include <string>
 
@@ -32,6 +33,9 @@ private:
     TimeRecord * parent_ = nullptr;
     std::chrono::time_point<std::chrono::high_resolution_clock> start_;
     std::string name_;
+    /// the state of allocations at the start, valid if trackAllocations_
+    AllocationStats allocStart_;
+    bool trackAllocations_ = false;
 };
 
 /// enables or disables printing of timing tree when application terminates
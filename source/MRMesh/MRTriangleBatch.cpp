@@ -0,0 +1,300 @@
+#include "MRTriangleBatch.h"
+#include "MRClosestPointInTriangle.h"
+#include "MRTriangleIntersection.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRSpdlog.h"
+#include <bit>
+#include <random>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// the kernels are written as loops over the lanes of TriangleBatch without branches,
+// which are vectorized by the compiler for the baseline instruction set of the target (SSE2 on x86-64, NEON on ARM64)
+
+// otherwise GCC does not convert the selections of float values in branchless code,
+// since the comparisons could raise floating-point exceptions, which are masked anyway
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize( "no-trapping-math" )
+#endif
+
+#include "MRTriangleBatchKernels.h"
+
+namespace MR
+{
+
+namespace
+{
+
+using namespace TriangleBatchKernels;
+
+#ifdef MR_TRIANGLE_BATCH_AVX2
+bool cpuSupportsAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid( info, 0 );
+    if ( info[0] < 7 )
+        return false;
+    __cpuid( info, 1 );
+    const bool fma = info[2] & ( 1 << 12 );
+    const bool osxsave = info[2] & ( 1 << 27 );
+    const bool avx = info[2] & ( 1 << 28 );
+    // the operating system must save YMM registers on context switches
+    if ( !fma || !osxsave || !avx || ( _xgetbv( 0 ) & 6 ) != 6 )
+        return false;
+    __cpuidex( info, 7, 0 );
+    return info[1] & ( 1 << 5 );
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+#endif
+}
+#endif
+
+void closestPointDefault( const float p[3], const TriangleBatch & tris, LaneResults & res )
+    { closestPointKernel( p, tris, res ); }
+void rayDefault( const RayQuery & q, const TriangleBatch & tris, LaneResults & res )
+    { rayKernel( q, tris, res ); }
+void segmentDefault( const TriangleBatch & tris, const float d[3], const float e[3], LaneResults & res )
+    { segmentKernel( tris, d, e, res ); }
+
+struct Kernels
+{
+    decltype( &closestPointDefault ) closestPoint = closestPointDefault;
+    decltype( &rayDefault ) ray = rayDefault;
+    decltype( &segmentDefault ) segment = segmentDefault;
+    const char * name = "default";
+};
+
+const Kernels & kernels()
+{
+    static const Kernels res = []
+    {
+        Kernels k;
+#ifdef MR_TRIANGLE_BATCH_AVX2
+        if ( cpuSupportsAvx2() )
+        {
+            k.closestPoint = closestPointAvx2;
+            k.ray = rayAvx2;
+            k.segment = segmentAvx2;
+            k.name = "avx2";
+        }
+#endif
+        return k;
+    }();
+    return res;
+}
+
+} // anonymous namespace
+
+TriangleBatchHit closestPointInTriangles( const Vector3f & p, const TriangleBatch & tris )
+{
+    TriangleBatchHit res;
+    if ( tris.empty() )
+        return res;
+    LaneResults lanes;
+    const float q[3] = { p.x, p.y, p.z };
+    kernels().closestPoint( q, tris, lanes );
+    res.index = 0;
+    for ( int i = 1; i < tris.count; ++i )
+        if ( lanes.value[i] < lanes.value[res.index] )
+            res.index = i;
+    res.value = lanes.value[res.index];
+    res.bary = TriPointf( lanes.a[res.index], lanes.b[res.index] );
+    return res;
+}
+
+TriangleBatchHit rayTrianglesIntersect( const Vector3f & rayOrigin, const IntersectionPrecomputes<float> & prec,
+    const TriangleBatch & tris, float rayStart, float rayEnd )
+{
+    TriangleBatchHit res;
+    if ( tris.empty() )
+        return res;
+    LaneResults lanes;
+    const RayQuery q
+    {
+        .o = { rayOrigin.x, rayOrigin.y, rayOrigin.z },
+        .ix = prec.idxX, .iy = prec.idxY, .iz = prec.maxDimIdxZ,
+        .Sx = prec.Sx, .Sy = prec.Sy, .Sz = prec.Sz,
+        .rayStart = rayStart, .rayEnd = rayEnd
+    };
+    kernels().ray( q, tris, lanes );
+    for ( int i = 0; i < tris.count; ++i )
+    {
+        if ( lanes.hit[i] && ( res.index < 0 || lanes.value[i] < res.value ) )
+        {
+            res.index = i;
+            res.value = lanes.value[i];
+        }
+    }
+    if ( res.valid() )
+        res.bary = TriPointf( lanes.a[res.index], lanes.b[res.index] );
+    return res;
+}
+
+unsigned doTrianglesSegmentIntersect( const TriangleBatch & tris, const Vector3f & d, const Vector3f & e )
+{
+    if ( tris.empty() )
+        return 0;
+    LaneResults lanes;
+    const float dq[3] = { d.x, d.y, d.z };
+    const float eq[3] = { e.x, e.y, e.z };
+    kernels().segment( tris, dq, eq, lanes );
+    unsigned res = 0;
+    for ( int i = 0; i < tris.count; ++i )
+        if ( lanes.hit[i] )
+            res |= 1u << i;
+    return res;
+}
+
+const char * triangleBatchInstructionSet()
+{
+    return kernels().name;
+}
+
+static std::vector<Vector3f> randomTriangleSoup( size_t numTris, unsigned seed )
+{
+    std::mt19937 gen( seed );
+    std::uniform_real_distribution<float> coord( -1.f, 1.f );
+    std::vector<Vector3f> res( 3 * numTris );
+    for ( auto & p : res )
+        p = Vector3f( coord( gen ), coord( gen ), coord( gen ) );
+    return res;
+}
+
+TEST( MRMesh, TriangleBatch )
+{
+    const auto soup = randomTriangleSoup( 5 * TriangleBatch::Size + 3, 7 );
+    const auto points = randomTriangleSoup( 50, 13 );
+    const size_t numTris = soup.size() / 3;
+
+    for ( size_t first = 0; first < numTris; first += TriangleBatch::Size )
+    {
+        TriangleBatch batch;
+        for ( size_t t = first; t < numTris && !batch.full(); ++t )
+            batch.add( soup[3 * t], soup[3 * t + 1], soup[3 * t + 2] );
+
+        for ( size_t q = 0; q + 1 < points.size(); ++q )
+        {
+            const auto & p = points[q];
+
+            // closest point
+            float refDistSq = FLT_MAX;
+            for ( int i = 0; i < batch.count; ++i )
+            {
+                const auto proj = closestPointInTriangle( p, batch.vert( i, 0 ), batch.vert( i, 1 ), batch.vert( i, 2 ) ).first;
+                const float distSq = ( proj - p ).lengthSq();
+                refDistSq = std::min( refDistSq, distSq );
+            }
+            const auto closest = closestPointInTriangles( p, batch );
+            ASSERT_TRUE( closest.valid() );
+            EXPECT_NEAR( closest.value, refDistSq, 1e-5f );
+            const auto a = batch.vert( closest.index, 0 );
+            const auto proj = a + closest.bary.a * ( batch.vert( closest.index, 1 ) - a ) + closest.bary.b * ( batch.vert( closest.index, 2 ) - a );
+            EXPECT_NEAR( ( proj - p ).lengthSq(), refDistSq, 1e-5f );
+
+            // ray
+            const auto dir = points[q + 1] - p;
+            const IntersectionPrecomputes<float> prec( dir );
+            std::optional<TriIntersectResult> refHit;
+            int refHitIndex = -1;
+            for ( int i = 0; i < batch.count; ++i )
+            {
+                auto hit = rayTriangleIntersect( batch.vert( i, 0 ) - p, batch.vert( i, 1 ) - p, batch.vert( i, 2 ) - p, prec );
+                if ( hit && hit->t > 0 && ( !refHit || hit->t < refHit->t ) )
+                {
+                    refHit = hit;
+                    refHitIndex = i;
+                }
+            }
+            const auto hit = rayTrianglesIntersect( p, prec, batch );
+            EXPECT_EQ( hit.index, refHitIndex );
+            if ( refHit && hit )
+            {
+                EXPECT_NEAR( hit.value, refHit->t, 1e-5f );
+            }
+
+            // segment
+            unsigned refMask = 0;
+            for ( int i = 0; i < batch.count; ++i )
+                if ( doTriangleSegmentIntersect( batch.vert( i, 0 ), batch.vert( i, 1 ), batch.vert( i, 2 ), p, points[q + 1] ) )
+                    refMask |= 1u << i;
+            EXPECT_EQ( doTrianglesSegmentIntersect( batch, p, points[q + 1] ), refMask );
+        }
+    }
+}
+
+TEST( MRMesh, TriangleBatchBenchmark )
+{
+    constexpr size_t numTris = 1 << 12;
+    constexpr size_t numQueries = 1 << 10;
+    const auto soup = randomTriangleSoup( numTris, 1 );
+    const auto queries = randomTriangleSoup( numQueries, 2 );
+
+    std::vector<TriangleBatch> batches( numTris / TriangleBatch::Size );
+    for ( size_t t = 0; t < numTris; ++t )
+        batches[t / TriangleBatch::Size].add( soup[3 * t], soup[3 * t + 1], soup[3 * t + 2] );
+
+    // closest point
+    Timer timer( "scalar closest point" );
+    double scalarSum = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( size_t t = 0; t < numTris; ++t )
+            scalarSum += ( closestPointInTriangle( queries[3 * q], soup[3 * t], soup[3 * t + 1], soup[3 * t + 2] ).first - queries[3 * q] ).lengthSq();
+    const double scalarProjMs = 1000 * timer.secondsPassed().count();
+
+    timer.restart( "batch closest point" );
+    double batchSum = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( const auto & b : batches )
+            batchSum += closestPointInTriangles( queries[3 * q], b ).value;
+    const double batchProjMs = 1000 * timer.secondsPassed().count();
+
+    // ray
+    std::vector<IntersectionPrecomputes<float>> precs;
+    for ( size_t q = 0; q < numQueries; ++q )
+        precs.emplace_back( queries[3 * q + 1] - queries[3 * q] );
+
+    timer.restart( "scalar ray" );
+    size_t scalarHits = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( size_t t = 0; t < numTris; ++t )
+            if ( rayTriangleIntersect( soup[3 * t] - queries[3 * q], soup[3 * t + 1] - queries[3 * q], soup[3 * t + 2] - queries[3 * q], precs[q] ) )
+                ++scalarHits;
+    const double scalarRayMs = 1000 * timer.secondsPassed().count();
+
+    timer.restart( "batch ray" );
+    size_t batchHits = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( const auto & b : batches )
+            if ( rayTrianglesIntersect( queries[3 * q], precs[q], b, -FLT_MAX ) )
+                ++batchHits;
+    const double batchRayMs = 1000 * timer.secondsPassed().count();
+
+    // segment
+    timer.restart( "scalar segment" );
+    size_t scalarIsects = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( size_t t = 0; t < numTris; ++t )
+            if ( doTriangleSegmentIntersect( soup[3 * t], soup[3 * t + 1], soup[3 * t + 2], queries[3 * q], queries[3 * q + 1] ) )
+                ++scalarIsects;
+    const double scalarSegMs = 1000 * timer.secondsPassed().count();
+
+    timer.restart( "batch segment" );
+    size_t batchIsects = 0;
+    for ( size_t q = 0; q < numQueries; ++q )
+        for ( const auto & b : batches )
+            batchIsects += std::popcount( doTrianglesSegmentIntersect( b, queries[3 * q], queries[3 * q + 1] ) );
+    const double batchSegMs = 1000 * timer.secondsPassed().count();
+
+    EXPECT_EQ( scalarIsects, batchIsects );
+    EXPECT_GT( scalarSum, batchSum ); // sum of all distances is larger than sum of minimal distances in batches
+    EXPECT_GE( scalarHits, batchHits );
+
+    spdlog::info( "TriangleBatch ({}), {} queries x {} triangles: closest point {:.1f} ms -> {:.1f} ms, ray {:.1f} ms -> {:.1f} ms, segment {:.1f} ms -> {:.1f} ms",
+        triangleBatchInstructionSet(), numQueries, numTris, scalarProjMs, batchProjMs, scalarRayMs, batchRayMs, scalarSegMs, batchSegMs );
+}
+
+} // namespace MR
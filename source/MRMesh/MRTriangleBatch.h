@@ -0,0 +1,81 @@
+#pragma once
+
+#include "MRVector3.h"
+#include "MRTriPoint.h"
+#include "MRIntersectionPrecomputes.h"
+#include <cassert>
+#include <cfloat>
+
+namespace MR
+{
+
+/// \addtogroup MathGroup
+/// \{
+
+/// up to TriangleBatch::Size triangles stored as structure of arrays,
+/// so that one query (point, ray, segment) can be tested against all of them at once using SIMD instructions
+struct TriangleBatch
+{
+    static constexpr int Size = 8;
+
+    /// coordinates of triangle vertices: v[vertex][dimension][triangle]
+    alignas( 32 ) float v[3][3][Size] = {};
+    /// the number of triangles actually stored, the other lanes are ignored by the kernels
+    int count = 0;
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+    [[nodiscard]] bool full() const { return count == Size; }
+    void clear() { count = 0; }
+
+    /// appends one more triangle in the batch, which must not be full
+    void add( const Vector3f & a, const Vector3f & b, const Vector3f & c )
+    {
+        assert( count < Size );
+        for ( int d = 0; d < 3; ++d )
+        {
+            v[0][d][count] = a[d];
+            v[1][d][count] = b[d];
+            v[2][d][count] = c[d];
+        }
+        ++count;
+    }
+
+    /// returns given vertex of i-th triangle
+    [[nodiscard]] Vector3f vert( int i, int vertex ) const
+        { return { v[vertex][0][i], v[vertex][1][i], v[vertex][2][i] }; }
+};
+
+/// the result of a query against a batch of triangles
+struct TriangleBatchHit
+{
+    /// index of found triangle in the batch, -1 if nothing was found
+    int index = -1;
+    /// for closestPointInTriangles: squared distance to the closest point;
+    /// for rayTrianglesIntersect: distance from ray origin in ray direction length units
+    float value = 0;
+    /// barycentric coordinates of found point in the triangle
+    TriPointf bary;
+
+    [[nodiscard]] bool valid() const { return index >= 0; }
+    explicit operator bool() const { return valid(); }
+};
+
+/// finds the closest point to (p) among all triangles of the batch, the same as closestPointInTriangle does for each triangle;
+/// in case of equal distances, the triangle with smaller index is returned
+[[nodiscard]] MRMESH_API TriangleBatchHit closestPointInTriangles( const Vector3f & p, const TriangleBatch & tris );
+
+/// finds the intersection of the ray ( rayOrigin + t * dir ) with the triangles of the batch having smallest t in the interval (rayStart, rayEnd),
+/// the same as rayTriangleIntersect does for each triangle (which takes the triangles with vertices shifted by -rayOrigin)
+[[nodiscard]] MRMESH_API TriangleBatchHit rayTrianglesIntersect( const Vector3f & rayOrigin, const IntersectionPrecomputes<float> & prec,
+    const TriangleBatch & tris, float rayStart = 0, float rayEnd = FLT_MAX );
+
+/// checks segment DE against all triangles of the batch, the same as doTriangleSegmentIntersect does for each triangle;
+/// \return the bit mask with i-th bit set if the segment intersects i-th triangle
+[[nodiscard]] MRMESH_API unsigned doTrianglesSegmentIntersect( const TriangleBatch & tris, const Vector3f & d, const Vector3f & e );
+
+/// returns the name of instruction set selected at runtime for the kernels above, e.g. "avx2" or "default"
+[[nodiscard]] MRMESH_API const char * triangleBatchInstructionSet();
+
+/// \}
+
+} // namespace MR
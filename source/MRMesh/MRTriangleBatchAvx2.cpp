@@ -0,0 +1,45 @@
+#include "MRTriangleBatch.h"
+
+// this file is compiled with AVX2 and FMA enabled: by the pragmas below for GCC and Clang,
+// and by /arch:AVX2 option for MSVC (see MRMesh.vcxproj and CMakeLists.txt);
+// the functions here are called only after runtime check of CPU support in MRTriangleBatch.cpp
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize( "no-trapping-math" )
+#endif
+
+#if ( defined(__x86_64__) || defined(_M_X64) ) && !defined(__EMSCRIPTEN__)
+// after all includes of common headers, so that only the kernels below are affected
+#if defined(__clang__)
+#pragma clang attribute push( __attribute__(( target( "avx2,fma" ) )), apply_to = function )
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target( "avx2,fma" )
+#endif
+
+#include "MRTriangleBatchKernels.h"
+
+namespace MR
+{
+
+namespace TriangleBatchKernels
+{
+
+void closestPointAvx2( const float p[3], const TriangleBatch & tris, LaneResults & res )
+    { closestPointKernel( p, tris, res ); }
+void rayAvx2( const RayQuery & q, const TriangleBatch & tris, LaneResults & res )
+    { rayKernel( q, tris, res ); }
+void segmentAvx2( const TriangleBatch & tris, const float d[3], const float e[3], LaneResults & res )
+    { segmentKernel( tris, d, e, res ); }
+
+} // namespace TriangleBatchKernels
+
+} // namespace MR
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,189 @@
+#pragma once
+
+// private header of MRTriangleBatch.cpp and MRTriangleBatchAvx2.cpp, each of them compiles the kernels for its own instruction set;
+// all functions here have internal linkage and work with plain floats only, so no inline function is shared by the two translation units
+
+#include "MRTriangleBatch.h"
+
+// on x86-64 one more copy of each kernel is compiled for AVX2 in MRTriangleBatchAvx2.cpp and selected at runtime if the CPU supports it
+#if ( defined(__x86_64__) || defined(_M_X64) ) && !defined(__EMSCRIPTEN__)
+#define MR_TRIANGLE_BATCH_AVX2
+#endif
+
+namespace MR
+{
+
+namespace TriangleBatchKernels
+{
+
+constexpr int N = TriangleBatch::Size;
+
+// per-lane results of a kernel
+struct LaneResults
+{
+    alignas( 32 ) float value[N];
+    alignas( 32 ) float a[N];
+    alignas( 32 ) float b[N];
+    alignas( 32 ) int hit[N];
+};
+
+// the ray with the data of IntersectionPrecomputes<float>
+struct RayQuery
+{
+    float o[3];
+    int ix, iy, iz;
+    float Sx, Sy, Sz;
+    float rayStart, rayEnd;
+};
+
+static inline float mixed3( float ax, float ay, float az, float bx, float by, float bz, float cx, float cy, float cz )
+{
+    return ax * ( by * cz - bz * cy ) + ay * ( bz * cx - bx * cz ) + az * ( bx * cy - by * cx );
+}
+
+// the same as closestPointInTriangle, but all region tests are evaluated and the results are selected without branches;
+// here and below the conditions are combined with & and | instead of && and || to avoid control flow preventing vectorization
+static inline void closestPointKernel( const float p[3], const TriangleBatch & tris, LaneResults & __restrict res )
+{
+    const float px = p[0], py = p[1], pz = p[2];
+    const auto & A = tris.v[0];
+    const auto & B = tris.v[1];
+    const auto & C = tris.v[2];
+    for ( int i = 0; i < N; ++i )
+    {
+        const float abx = B[0][i] - A[0][i], aby = B[1][i] - A[1][i], abz = B[2][i] - A[2][i];
+        const float acx = C[0][i] - A[0][i], acy = C[1][i] - A[1][i], acz = C[2][i] - A[2][i];
+        const float apx = px - A[0][i], apy = py - A[1][i], apz = pz - A[2][i];
+        const float bpx = px - B[0][i], bpy = py - B[1][i], bpz = pz - B[2][i];
+        const float cpx = px - C[0][i], cpy = py - C[1][i], cpz = pz - C[2][i];
+
+        const float d1 = abx * apx + aby * apy + abz * apz;
+        const float d2 = acx * apx + acy * apy + acz * apz;
+        const float d3 = abx * bpx + aby * bpy + abz * bpz;
+        const float d4 = acx * bpx + acy * bpy + acz * bpz;
+        const float d5 = abx * cpx + aby * cpy + abz * cpz;
+        const float d6 = acx * cpx + acy * cpy + acz * cpz;
+
+        const float vc = d1 * d4 - d3 * d2;
+        const float vb = d5 * d2 - d1 * d6;
+        const float va = d3 * d6 - d5 * d4;
+
+        // interior of the triangle
+        const float denom = 1.f / ( va + vb + vc );
+        float v = vb * denom;
+        float w = vc * denom;
+
+        // the regions are applied in reverse order of closestPointInTriangle, so that the first matching region wins
+        const float d43 = d4 - d3, d56 = d5 - d6;
+        const float tbc = d43 / ( d43 + d56 );
+        const float sbc = 1 - tbc;
+        const bool onBC = ( va <= 0.f ) & ( d43 >= 0.f ) & ( d56 >= 0.f );
+        v = onBC ? sbc : v;
+        w = onBC ? tbc : w;
+
+        const float tac = d2 / ( d2 - d6 );
+        const bool onAC = ( vb <= 0.f ) & ( d2 >= 0.f ) & ( d6 <= 0.f );
+        v = onAC ? 0.f : v;
+        w = onAC ? tac : w;
+
+        const float tab = d1 / ( d1 - d3 );
+        const bool onAB = ( vc <= 0.f ) & ( d1 >= 0.f ) & ( d3 <= 0.f );
+        v = onAB ? tab : v;
+        w = onAB ? 0.f : w;
+
+        const bool atC = ( d6 >= 0.f ) & ( d5 <= d6 );
+        v = atC ? 0.f : v;
+        w = atC ? 1.f : w;
+
+        const bool atB = ( d3 >= 0.f ) & ( d4 <= d3 );
+        v = atB ? 1.f : v;
+        w = atB ? 0.f : w;
+
+        const bool atA = ( d1 <= 0.f ) & ( d2 <= 0.f );
+        v = atA ? 0.f : v;
+        w = atA ? 0.f : w;
+
+        const float dx = apx - v * abx - w * acx;
+        const float dy = apy - v * aby - w * acy;
+        const float dz = apz - v * abz - w * acz;
+        res.value[i] = dx * dx + dy * dy + dz * dz;
+        res.a[i] = v;
+        res.b[i] = w;
+    }
+}
+
+// the same as rayTriangleIntersect for all lanes
+static inline void rayKernel( const RayQuery & q, const TriangleBatch & tris, LaneResults & __restrict res )
+{
+    const int ix = q.ix, iy = q.iy, iz = q.iz;
+    const float ox = q.o[ix], oy = q.o[iy], oz = q.o[iz];
+    const float Sx = q.Sx, Sy = q.Sy, Sz = q.Sz;
+    const float rayStart = q.rayStart, rayEnd = q.rayEnd;
+    const float * ax = tris.v[0][ix], * ay = tris.v[0][iy], * az = tris.v[0][iz];
+    const float * bx = tris.v[1][ix], * by = tris.v[1][iy], * bz = tris.v[1][iz];
+    const float * cx = tris.v[2][ix], * cy = tris.v[2][iy], * cz = tris.v[2][iz];
+    for ( int i = 0; i < N; ++i )
+    {
+        const float aZ = az[i] - oz, bZ = bz[i] - oz, cZ = cz[i] - oz;
+        const float Ax = ( ax[i] - ox ) - Sx * aZ;
+        const float Ay = ( ay[i] - oy ) - Sy * aZ;
+        const float Bx = ( bx[i] - ox ) - Sx * bZ;
+        const float By = ( by[i] - oy ) - Sy * bZ;
+        const float Cx = ( cx[i] - ox ) - Sx * cZ;
+        const float Cy = ( cy[i] - oy ) - Sy * cZ;
+
+        const float U = Cx * By - Cy * Bx;
+        const float V = Ax * Cy - Ay * Cx;
+        const float W = Bx * Ay - By * Ax;
+
+        const bool hasNeg = ( U < 0.f ) | ( V < 0.f ) | ( W < 0.f );
+        const bool hasPos = ( U > 0.f ) | ( V > 0.f ) | ( W > 0.f );
+        const float det = U + V + W;
+        const float invDet = 1.f / det;
+        const float t = ( U * ( Sz * aZ ) + V * ( Sz * bZ ) + W * ( Sz * cZ ) ) * invDet;
+
+        res.hit[i] = !( hasNeg & hasPos ) & ( det != 0.f ) & ( t > rayStart ) & ( t < rayEnd );
+        res.value[i] = t;
+        res.a[i] = V * invDet;
+        res.b[i] = W * invDet;
+    }
+}
+
+// the same as doTriangleSegmentIntersect for all lanes
+static inline void segmentKernel( const TriangleBatch & tris, const float d[3], const float e[3], LaneResults & __restrict res )
+{
+    const auto & A = tris.v[0];
+    const auto & B = tris.v[1];
+    const auto & C = tris.v[2];
+    const float dx = d[0], dy = d[1], dz = d[2];
+    const float ex = e[0], ey = e[1], ez = e[2];
+    const float dex = dx - ex, dey = dy - ey, dez = dz - ez;
+    for ( int i = 0; i < N; ++i )
+    {
+        const float adx = A[0][i] - dx, ady = A[1][i] - dy, adz = A[2][i] - dz;
+        const float bdx = B[0][i] - dx, bdy = B[1][i] - dy, bdz = B[2][i] - dz;
+        const float cdx = C[0][i] - dx, cdy = C[1][i] - dy, cdz = C[2][i] - dz;
+        const float aex = A[0][i] - ex, aey = A[1][i] - ey, aez = A[2][i] - ez;
+        const float bex = B[0][i] - ex, bey = B[1][i] - ey, bez = B[2][i] - ez;
+        const float cex = C[0][i] - ex, cey = C[1][i] - ey, cez = C[2][i] - ez;
+
+        const float abcd = mixed3( adx, ady, adz, bdx, bdy, bdz, cdx, cdy, cdz );
+        const float abce = mixed3( aex, aey, aez, bex, bey, bez, cex, cey, cez );
+        const float dabe = mixed3( dex, dey, dez, aex, aey, aez, bex, bey, bez );
+        const float dbce = mixed3( dex, dey, dez, bex, bey, bez, cex, cey, cez );
+        const float dcae = mixed3( dex, dey, dez, cex, cey, cez, aex, aey, aez );
+
+        res.hit[i] = ( abcd * abce < 0.f ) & ( dabe * dbce > 0.f ) & ( dbce * dcae > 0.f ) & ( dcae * dabe > 0.f );
+    }
+}
+
+#ifdef MR_TRIANGLE_BATCH_AVX2
+// defined in MRTriangleBatchAvx2.cpp, must be called only if the CPU supports AVX2 and FMA
+void closestPointAvx2( const float p[3], const TriangleBatch & tris, LaneResults & res );
+void rayAvx2( const RayQuery & q, const TriangleBatch & tris, LaneResults & res );
+void segmentAvx2( const TriangleBatch & tris, const float d[3], const float e[3], LaneResults & res );
+#endif
+
+} // namespace TriangleBatchKernels
+
+} // namespace MR
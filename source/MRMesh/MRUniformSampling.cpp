@@ -3,47 +3,148 @@
 #include "MRPointCloud.h"
 #include "MRBox.h"
 #include "MRPointsInBall.h"
+#include "MRBitSetParallelFor.h"
+#include "MRphmap.h"
+#include "MRTimer.h"
+#include "MRGTest.h"
+#include "MRPch/MRTBB.h"
 
 namespace MR
 {
 
+namespace
+{
+
+// cubic tile of space with all points inside it sorted by id
+struct Tile
+{
+    int color = 0; // 0-7 depending on the parities of tile coordinates
+    std::vector<VertId> verts;
+};
+
+} // anonymous namespace
+
 VertBitSet pointUniformSampling( const PointCloud& pointCloud, float distance )
 {
+    MR_TIMER
     auto box = pointCloud.getBoundingBox();
     if ( !box.valid() )
         return {};
 
-    auto axis = ( box.max - box.min ).normalized();
-
-    struct VertProj
+    // the tiles of the same color are separated by at least one tile of greater than distance size,
+    // so no point of one tile can suppress a point of another tile of the same color, and they are processed in parallel
+    constexpr int MaxTilesInDim = 1 << 20;
+    const auto boxSz = box.size();
+    const float maxDim = std::max( { boxSz.x, boxSz.y, boxSz.z } );
+    float tileSize = std::max( 2 * distance, maxDim / ( MaxTilesInDim - 1 ) );
+    if ( !( tileSize > 0 ) )
+        tileSize = 1;
+    const float recipTileSize = 1 / tileSize;
+    auto tileKey = [&]( const Vector3f & p )
     {
-        float projLength{0};
-        VertId id{};
+        const auto q = ( p - box.min ) * recipTileSize;
+        const auto x = (uint64_t)std::clamp( int( q.x ), 0, MaxTilesInDim - 1 );
+        const auto y = (uint64_t)std::clamp( int( q.y ), 0, MaxTilesInDim - 1 );
+        const auto z = (uint64_t)std::clamp( int( q.z ), 0, MaxTilesInDim - 1 );
+        return x | ( y << 20 ) | ( z << 40 );
     };
 
-    auto size = pointCloud.validPoints.count();
-    if ( size == 0 )
-        return {};
+    // parallel binning of points in tiles
+    tbb::enumerable_thread_specific<HashMap<uint64_t, std::vector<VertId>>> threadTiles;
+    BitSetParallelFor( pointCloud.validPoints, [&]( VertId v )
+    {
+        threadTiles.local()[tileKey( pointCloud.points[v] )].push_back( v );
+    } );
 
-    std::vector<VertProj> projes( size );
-    int n = 0;
-    for ( auto v : pointCloud.validPoints )
-        projes[n++] = {dot( pointCloud.points[v],axis ),v};
+    HashMap<uint64_t, size_t> key2tile;
+    std::vector<Tile> tiles;
+    for ( auto & tt : threadTiles )
+    {
+        for ( auto & [key, verts] : tt )
+        {
+            auto [it, inserted] = key2tile.insert( { key, tiles.size() } );
+            if ( inserted )
+            {
+                auto & tile = tiles.emplace_back();
+                tile.color = int( ( key & 1 ) | ( ( key >> 19 ) & 2 ) | ( ( key >> 38 ) & 4 ) );
+                tile.verts = std::move( verts );
+            }
+            else
+            {
+                auto & tileVerts = tiles[it->second].verts;
+                tileVerts.insert( tileVerts.end(), verts.begin(), verts.end() );
+            }
+        }
+    }
+    threadTiles.clear();
 
-    VertBitSet res( pointCloud.validPoints.size() );
-    for ( const auto& proj : projes )
+    // within each tile the points are considered in the order of their ids independently of the binning threads
+    std::array<std::vector<size_t>, 8> colorTiles;
+    for ( size_t i = 0; i < tiles.size(); ++i )
+        colorTiles[tiles[i].color].push_back( i );
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, tiles.size(), 1 ), [&]( const tbb::blocked_range<size_t> & range )
     {
-        bool ballHasPrevVert = false;
-        findPointsInBall( pointCloud, pointCloud.points[proj.id], distance, [&res,&ballHasPrevVert]( VertId v, const Vector3f& )
+        for ( size_t i = range.begin(); i < range.end(); ++i )
+            std::sort( tiles[i].verts.begin(), tiles[i].verts.end() );
+    } );
+
+    // separate bytes instead of bits to let the threads write them simultaneously
+    Vector<char, VertId> selected( pointCloud.points.size(), 0 );
+    for ( const auto & ct : colorTiles )
+    {
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0, ct.size(), 1 ), [&]( const tbb::blocked_range<size_t> & range )
         {
-            if ( !ballHasPrevVert && res.test( v ) )
-                ballHasPrevVert = true;
+            for ( size_t i = range.begin(); i < range.end(); ++i )
+            {
+                for ( auto v : tiles[ct[i]].verts )
+                {
+                    bool ballHasPrevVert = false;
+                    findPointsInBall( pointCloud, pointCloud.points[v], distance, [&selected, &ballHasPrevVert]( VertId u, const Vector3f& )
+                    {
+                        if ( !ballHasPrevVert && selected[u] )
+                            ballHasPrevVert = true;
+                    } );
+                    if ( !ballHasPrevVert )
+                        selected[v] = 1;
+                }
+            }
         } );
-        if ( !ballHasPrevVert )
-            res.set( proj.id );
     }
 
+    VertBitSet res( pointCloud.validPoints.size() );
+    BitSetParallelForAll( res, [&]( VertId v )
+    {
+        if ( selected[v] )
+            res.set( v );
+    } );
     return res;
 }
 
+TEST( MRMesh, PointUniformSampling )
+{
+    PointCloud pc;
+    for ( int x = 0; x < 60; ++x )
+        for ( int y = 0; y < 60; ++y )
+            for ( int z = 0; z < 4; ++z )
+                pc.addPoint( Vector3f( x + 0.3f * std::sin( 1.7f * y + z ), y + 0.3f * std::cos( 2.3f * x ), 0.5f * z ) );
+
+    const float distance = 2.5f;
+    const auto samples = pointUniformSampling( pc, distance );
+    EXPECT_EQ( samples, pointUniformSampling( pc, distance ) );
+
+    for ( auto v : pc.validPoints )
+    {
+        int numNearSamples = 0;
+        findPointsInBall( pc, pc.points[v], distance, [&]( VertId u, const Vector3f& )
+        {
+            if ( u != v && samples.test( u ) )
+                ++numNearSamples;
+        } );
+        if ( samples.test( v ) )
+            EXPECT_EQ( numNearSamples, 0 ); // samples are not closer than distance
+        else
+            EXPECT_GT( numNearSamples, 0 ); // any point is close to some sample
+    }
+}
+
 }
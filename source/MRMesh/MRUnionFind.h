@@ -1,6 +1,8 @@
 #pragma once
 
 #include "MRVector.h"
+#include <atomic>
+#include <vector>
 
 namespace MR
 {
@@ -84,4 +86,89 @@ private:
     Vector<int, I> sizes_;
 };
 
+/**
+ * \brief Union find data structure allowing concurrent unite and find calls from several threads
+ * \details Each set is linked to the set with smaller root (instead of union by size), and the paths are halved by compare-and-swap,
+ * so the roots after all unions are the smallest elements of their sets independently of threads scheduling
+ * \tparam I is an id type, e.g. FaceId
+ * \ingroup BasicGroup
+ */
+template <typename I>
+class AtomicUnionFind
+{
+public:
+    AtomicUnionFind() = default;
+    AtomicUnionFind( size_t size )
+    {
+        reset( size );
+    }
+    /// reset roots to represent each element as disjoint set
+    void reset( size_t size )
+    {
+        parents_ = std::vector<std::atomic<int>>( size );
+        for ( size_t i = 0; i < size; ++i )
+            parents_[i].store( int( i ), std::memory_order_relaxed );
+    }
+    /// the number of elements
+    size_t size() const
+    {
+        return parents_.size();
+    }
+    /// unite two elements, returns new common root (if no other thread changes the sets of these elements at the same time)
+    I unite( I first, I second )
+    {
+        int a = getRoot_( first );
+        int b = getRoot_( second );
+        for (;;)
+        {
+            if ( a == b )
+                return I( a );
+            if ( a < b )
+                std::swap( a, b );
+            // link larger root to smaller one, failure means that other thread has just linked a
+            int expected = a;
+            if ( parents_[a].compare_exchange_strong( expected, b ) )
+                return I( b );
+            a = getRoot_( a );
+            b = getRoot_( b );
+        }
+    }
+    /// returns true if given two elements are from one component (if no other thread changes the sets of these elements at the same time)
+    bool united( I first, I second )
+    {
+        for (;;)
+        {
+            int a = getRoot_( first );
+            int b = getRoot_( second );
+            if ( a == b )
+                return true;
+            // a is still root, so the sets were different at the moment of the check
+            if ( parents_[a].load() == a )
+                return false;
+        }
+    }
+    /// finds root of element
+    I find( I a )
+    {
+        return I( getRoot_( a ) );
+    }
+private:
+    int getRoot_( int a )
+    {
+        for (;;)
+        {
+            int p = parents_[a].load( std::memory_order_relaxed );
+            if ( p == a )
+                return a;
+            int gp = parents_[p].load( std::memory_order_relaxed );
+            // path halving: parents only decrease, so concurrent change of a's parent is never undone
+            if ( p != gp )
+                parents_[a].compare_exchange_weak( p, gp, std::memory_order_relaxed );
+            a = gp;
+        }
+    }
+    /// parent of each element, the parent of root is the element itself
+    std::vector<std::atomic<int>> parents_;
+};
+
 }
@@ -2,6 +2,7 @@
 #include "MRAABBTree.h"
 #include "MRAABBTreePolyline.h"
 #include "MRAABBTreePoints.h"
+#include "MRMeshNormals.h"
 #include "MRHeapBytes.h"
 #include "MRPch/MRTBB.h"
 #include <cassert>
@@ -84,6 +85,19 @@ const T & UniqueThreadSafeOwner<T>::getOrCreate( const std::function<T()> & crea
     return *obj_;
 }
 
+template<typename T>
+void UniqueThreadSafeOwner<T>::update( const std::function<void(T&)> & updater )
+{
+    std::unique_lock lock( mutex_ );
+    if ( obj_ )
+    {
+        tbb::this_task_arena::isolate( [&]
+        {
+            updater( *obj_ );
+        } );
+    }
+}
+
 template<typename T>
 size_t UniqueThreadSafeOwner<T>::heapBytes() const
 {
@@ -95,5 +109,6 @@ template class UniqueThreadSafeOwner<AABBTree>;
 template class UniqueThreadSafeOwner<AABBTreePolyline2>;
 template class UniqueThreadSafeOwner<AABBTreePolyline3>;
 template class UniqueThreadSafeOwner<AABBTreePoints>;
+template class UniqueThreadSafeOwner<MeshNormals>;
 
 } //namespace MR
@@ -206,6 +206,46 @@ FloatGrid simpleVolumeToDenseGrid( const SimpleVolume& simpleVolue,
     return MakeFloatGrid( std::move( grid ) );
 }
 
+template <typename T>
+FloatGrid typedVolumeToDenseGrid( const TypedSimpleVolume<T>& simpleVolume, const ProgressCallback& cb )
+{
+    MR_TIMER;
+    if ( cb && !cb( 0.0f ) )
+        return {};
+    std::shared_ptr<openvdb::FloatGrid> grid = std::make_shared<openvdb::FloatGrid>();
+    const auto& dims = simpleVolume.dims;
+    if ( dims.x <= 0 || dims.y <= 0 || dims.z <= 0 )
+        return MakeFloatGrid( std::move( grid ) );
+
+    // convert the volume by slabs of leaf node depth,
+    // so only one slab of float values exists at any moment instead of full float copy of the volume
+    constexpr int cSlabDepth = int( openvdb::FloatTree::LeafNodeType::DIM );
+    const size_t sizeXY = size_t( dims.x ) * dims.y;
+    std::vector<float> slab( sizeXY * std::min( cSlabDepth, dims.z ) );
+    for ( int z0 = 0; z0 < dims.z; z0 += cSlabDepth )
+    {
+        const int z1 = std::min( z0 + cSlabDepth, dims.z );
+        const size_t first = sizeXY * z0;
+        const size_t num = sizeXY * ( z1 - z0 );
+        tbb::parallel_for( tbb::blocked_range<size_t>( 0, num ), [&] ( const tbb::blocked_range<size_t>& range )
+        {
+            for ( size_t i = range.begin(); i < range.end(); ++i )
+                slab[i] = simpleVolume.value( first + i );
+        } );
+        openvdb::math::CoordBBox slabBBox( openvdb::math::Coord( 0, 0, z0 ), openvdb::math::Coord( dims.x - 1, dims.y - 1, z1 - 1 ) );
+        openvdb::tools::Dense<float, openvdb::tools::LayoutXYZ> dense( slabBBox, slab.data() );
+        openvdb::tools::copyFromDense( dense, *grid, denseVolumeToGridTolerance );
+        if ( cb && !cb( float( z1 ) / dims.z ) )
+            return {};
+    }
+    return MakeFloatGrid( std::move( grid ) );
+}
+
+FloatGrid simpleVolumeToDenseGrid( const SimpleVolumeU16& simpleVolume, const ProgressCallback& cb )
+{
+    return typedVolumeToDenseGrid( simpleVolume, cb );
+}
+
 tl::expected<Mesh, std::string> gridToMesh( const FloatGrid& grid, const Vector3f& voxelSize, 
     int maxFaces,
     float offsetVoxels, float adaptivity,
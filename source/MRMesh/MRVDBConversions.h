@@ -30,6 +30,12 @@ MRMESH_API FloatGrid meshToDistanceField( const MeshPart& mp, const AffineXf3f&
 MRMESH_API FloatGrid simpleVolumeToDenseGrid( const SimpleVolume& simpleVolue,
                                               const ProgressCallback& cb = {} );
 
+// make FloatGrid from the volume stored in compact type
+// the conversion is performed by slabs of few layers, so full float copy of the volume never exists
+// returns null if was canceled by progress callback
+MRMESH_API FloatGrid simpleVolumeToDenseGrid( const SimpleVolumeU16& simpleVolume,
+                                              const ProgressCallback& cb = {} );
+
 // isoValue - layer of grid with this value would be converted in mesh
 // isoValue can be negative only in level set grids
 // adaptivity - [0.0;1.0] ratio of combining small triangles into bigger ones 
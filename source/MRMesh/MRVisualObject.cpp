@@ -347,6 +347,11 @@ size_t VisualObject::heapBytes() const
         + MR::heapBytes( renderObj_ );
 }
 
+size_t VisualObject::renderBuffersHeapBytes() const
+{
+    return MR::heapBytes( renderObj_ );
+}
+
 void VisualObject::boundingBoxToInfoLines_( std::vector<std::string> & res ) const
 {
     auto bbox = getBoundingBox();
@@ -189,6 +189,10 @@ public:
 
     /// returns the amount of memory this object occupies on heap
     [[nodiscard]] MRMESH_API virtual size_t heapBytes() const override;
+    /// returns the amount of memory the buffers prepared for rendering of this object occupy on heap (part of heapBytes())
+    [[nodiscard]] MRMESH_API size_t renderBuffersHeapBytes() const;
+    /// returns the amount of memory the cached vertex normals of this object occupy on heap (part of heapBytes())
+    [[nodiscard]] size_t normalsCacheHeapBytes() const { return vertsNormalsCache_.heapBytes(); }
 
 protected:
 
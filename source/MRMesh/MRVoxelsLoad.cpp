@@ -5,6 +5,9 @@
 #include "MRObjectVoxels.h"
 #include "MRVDBConversions.h"
 #include "MRStringConvert.h"
+#include "MRFloatGrid.h"
+#include "MRSystem.h"
+#include "MRGTest.h"
 #include <gdcmImageHelper.h>
 #include <gdcmImageReader.h>
 #include <gdcmTagKeywords.h>
@@ -139,6 +142,37 @@ std::function<float( char* )> getTypeConverter( const gdcm::PixelFormat& format,
     return {};
 }
 
+// returns converter of 8-bit and 16-bit integer pixels in uint16_t shifted by min, empty function for other formats
+std::function<uint16_t( char* )> getCompactTypeConverter( const gdcm::PixelFormat& format, const int64_t& min )
+{
+    switch ( gdcm::PixelFormat::ScalarType( format ) )
+    {
+    case gdcm::PixelFormat::UINT8:
+        return [min]( char* c )
+        {
+            return uint16_t( *(uint8_t*) (c) -min );
+        };
+    case gdcm::PixelFormat::UINT16:
+        return [min]( char* c )
+        {
+            return uint16_t( *(uint16_t*) (c) -min );
+        };
+    case gdcm::PixelFormat::INT8:
+        return [min]( char* c )
+        {
+            return uint16_t( *(int8_t*) (c) -min );
+        };
+    case gdcm::PixelFormat::INT16:
+        return [min]( char* c )
+        {
+            return uint16_t( *(int16_t*) (c) -min );
+        };
+    default:
+        break;
+    }
+    return {};
+}
+
 bool isDICOMFile( const std::filesystem::path& path )
 {
     gdcm::ImageReader ir;
@@ -175,9 +209,14 @@ struct DCMFileLoadResult
     float min = FLT_MAX;
     float max = -FLT_MAX;
     std::string seriesDescription;
+    /// true if the file was read successfully, but its pixel type cannot be stored in given volume
+    bool unsupportedType = false;
+    /// multiplier to get real value from the stored one
+    float realScale = 1.0f;
 };
 
-DCMFileLoadResult loadSingleFile( const std::filesystem::path& path, SimpleVolume& data, size_t offset )
+template <typename VolumeT>
+DCMFileLoadResult loadSingleFile( const std::filesystem::path& path, VolumeT& data, size_t offset )
 {
     MR_TIMER;
     DCMFileLoadResult res;
@@ -277,7 +316,22 @@ DCMFileLoadResult loadSingleFile( const std::filesystem::path& path, SimpleVolum
     auto min = gimage.GetPixelFormat().GetMin();
     auto max = gimage.GetPixelFormat().GetMax();
     auto pixelSize = gimage.GetPixelFormat().GetPixelSize();
-    auto caster = getTypeConverter( gimage.GetPixelFormat(), max - min, min );
+    using ValueType = typename decltype( VolumeT::data )::value_type;
+    std::function<ValueType( char* )> caster;
+    if constexpr ( std::is_same_v<VolumeT, SimpleVolume> )
+    {
+        caster = getTypeConverter( gimage.GetPixelFormat(), max - min, min );
+    }
+    else
+    {
+        caster = getCompactTypeConverter( gimage.GetPixelFormat(), min );
+        res.realScale = 1.0f / float( max - min );
+        if ( !caster )
+        {
+            res.unsupportedType = true;
+            return res;
+        }
+    }
     if ( !caster )
     {
         spdlog::error( "loadSingle: cannot make type converter, file: {}", utf8string( path ) );
@@ -303,10 +357,11 @@ DCMFileLoadResult loadSingleFile( const std::filesystem::path& path, SimpleVolum
         auto correctZOffset = needInvertZ ? ( dimXYZinv - zOffset ) : zOffset;
         for ( size_t i = 0; i < dimXY; ++i )
         {
-            auto f = caster( &cacheBuffer[( correctZOffset + i ) * pixelSize] );
+            auto v = caster( &cacheBuffer[( correctZOffset + i ) * pixelSize] );
+            auto f = v * res.realScale;
             res.min = std::min( res.min, f );
             res.max = std::max( res.max, f );
-            data.data[zOffset + offset + i] = f;
+            data.data[zOffset + offset + i] = v;
         }
     }
     res.success = true;
@@ -377,60 +432,16 @@ void sortDICOMFiles( std::vector<std::filesystem::path>& files, unsigned maxNumT
     }
 }
 
-std::shared_ptr<ObjectVoxels> loadDCMFolder( const std::filesystem::path& path,
-                                             unsigned maxNumThreads,
-                                             const ProgressCallback& cb )
+template <typename VolumeT>
+std::shared_ptr<ObjectVoxels> loadSortedDCMFiles( const std::vector<std::filesystem::path>& files, VolumeT& data,
+    unsigned maxNumThreads, const ProgressCallback& cb, bool& unsupportedType )
 {
-    MR_TIMER;
-    if ( cb )
-        if ( !cb( 0.0f ) )
-            return {};
-
-    SimpleVolume data;
-    data.dims = Vector3i::diagonal( 0 );
-    std::error_code ec;
-    if ( !std::filesystem::is_directory( path, ec ) )
-    {
-        spdlog::error( "loadDCMFolder: path is not directory" );
-        return {};
-    }
-    int filesNum = 0;
-    std::vector<std::filesystem::path> files;
-    const std::filesystem::directory_iterator dirEnd;
-    for ( auto it = std::filesystem::directory_iterator( path, ec ); !ec && it != dirEnd; it.increment( ec ) )
-    {
-        if ( it->is_regular_file( ec ) )
-            ++filesNum;
-    }
-    files.reserve( filesNum );
-    int fCounter = 0;
-    for ( auto it = std::filesystem::directory_iterator( path, ec ); !ec && it != dirEnd; it.increment( ec ) )
-    {
-        ++fCounter;
-        auto filePath = it->path();
-        if ( it->is_regular_file( ec ) && isDICOMFile( filePath ) )
-            files.push_back( filePath );
-        if ( cb )
-            cb( 0.3f * float( fCounter ) / float( filesNum ) );
-    }
-    if ( files.empty() )
-    {
-        spdlog::error( "loadDCMFolder: there is no dcm file in folder: {}", utf8string( path ) );
-        return {};
-    }
-    if ( files.size() == 1 )
-        return loadDCMFile( files[0], [&]( float proc )
-    {
-        if ( cb )
-            cb( 0.4f + 0.6f * proc );
-        return true;
-    } );
-    sortDICOMFiles( files, maxNumThreads, data.voxelSize );
-    data.dims.z = (int) files.size();
-
     auto firstRes = loadSingleFile( files.front(), data, 0 );
+    unsupportedType = firstRes.unsupportedType;
     if ( !firstRes.success )
         return {};
+    if constexpr ( !std::is_same_v<VolumeT, SimpleVolume> )
+        data.scale = firstRes.realScale;
     data.min = firstRes.min;
     data.max = firstRes.max;
     size_t dimXY = data.dims.x * data.dims.y;
@@ -484,6 +495,70 @@ std::shared_ptr<ObjectVoxels> loadDCMFolder( const std::filesystem::path& path,
     return std::make_shared<ObjectVoxels>( std::move( voxels ) );
 }
 
+std::shared_ptr<ObjectVoxels> loadDCMFolder( const std::filesystem::path& path,
+                                             unsigned maxNumThreads,
+                                             const ProgressCallback& cb )
+{
+    MR_TIMER;
+    if ( cb )
+        if ( !cb( 0.0f ) )
+            return {};
+
+    SimpleVolume data;
+    data.dims = Vector3i::diagonal( 0 );
+    std::error_code ec;
+    if ( !std::filesystem::is_directory( path, ec ) )
+    {
+        spdlog::error( "loadDCMFolder: path is not directory" );
+        return {};
+    }
+    int filesNum = 0;
+    std::vector<std::filesystem::path> files;
+    const std::filesystem::directory_iterator dirEnd;
+    for ( auto it = std::filesystem::directory_iterator( path, ec ); !ec && it != dirEnd; it.increment( ec ) )
+    {
+        if ( it->is_regular_file( ec ) )
+            ++filesNum;
+    }
+    files.reserve( filesNum );
+    int fCounter = 0;
+    for ( auto it = std::filesystem::directory_iterator( path, ec ); !ec && it != dirEnd; it.increment( ec ) )
+    {
+        ++fCounter;
+        auto filePath = it->path();
+        if ( it->is_regular_file( ec ) && isDICOMFile( filePath ) )
+            files.push_back( filePath );
+        if ( cb )
+            cb( 0.3f * float( fCounter ) / float( filesNum ) );
+    }
+    if ( files.empty() )
+    {
+        spdlog::error( "loadDCMFolder: there is no dcm file in folder: {}", utf8string( path ) );
+        return {};
+    }
+    if ( files.size() == 1 )
+        return loadDCMFile( files[0], [&]( float proc )
+    {
+        if ( cb )
+            cb( 0.4f + 0.6f * proc );
+        return true;
+    } );
+    sortDICOMFiles( files, maxNumThreads, data.voxelSize );
+    data.dims.z = (int) files.size();
+
+    // try to keep voxels in their native 16-bit storage to halve memory consumption
+    SimpleVolumeU16 compactData;
+    compactData.dims = data.dims;
+    compactData.voxelSize = data.voxelSize;
+    bool unsupportedType = false;
+    auto res = loadSortedDCMFiles( files, compactData, maxNumThreads, cb, unsupportedType );
+    if ( !unsupportedType )
+        return res;
+    // pixels cannot be stored in 16 bits, so load them as floats
+    compactData = {};
+    return loadSortedDCMFiles( files, data, maxNumThreads, cb, unsupportedType );
+}
+
 std::vector<std::shared_ptr<ObjectVoxels>> loadDCMFolderTree( const std::filesystem::path& path, unsigned maxNumThreads, const ProgressCallback& cb )
 {
     MR_TIMER;
@@ -505,20 +580,20 @@ std::vector<std::shared_ptr<ObjectVoxels>> loadDCMFolderTree( const std::filesys
     return res;
 }
 
-std::shared_ptr<ObjectVoxels> loadDCMFile( const std::filesystem::path& path, const ProgressCallback& cb )
+template <typename VolumeT>
+std::shared_ptr<ObjectVoxels> loadDCMFile( const std::filesystem::path& path, VolumeT& simpleVolume,
+    const ProgressCallback& cb, bool& unsupportedType )
 {
-    MR_TIMER;
-    if ( cb )
-        if ( !cb( 0.0f ) )
-            return {};
-    SimpleVolume simpleVolume;
     simpleVolume.dims.z = 1;
     auto fileRes = loadSingleFile( path, simpleVolume, 0 );
+    unsupportedType = fileRes.unsupportedType;
     if ( !fileRes.success )
         return {};
     if ( cb )
         if ( !cb( 0.5f ) )
             return {};
+    if constexpr ( !std::is_same_v<VolumeT, SimpleVolume> )
+        simpleVolume.scale = fileRes.realScale;
     simpleVolume.max = fileRes.max;
     simpleVolume.min = fileRes.min; ObjectVoxels voxels;
 
@@ -532,6 +607,21 @@ std::shared_ptr<ObjectVoxels> loadDCMFile( const std::filesystem::path& path, co
     return std::make_shared<ObjectVoxels>( std::move( voxels ) );
 }
 
+std::shared_ptr<ObjectVoxels> loadDCMFile( const std::filesystem::path& path, const ProgressCallback& cb )
+{
+    MR_TIMER;
+    if ( cb )
+        if ( !cb( 0.0f ) )
+            return {};
+    bool unsupportedType = false;
+    SimpleVolumeU16 compactVolume;
+    auto res = loadDCMFile( path, compactVolume, cb, unsupportedType );
+    if ( !unsupportedType )
+        return res;
+    SimpleVolume simpleVolume;
+    return loadDCMFile( path, simpleVolume, cb, unsupportedType );
+}
+
 tl::expected<SimpleVolume, std::string> loadRaw( const std::filesystem::path& path,
     const ProgressCallback& cb )
 {
@@ -750,6 +840,141 @@ tl::expected<SimpleVolume, std::string> loadRaw( const std::filesystem::path& pa
     return outVolume;
 }
 
+tl::expected<SimpleVolumeU16, std::string> loadRawCompact( const std::filesystem::path& path, const RawParameters& params,
+    const ProgressCallback& cb )
+{
+    MR_TIMER;
+    if ( params.dimensions.x <= 0 || params.dimensions.y <= 0 || params.dimensions.z <= 0 ||
+        params.voxelSize.x == 0.0f || params.voxelSize.y == 0.0f || params.voxelSize.z == 0.0f )
+        return tl::make_unexpected( "Bad parameters for reading " + utf8string( path.filename() ) );
+
+    // the same normalization as in loadRaw: real value = ( raw - typeMin ) / ( typeMax - typeMin )
+    int unitSize = 0;
+    int64_t typeMin = 0;
+    int64_t typeMax = 0;
+    switch ( params.scalarType )
+    {
+    case RawParameters::ScalarType::UInt8:
+        unitSize = 1;
+        typeMax = std::numeric_limits<uint8_t>::max();
+        break;
+    case RawParameters::ScalarType::Int8:
+        unitSize = 1;
+        typeMin = std::numeric_limits<int8_t>::lowest();
+        typeMax = std::numeric_limits<int8_t>::max();
+        break;
+    case RawParameters::ScalarType::UInt16:
+        unitSize = 2;
+        typeMax = std::numeric_limits<uint16_t>::max();
+        break;
+    case RawParameters::ScalarType::Int16:
+        unitSize = 2;
+        typeMin = std::numeric_limits<int16_t>::lowest();
+        typeMax = std::numeric_limits<int16_t>::max();
+        break;
+    default:
+        return tl::make_unexpected( "Only 8-bit and 16-bit scalar types can be loaded in compact volume" );
+    }
+
+    SimpleVolumeU16 outVolume;
+    outVolume.dims = params.dimensions;
+    outVolume.voxelSize = params.voxelSize;
+    outVolume.scale = 1.0f / float( typeMax - typeMin );
+    outVolume.data.resize( size_t( outVolume.dims.x ) * outVolume.dims.y * outVolume.dims.z );
+
+    std::ifstream infile( path, std::ios::binary );
+    const size_t xyDims = size_t( params.dimensions.x ) * params.dimensions.y;
+    std::vector<char> slice( xyDims * unitSize );
+    uint16_t minRaw = std::numeric_limits<uint16_t>::max();
+    uint16_t maxRaw = 0;
+    for ( int z = 0; z < params.dimensions.z; ++z )
+    {
+        if ( !infile.read( slice.data(), slice.size() ) )
+            return tl::make_unexpected( "Cannot read file: " + utf8string( path ) );
+        uint16_t* out = outVolume.data.data() + xyDims * z;
+        for ( size_t i = 0; i < xyDims; ++i )
+        {
+            int64_t raw = 0;
+            switch ( params.scalarType )
+            {
+            case RawParameters::ScalarType::UInt8:
+                raw = *(uint8_t*) &slice[i];
+                break;
+            case RawParameters::ScalarType::Int8:
+                raw = *(int8_t*) &slice[i];
+                break;
+            case RawParameters::ScalarType::UInt16:
+                raw = *(uint16_t*) &slice[2 * i];
+                break;
+            default:
+                raw = *(int16_t*) &slice[2 * i];
+                break;
+            }
+            const auto v = uint16_t( raw - typeMin );
+            out[i] = v;
+            minRaw = std::min( minRaw, v );
+            maxRaw = std::max( maxRaw, v );
+        }
+        if ( cb && !cb( ( z + 1.0f ) / float( params.dimensions.z ) ) )
+            return tl::make_unexpected( "Loading canceled" );
+    }
+    outVolume.min = outVolume.scale * minRaw;
+    outVolume.max = outVolume.scale * maxRaw;
+    return outVolume;
+}
+
+TEST( MRMesh, LoadRawCompact )
+{
+    RawParameters params;
+    params.dimensions = { 5, 4, 11 };
+    params.voxelSize = Vector3f::diagonal( 0.1f );
+    params.scalarType = RawParameters::ScalarType::Int16;
+
+    const size_t num = size_t( params.dimensions.x ) * params.dimensions.y * params.dimensions.z;
+    std::vector<int16_t> raw( num );
+    for ( size_t i = 0; i < num; ++i )
+        raw[i] = int16_t( int( i * 37 % 2001 ) - 1000 );
+    const auto path = GetTempDirectory() / "MRLoadRawCompactTest.raw";
+    {
+        std::ofstream out( path, std::ios::binary );
+        out.write( ( const char* )raw.data(), raw.size() * sizeof( int16_t ) );
+    }
+
+    auto full = loadRaw( path, params );
+    auto compact = loadRawCompact( path, params );
+    std::error_code ec;
+    std::filesystem::remove( path, ec );
+    ASSERT_TRUE( full.has_value() );
+    ASSERT_TRUE( compact.has_value() );
+
+    EXPECT_EQ( compact->dims, full->dims );
+    EXPECT_EQ( compact->data.size(), full->data.size() );
+    // the loaded volume occupies exactly 2 bytes per voxel, without any float copy kept aside
+    EXPECT_EQ( compact->heapBytes(), num * sizeof( uint16_t ) );
+    EXPECT_EQ( 2 * compact->heapBytes(), full->data.size() * sizeof( float ) );
+    EXPECT_NEAR( compact->min, full->min, 1e-6f );
+    EXPECT_NEAR( compact->max, full->max, 1e-6f );
+    for ( size_t i = 0; i < num; ++i )
+        EXPECT_NEAR( compact->value( i ), full->data[i], 1e-6f );
+
+    // the grid filled by slabs from compact volume is the same as the one from float volume
+    auto fullGrid = simpleVolumeToDenseGrid( *full );
+    auto compactGrid = simpleVolumeToDenseGrid( *compact );
+    ASSERT_TRUE( fullGrid && compactGrid );
+    const auto fullAccessor = fullGrid->getConstAccessor();
+    const auto compactAccessor = compactGrid->getConstAccessor();
+    for ( int z = 0; z < params.dimensions.z; ++z )
+    for ( int y = 0; y < params.dimensions.y; ++y )
+    for ( int x = 0; x < params.dimensions.x; ++x )
+    {
+        const openvdb::Coord c( x, y, z );
+        EXPECT_NEAR( compactAccessor.getValue( c ), fullAccessor.getValue( c ), 1e-6f );
+    }
+
+    params.scalarType = RawParameters::ScalarType::Float32;
+    EXPECT_FALSE( loadRawCompact( path, params ).has_value() );
+}
+
 }
 }
 #endif
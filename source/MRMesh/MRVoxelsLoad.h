@@ -27,6 +27,8 @@ MRMESH_API void sortFilesByName( std::vector<std::filesystem::path>& scans );
 /// SimpleVolume dimensions: x,y equals to x,y dimensions of DICOM picture,
 ///                          z - number of pictures loaded
 /// Files in folder are sorted by names
+/// 8-bit and 16-bit pictures are kept in compact 16-bit storage till conversion in grid,
+/// the object itself stores the volume in the float grid as before
 MRMESH_API std::shared_ptr<ObjectVoxels> loadDCMFolder( const std::filesystem::path& path,
                                                         unsigned maxNumThreads = 4,
                                                         const ProgressCallback& cb = {} );
@@ -58,11 +60,23 @@ struct RawParameters
         Float64,
         Count
     } scalarType{ ScalarType::Float32 };
+
+    /// returns true if voxels of this scalar type fit in 16-bit storage and can be loaded by loadRawCompact
+    bool isCompactType() const
+    {
+        return scalarType == ScalarType::UInt8 || scalarType == ScalarType::Int8 ||
+            scalarType == ScalarType::UInt16 || scalarType == ScalarType::Int16;
+    }
 };
 /// Load raw voxels file with provided parameters
 MRMESH_API tl::expected<SimpleVolume, std::string> loadRaw( const std::filesystem::path& path, const RawParameters& params,
                                                       const ProgressCallback& cb = {} );
 
+/// Load raw voxels file with provided parameters keeping voxels in 16-bit storage instead of converting them in floats,
+/// voxel values are the same as returned by loadRaw; only 8-bit and 16-bit scalar types are supported
+MRMESH_API tl::expected<SimpleVolumeU16, std::string> loadRawCompact( const std::filesystem::path& path, const RawParameters& params,
+                                                      const ProgressCallback& cb = {} );
+
 /// Load raw voxels file, parsing parameters from name 
 MRMESH_API tl::expected<SimpleVolume, std::string> loadRaw( const std::filesystem::path& path,
                                                       const ProgressCallback& cb = {} );
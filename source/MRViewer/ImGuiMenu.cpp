@@ -34,6 +34,7 @@
 #include "MRMesh/MRChangeXfAction.h"
 #include "MRMeshModifier.h"
 #include "MRPch/MRSpdlog.h"
+#include "MRBackgroundJobs.h"
 #include "MRProgressBar.h"
 #include "MRFileDialog.h"
 
@@ -1981,6 +1982,7 @@ void ImGuiMenu::draw_mr_menu()
 {
     // Mesh
     ProgressBar::setup( menu_scaling() );
+    BackgroundJobs::draw( menu_scaling() );
     const auto& viewportParameters = viewer->viewport().getParameters();
     if ( ImGui::CollapsingHeader( "Main", ImGuiTreeNodeFlags_DefaultOpen ) )
     {
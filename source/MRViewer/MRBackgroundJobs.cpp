@@ -0,0 +1,301 @@
+#include "MRBackgroundJobs.h"
+#include "MRCommandLoop.h"
+#include "MRViewer.h"
+#include "ImGuiMenu.h"
+#include "MRMesh/MRSystem.h"
+#include "MRPch/MRSpdlog.h"
+#include "MRPch/MRTBB.h"
+#include <GLFW/glfw3.h>
+#include <imgui.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace MR
+{
+
+struct BackgroundJobs::Job
+{
+    JobId id = 0;
+    JobParams params;
+    Task task;
+    State state = State::Pending;
+    std::atomic<float> progress{ 0.0f };
+    std::atomic<bool> canceled{ false };
+    std::atomic<long long> lastPostEventMs{ 0 };
+};
+
+namespace
+{
+
+constexpr size_t cMaxFinishedJobs = 64;
+
+// wakes up the main thread to redraw the progress, but not too frequently not to overload the renderer
+void postEvent( std::atomic<long long>& lastPostEventMs )
+{
+    const long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+    auto last = lastPostEventMs.load();
+    if ( now - last < 100 || !lastPostEventMs.compare_exchange_strong( last, now ) )
+        return;
+    glfwPostEmptyEvent();
+}
+
+// the function shows the error in main thread like ProgressBar does
+std::function<void()> makeErrorReport( std::string msg, std::string userMsg )
+{
+    return [msg = std::move( msg ), userMsg = std::move( userMsg )] ()
+    {
+        spdlog::error( msg );
+        if ( auto menu = getViewerInstance().getMenuPlugin() )
+            menu->showErrorModal( userMsg );
+    };
+}
+
+} // anonymous namespace
+
+BackgroundJobs::JobId BackgroundJobs::order( JobParams params, Task task )
+{
+    auto& inst = instance_();
+    auto job = std::make_shared<Job>();
+    job->params = std::move( params );
+    job->task = std::move( task );
+
+    std::unique_lock lock( inst.mutex_ );
+    if ( inst.stopping_ )
+        return 0;
+    job->id = ++inst.lastId_;
+    // keep pending jobs sorted by decreasing priority, the jobs of the same priority by increasing id
+    auto it = std::find_if( inst.pending_.begin(), inst.pending_.end(), [p = job->params.priority] ( const auto& j )
+    {
+        return j->params.priority < p;
+    } );
+    inst.pending_.insert( it, job );
+    inst.startWorkers_();
+    getViewerInstance().incrementForceRedrawFrames();
+    return job->id;
+}
+
+bool BackgroundJobs::cancel( JobId id )
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    auto hasId = [id] ( const auto& j ) { return j->id == id; };
+    if ( auto it = std::find_if( inst.pending_.begin(), inst.pending_.end(), hasId ); it != inst.pending_.end() )
+    {
+        inst.pending_.erase( it );
+        return true;
+    }
+    if ( auto it = std::find_if( inst.running_.begin(), inst.running_.end(), hasId ); it != inst.running_.end() )
+    {
+        ( *it )->canceled = true;
+        return true;
+    }
+    return false;
+}
+
+void BackgroundJobs::cancelAll()
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    inst.pending_.clear();
+    for ( auto& j : inst.running_ )
+        j->canceled = true;
+}
+
+std::vector<BackgroundJobs::JobInfo> BackgroundJobs::getJobs()
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    std::vector<JobInfo> res;
+    res.reserve( inst.running_.size() + inst.pending_.size() + inst.finished_.size() );
+    for ( const auto* list : { &inst.running_, &inst.pending_, &inst.finished_ } )
+        for ( const auto& j : *list )
+            res.push_back( { j->id, j->params.name, j->params.priority, j->state, j->progress, j->canceled } );
+    return res;
+}
+
+void BackgroundJobs::clearFinished()
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    inst.finished_.clear();
+}
+
+size_t BackgroundJobs::numJobs()
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    return inst.running_.size() + inst.pending_.size();
+}
+
+void BackgroundJobs::setMaxConcurrentJobs( int n )
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    inst.maxConcurrentJobs_ = std::max( 1, n );
+    inst.startWorkers_();
+}
+
+int BackgroundJobs::getMaxConcurrentJobs()
+{
+    auto& inst = instance_();
+    std::unique_lock lock( inst.mutex_ );
+    return inst.maxConcurrentJobs_;
+}
+
+void BackgroundJobs::shutdown()
+{
+    instance_().stop_();
+}
+
+void BackgroundJobs::draw( float scaling )
+{
+    auto jobs = getJobs();
+    std::erase_if( jobs, [] ( const JobInfo& j ) { return j.state == State::Finished; } );
+    if ( jobs.empty() )
+        return;
+
+    const auto& displaySize = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos( ImVec2( displaySize.x - 10.0f * scaling, displaySize.y - 10.0f * scaling ), ImGuiCond_Always, ImVec2( 1.0f, 1.0f ) );
+    if ( !ImGui::Begin( "Background Jobs###BackgroundJobs", nullptr,
+        ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing ) )
+    {
+        ImGui::End();
+        return;
+    }
+
+    constexpr size_t bufSize = 256;
+    char buf[bufSize];
+    for ( const auto& job : jobs )
+    {
+        ImGui::PushID( int( job.id ) );
+        ImGui::Text( "%s", job.name.c_str() );
+        if ( job.state == State::Pending )
+            snprintf( buf, bufSize, "waiting" );
+        else if ( job.canceled )
+            snprintf( buf, bufSize, "canceling..." );
+        else
+            snprintf( buf, bufSize, "%d%%", int( job.progress * 100 ) );
+        ImGui::ProgressBar( job.state == State::Pending ? 0.0f : job.progress, ImVec2( 200.0f * scaling, 0.0f ), buf );
+        if ( !job.canceled )
+        {
+            ImGui::SameLine();
+            if ( ImGui::Button( "Cancel", ImVec2( 75.0f * scaling, 0.0f ) ) )
+                cancel( job.id );
+        }
+        ImGui::PopID();
+    }
+    ImGui::End();
+
+    // redraw until all jobs are finished to show their progress
+    getViewerInstance().incrementForceRedrawFrames();
+}
+
+BackgroundJobs& BackgroundJobs::instance_()
+{
+    static BackgroundJobs instance;
+    return instance;
+}
+
+BackgroundJobs::~BackgroundJobs()
+{
+    stop_();
+}
+
+void BackgroundJobs::stop_()
+{
+    std::unique_lock lock( mutex_ );
+    stopping_ = true;
+    pending_.clear();
+    for ( auto& j : running_ )
+        j->canceled = true;
+#if !defined( __EMSCRIPTEN__ ) || defined( __EMSCRIPTEN_PTHREADS__ )
+    // detached worker threads refer to this object
+    workersFinished_.wait( lock, [this] { return numWorkers_ == 0; } );
+#endif
+}
+
+void BackgroundJobs::startWorkers_()
+{
+    if ( stopping_ )
+        return;
+    while ( numWorkers_ < maxConcurrentJobs_ && numWorkers_ < int( pending_.size() ) )
+    {
+        ++numWorkers_;
+#if !defined( __EMSCRIPTEN__ ) || defined( __EMSCRIPTEN_PTHREADS__ )
+        std::thread( [this] ()
+        {
+            SetCurrentThreadName( "BackgroundJob" );
+            workerLoop_();
+        } ).detach();
+#else
+        // no threads: the job is executed in the next frame of main thread
+        CommandLoop::appendCommand( [this] () { workerLoop_(); } );
+#endif
+    }
+}
+
+void BackgroundJobs::workerLoop_()
+{
+    std::unique_lock lock( mutex_ );
+    while ( !pending_.empty() && numWorkers_ <= maxConcurrentJobs_ )
+    {
+        auto job = pending_.front();
+        pending_.erase( pending_.begin() );
+        job->state = State::Running;
+        running_.push_back( job );
+
+        lock.unlock();
+        runJob_( *job );
+        job->task = {}; // release the data captured by the task
+        lock.lock();
+
+        job->state = State::Finished;
+        running_.erase( std::find( running_.begin(), running_.end(), job ) );
+        finished_.push_back( std::move( job ) );
+        if ( finished_.size() > cMaxFinishedJobs )
+            finished_.erase( finished_.begin() );
+    }
+    --numWorkers_;
+    workersFinished_.notify_all();
+}
+
+void BackgroundJobs::runJob_( Job& job )
+{
+    int maxThreads = job.params.maxThreads;
+    if ( maxThreads <= 0 )
+    {
+        // one hardware thread is left for the user interface
+        const int numHwThreads = std::max( 1, tbb::this_task_arena::max_concurrency() - 1 );
+        maxThreads = std::max( 1, numHwThreads / getMaxConcurrentJobs() );
+    }
+
+    ProgressCallback progressCb = [&job] ( float p )
+    {
+        job.progress = p;
+        postEvent( job.lastPostEventMs );
+        return !job.canceled;
+    };
+
+    std::function<void()> onFinish;
+    try
+    {
+        tbb::task_arena arena( maxThreads );
+        arena.execute( [&] { onFinish = job.task( progressCb ); } );
+    }
+    catch ( const std::bad_alloc& badAllocE )
+    {
+        onFinish = makeErrorReport( badAllocE.what(), "Device ran out of memory during this operation." );
+    }
+    catch ( const std::exception& e )
+    {
+        onFinish = makeErrorReport( e.what(), e.what() );
+    }
+
+    if ( onFinish )
+        CommandLoop::appendCommand( std::move( onFinish ) );
+    glfwPostEmptyEvent();
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "exports.h"
+#include "MRMesh/MRProgressCallback.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace MR
+{
+
+// This class runs several long operations concurrently in background threads without blocking the user interface
+// (unlike ProgressBar, which executes only one task at a time and shows modal dialog);
+// each job gets its own progress callback with cancellation, and its completion step is executed in main thread via CommandLoop
+class BackgroundJobs
+{
+public:
+    using JobId = unsigned;
+
+    // the task receives the progress callback (which returns false if the job was canceled)
+    // and returns a function to be executed in main thread after the task is finished (can be empty)
+    using Task = std::function< std::function<void()>( const ProgressCallback& ) >;
+
+    enum class Priority
+    {
+        Low,
+        Normal,
+        High
+    };
+
+    struct JobParams
+    {
+        std::string name;
+        // pending jobs with higher priority are started first, jobs of equal priority - in the order of their submission
+        Priority priority = Priority::Normal;
+        // maximal number of threads used by parallel algorithms of this job,
+        // 0 - automatic: hardware threads except one are divided equally among concurrent jobs
+        int maxThreads = 0;
+    };
+
+    enum class State
+    {
+        Pending,
+        Running,
+        Finished
+    };
+
+    struct JobInfo
+    {
+        JobId id = 0;
+        std::string name;
+        Priority priority = Priority::Normal;
+        State state = State::Pending;
+        float progress = 0;
+        bool canceled = false;
+    };
+
+    // adds the job in the queue and returns its identifier, the job starts as soon as a worker thread is free;
+    // returns 0 and drops the job if the jobs are already shut down
+    MRVIEWER_API static JobId order( JobParams params, Task task );
+
+    // requests the cancellation of the job: a pending job is removed from the queue immediately,
+    // a running one is stopped when it calls its progress callback next time;
+    // returns false if there is no such job
+    MRVIEWER_API static bool cancel( JobId id );
+    MRVIEWER_API static void cancelAll();
+
+    // returns the information about all pending and running jobs,
+    // and about recently finished jobs (with State::Finished) till clearFinished is called
+    MRVIEWER_API static std::vector<JobInfo> getJobs();
+
+    // forgets the information about finished jobs
+    MRVIEWER_API static void clearFinished();
+
+    // returns the number of pending and running jobs
+    MRVIEWER_API static size_t numJobs();
+
+    // sets the maximal number of jobs running at the same time (2 by default)
+    MRVIEWER_API static void setMaxConcurrentJobs( int n );
+    MRVIEWER_API static int getMaxConcurrentJobs();
+
+    // cancels all jobs and waits until the running ones are stopped, no jobs are started after that;
+    // it is called by Viewer before the window and GLFW are destroyed
+    MRVIEWER_API static void shutdown();
+
+    // draws non-modal window with the progress of all jobs and Cancel buttons,
+    // it should be called once per frame (it is called in MR::Menu (MR::RibbonMenu))
+    MRVIEWER_API static void draw( float scaling );
+
+private:
+    static BackgroundJobs& instance_();
+
+    BackgroundJobs() = default;
+    ~BackgroundJobs();
+
+    struct Job;
+
+    // cancels all jobs and waits for worker threads
+    void stop_();
+    // starts new worker threads if there are pending jobs and free slots, mutex_ must be locked
+    void startWorkers_();
+    // executes pending jobs one by one in current thread until the queue is empty
+    void workerLoop_();
+    void runJob_( Job& job );
+
+    std::mutex mutex_;
+    std::condition_variable workersFinished_;
+    std::vector<std::shared_ptr<Job>> pending_;
+    std::vector<std::shared_ptr<Job>> running_;
+    // only the last finished jobs are kept not to grow indefinitely
+    std::vector<std::shared_ptr<Job>> finished_;
+    JobId lastId_ = 0;
+    int maxConcurrentJobs_ = 2;
+    int numWorkers_ = 0;
+    bool stopping_ = false;
+};
+
+}
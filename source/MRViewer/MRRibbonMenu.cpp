@@ -3,6 +3,7 @@
 #include "MRMesh/MRStringConvert.h"
 #include "MRMesh/MRSerializer.h"
 #include "MRMesh/MRObjectsAccess.h"
+#include "MRBackgroundJobs.h"
 #include "MRProgressBar.h"
 #include "MRColorTheme.h"
 #include "MRAppendHistory.h"
@@ -2020,6 +2021,7 @@ void RibbonMenu::beginTopPanel_()
     ImGui::PopStyleVar();
     // for all items
     ProgressBar::setup( scaling );
+    BackgroundJobs::draw( scaling );
 }
 
 void RibbonMenu::endTopPanel_()
@@ -27,6 +27,7 @@
 #include "MRShadersHolder.h"
 #include "MRViewerPlugin.h"
 #include "MRCommandLoop.h"
+#include "MRBackgroundJobs.h"
 #include "MRSplashWindow.h"
 #include "MRViewerSettingsManager.h"
 #include "MRGladGlfw.h"
@@ -535,6 +536,9 @@ void Viewer::launchShut()
         return;
     }
 
+    // background jobs can use scene objects, GLFW and the viewer, so stop them first
+    BackgroundJobs::shutdown();
+
     if ( settingsMng_ )
         settingsMng_->saveSettings( *this );
 
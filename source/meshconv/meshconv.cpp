@@ -4,23 +4,88 @@
 #include "MRMesh/MRMeshDecimate.h"
 #include "MRMesh/MRMeshBoolean.h"
 #include "MRMesh/MRConvexHull.h"
+#include "MRMesh/MRStringConvert.h"
+#include "MRPch/MRJson.h"
+#include "MRPch/MRTBB.h"
 #include <boost/program_options.hpp>
 #include <boost/exception/diagnostic_information.hpp>
+#include <tl/expected.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <thread>
 
-bool doCommand( const boost::program_options::option& option, MR::Mesh& mesh )
+// one command of the pipeline with parsed arguments, it can be applied to many meshes
+struct Command
 {
-    namespace po = boost::program_options;
-    if ( option.string_key == "convex-hull" )
+    std::string name;
+    // target edge length of remesh, if not positive then average edge length of the mesh is taken
+    float targetEdgeLen = 0;
+    // second operand of boolean commands, it is loaded only once for all input meshes
+    std::shared_ptr<const MR::Mesh> operand;
+    MR::BooleanOperation booleanOp = MR::BooleanOperation::Union;
+};
+
+// parses the commands and loads the meshes they refer to, the messages about success are written in (log) if it is not null
+tl::expected<std::vector<Command>, std::string> parseCommands( const boost::program_options::parsed_options& parsed, std::ostream* log )
+{
+    std::vector<Command> res;
+    for ( const auto& option : parsed.options )
+    {
+        Command cmd;
+        cmd.name = option.string_key;
+        if ( option.string_key == "remesh" )
+        {
+            if ( !option.value.empty() )
+                cmd.targetEdgeLen = std::stof( option.value[0] );
+        }
+        else if ( option.string_key == "unite" || option.string_key == "subtract" || option.string_key == "intersect" )
+        {
+            if ( option.value.empty() )
+                return tl::make_unexpected( "Mesh file is not specified for command \"" + option.string_key + "\"" );
+            std::filesystem::path meshPath = option.value[0];
+
+            auto loadRes = MR::MeshLoad::fromAnySupportedFormat( meshPath );
+            if ( !loadRes.has_value() )
+                return tl::make_unexpected( "Mesh load error: " + loadRes.error() );
+            if ( log )
+                *log << meshPath << " loaded successfully\n";
+            auto operand = std::make_shared<MR::Mesh>( std::move( loadRes.value() ) );
+            // build the tree here and not concurrently when the operand is used for many input meshes
+            operand->getAABBTree();
+            cmd.operand = std::move( operand );
+
+            if ( option.string_key == "subtract" )
+                cmd.booleanOp = MR::BooleanOperation::OutsideA;
+            if ( option.string_key == "intersect" )
+                cmd.booleanOp = MR::BooleanOperation::Intersection;
+        }
+        else if ( option.string_key != "convex-hull" )
+            continue;
+        res.push_back( std::move( cmd ) );
+    }
+    return res;
+}
+
+// applies the command to the mesh, the messages about success are written in (log) if it is not null
+tl::expected<void, std::string> doCommand( const Command& command, MR::Mesh& mesh, std::ostream* log )
+{
+    if ( command.name == "convex-hull" )
     {
         mesh = MR::makeConvexHull( mesh );
-        std::cout << "convex hull computed successfully" << std::endl;
+        if ( log )
+            *log << "convex hull computed successfully" << std::endl;
     }
-    else if ( option.string_key == "remesh" )
+    else if ( command.name == "remesh" )
     {
-        float targetEdgeLen{ 0.f };
-        if ( !option.value.empty() )
-            targetEdgeLen = std::stof( option.value[0] );
+        float targetEdgeLen = command.targetEdgeLen;
         if ( targetEdgeLen <= 0 )
             targetEdgeLen = mesh.averageEdgeLength();
 
@@ -28,40 +93,317 @@ bool doCommand( const boost::program_options::option& option, MR::Mesh& mesh )
         rems.targetEdgeLen = targetEdgeLen;
         MR::remesh( mesh, rems );
 
-        std::cout << "re-meshed successfully to target edge length " << targetEdgeLen << "\n";
+        if ( log )
+            *log << "re-meshed successfully to target edge length " << targetEdgeLen << "\n";
+    }
+    else if ( command.operand )
+    {
+        auto booleanRes = MR::boolean( mesh, *command.operand, command.booleanOp );
+        if ( !booleanRes )
+            return tl::make_unexpected( booleanRes.errorString );
+        if ( log )
+            *log << command.name << " success!\n";
+        mesh = std::move( booleanRes.mesh );
     }
-    else if ( option.string_key == "unite" || option.string_key == "subtract" || option.string_key == "intersect" )
+    return {};
+}
+
+// input and output files of one mesh in batch mode
+struct BatchItem
+{
+    std::filesystem::path input;
+    std::filesystem::path output;
+    // if not empty then the item is not processed and reported with this error
+    std::string error;
+};
+
+// finds the files matching the pattern with wildcards * and ? in file name (not in directories)
+static tl::expected<std::vector<BatchItem>, std::string> globInputs( const std::string& pattern )
+{
+    const auto patternPath = MR::pathFromUtf8( pattern.c_str() );
+    auto dir = patternPath.parent_path();
+    if ( dir.empty() )
+        dir = ".";
+    std::string re;
+    for ( char c : MR::utf8string( patternPath.filename() ) )
     {
-        std::filesystem::path meshPath = option.value[0];
+        if ( c == '*' )
+            re += ".*";
+        else if ( c == '?' )
+            re += '.';
+        else if ( std::strchr( "\\^$.|+()[]{}", c ) )
+            ( re += '\\' ) += c;
+        else
+            re += c;
+    }
+    const std::regex fileNameRegex( re );
+
+    std::vector<BatchItem> res;
+    std::error_code ec;
+    for ( const auto& entry : std::filesystem::directory_iterator( dir, ec ) )
+        if ( entry.is_regular_file( ec ) && std::regex_match( MR::utf8string( entry.path().filename() ), fileNameRegex ) )
+            res.push_back( { entry.path(), {} } );
+    if ( ec )
+        return tl::make_unexpected( "Cannot read directory " + MR::utf8string( dir ) + ": " + ec.message() );
+    std::sort( res.begin(), res.end(), [] ( const BatchItem& a, const BatchItem& b ) { return a.input < b.input; } );
+    return res;
+}
 
-        auto loadRes = MR::MeshLoad::fromAnySupportedFormat( meshPath );
-        if ( !loadRes.has_value() )
+// reads manifest file: one input file per line optionally followed by tab and output file, empty lines and lines starting with # are skipped
+static tl::expected<std::vector<BatchItem>, std::string> readManifest( const std::filesystem::path& manifest )
+{
+    std::ifstream in( manifest );
+    if ( !in )
+        return tl::make_unexpected( "Cannot open manifest " + MR::utf8string( manifest ) );
+    std::vector<BatchItem> res;
+    std::string line;
+    while ( std::getline( in, line ) )
+    {
+        if ( !line.empty() && line.back() == '\r' )
+            line.pop_back();
+        if ( line.empty() || line[0] == '#' )
+            continue;
+        BatchItem item;
+        if ( auto tab = line.find( '\t' ); tab != std::string::npos )
         {
-            std::cerr << "Mesh load error: " << loadRes.error() << "\n";
-            return false;
+            item.input = MR::pathFromUtf8( line.substr( 0, tab ).c_str() );
+            item.output = MR::pathFromUtf8( line.substr( tab + 1 ).c_str() );
         }
-        auto meshB = std::move( loadRes.value() );
-        std::cout << meshPath << " loaded successfully\n";
+        else
+            item.input = MR::pathFromUtf8( line.c_str() );
+        res.push_back( std::move( item ) );
+    }
+    return res;
+}
+
+// marks the items, which output file is an input file of the batch or the output file of another item
+static void markOutputConflicts( std::vector<BatchItem>& items )
+{
+    // the same file can be given by different paths
+    auto fileKey = [] ( const std::filesystem::path& path )
+    {
+        std::error_code ec;
+        auto res = std::filesystem::weakly_canonical( path, ec );
+        return ec ? std::filesystem::absolute( path, ec ).lexically_normal() : res;
+    };
+    std::set<std::filesystem::path> inputs;
+    std::map<std::filesystem::path, std::vector<size_t>> outputs;
+    for ( size_t i = 0; i < items.size(); ++i )
+    {
+        inputs.insert( fileKey( items[i].input ) );
+        outputs[fileKey( items[i].output )].push_back( i );
+    }
+    for ( const auto& [output, itemIds] : outputs )
+    {
+        std::string error;
+        if ( inputs.count( output ) )
+            error = "Output file " + MR::utf8string( output ) + " would overwrite input file";
+        else if ( itemIds.size() > 1 )
+            error = "Output file " + MR::utf8string( output ) + " is the same for " + std::to_string( itemIds.size() ) + " input files";
+        if ( error.empty() )
+            continue;
+        for ( auto i : itemIds )
+            items[i].error = error;
+    }
+}
 
-        MR::BooleanOperation bo{ MR::BooleanOperation::Union };
-        if ( option.string_key == "subtract" )
-            bo = MR::BooleanOperation::OutsideA;
-        if ( option.string_key == "intersect" )
-            bo = MR::BooleanOperation::Intersection;
-        auto booleanRes = MR::boolean( mesh, meshB, bo );
+// loads the mesh, applies all commands to it and saves the result;
+// returns the report with the timings of all stages in seconds
+static Json::Value processFile( const BatchItem& item, const std::vector<Command>& commands )
+{
+    using Clock = std::chrono::steady_clock;
+    Json::Value report;
+    report["input"] = MR::utf8string( item.input );
+    report["output"] = MR::utf8string( item.output );
+    report["stages"] = Json::arrayValue;
+    const auto startTime = Clock::now();
+    auto stageStart = startTime;
+    auto endStage = [&] ( const std::string& name )
+    {
+        const auto now = Clock::now();
+        Json::Value stage;
+        stage["name"] = name;
+        stage["seconds"] = std::chrono::duration<double>( now - stageStart ).count();
+        report["stages"].append( std::move( stage ) );
+        stageStart = now;
+    };
 
-        if ( !booleanRes )
+    // the items with conflicting output files are reported without processing
+    std::string error = item.error;
+    if ( error.empty() )
+    {
+        try
         {
-            std::cerr << booleanRes.errorString << "\n";
-            return false;
+            auto loadRes = MR::MeshLoad::fromAnySupportedFormat( item.input );
+            endStage( "load" );
+            if ( !loadRes.has_value() )
+                error = "Mesh load error: " + loadRes.error();
+            else
+            {
+                auto mesh = std::move( loadRes.value() );
+                report["inputVertices"] = Json::UInt64( mesh.topology.numValidVerts() );
+                report["inputFaces"] = Json::UInt64( mesh.topology.numValidFaces() );
+                for ( const auto& command : commands )
+                {
+                    auto res = doCommand( command, mesh, nullptr );
+                    endStage( command.name );
+                    if ( !res.has_value() )
+                    {
+                        error = "Error in command \"" + command.name + "\": " + res.error();
+                        break;
+                    }
+                }
+                if ( error.empty() )
+                {
+                    auto saveRes = MR::MeshSave::toAnySupportedFormat( mesh, item.output );
+                    endStage( "save" );
+                    if ( !saveRes.has_value() )
+                        error = "Mesh save error: " + saveRes.error();
+                }
+            }
         }
-        else
+        catch ( const std::exception& e )
         {
-            std::cout << option.string_key << " success!\n";
-            mesh = std::move( booleanRes.mesh );
+            error = std::string( "Exception: " ) + e.what();
         }
     }
-    return true;
+
+    report["status"] = error.empty() ? "ok" : "error";
+    if ( !error.empty() )
+        report["error"] = error;
+    report["seconds"] = std::chrono::duration<double>( Clock::now() - startTime ).count();
+    return report;
+}
+
+struct BatchSettings
+{
+    std::string inputs; // manifest file or pattern with wildcards
+    std::filesystem::path outputDir;
+    std::string outputExt;
+    int jobs = 1;
+    int threads = 0;
+    std::filesystem::path reportPath;
+};
+
+// processes many files by the same commands concurrently;
+// each finished file is reported immediately as one line of JSON in the report
+static int batchMain( const BatchSettings& settings, const std::vector<Command>& commands )
+{
+    const bool isPattern = settings.inputs.find_first_of( "*?" ) != std::string::npos;
+    auto itemsRes = isPattern ? globInputs( settings.inputs ) : readManifest( MR::pathFromUtf8( settings.inputs.c_str() ) );
+    if ( !itemsRes.has_value() )
+    {
+        std::cerr << itemsRes.error() << "\n";
+        return 1;
+    }
+    auto items = std::move( itemsRes.value() );
+
+    for ( auto& item : items )
+    {
+        if ( item.output.empty() )
+        {
+            if ( settings.outputDir.empty() )
+            {
+                std::cerr << "Output file is not specified for " << item.input << ", use --output-dir\n";
+                return 1;
+            }
+            item.output = settings.outputDir / item.input.filename();
+            if ( !settings.outputExt.empty() )
+                item.output.replace_extension( MR::pathFromUtf8( settings.outputExt.c_str() ) );
+        }
+        else if ( item.output.is_relative() && !settings.outputDir.empty() )
+            item.output = settings.outputDir / item.output;
+    }
+    markOutputConflicts( items );
+    if ( !settings.outputDir.empty() )
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( settings.outputDir, ec );
+    }
+
+    const int hwThreads = std::max( 1, int( std::thread::hardware_concurrency() ) );
+    const int jobs = std::clamp( settings.jobs > 0 ? settings.jobs : hwThreads, 1, std::max( 1, int( items.size() ) ) );
+    const int threads = settings.threads > 0 ? settings.threads : std::max( 1, hwThreads / jobs );
+
+    std::ofstream reportFile;
+    std::ostream* report = nullptr;
+    if ( settings.reportPath == "-" )
+        report = &std::cout;
+    else if ( !settings.reportPath.empty() )
+    {
+        reportFile.open( settings.reportPath );
+        if ( !reportFile )
+        {
+            std::cerr << "Cannot write report in " << settings.reportPath << "\n";
+            return 1;
+        }
+        report = &reportFile;
+    }
+    // human readable messages are not mixed with the report in standard output
+    std::ostream* log = report == &std::cout ? nullptr : &std::cout;
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    builder["precision"] = 6;
+    std::unique_ptr<Json::StreamWriter> writer{ builder.newStreamWriter() };
+
+    std::mutex reportMutex;
+    std::atomic<size_t> nextItem{ 0 };
+    size_t numFailed = 0;
+    auto worker = [&] ()
+    {
+        // limits the number of threads used by the algorithms processing one file
+        tbb::task_arena arena( threads );
+        for ( size_t i = nextItem++; i < items.size(); i = nextItem++ )
+        {
+            Json::Value fileReport;
+            arena.execute( [&] { fileReport = processFile( items[i], commands ); } );
+
+            std::unique_lock lock( reportMutex );
+            const bool ok = fileReport["status"].asString() == "ok";
+            if ( !ok )
+                ++numFailed;
+            if ( report )
+            {
+                writer->write( fileReport, report );
+                *report << std::endl;
+            }
+            if ( log )
+            {
+                *log << items[i].input << " -> " << items[i].output << ": ";
+                if ( ok )
+                    *log << "done in " << fileReport["seconds"].asDouble() << " s\n";
+                else
+                    *log << fileReport["error"].asString() << "\n";
+            }
+        }
+    };
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for ( int i = 1; i < jobs; ++i )
+        workers.emplace_back( worker );
+    worker();
+    for ( auto& w : workers )
+        w.join();
+
+    Json::Value summary;
+    summary["files"] = Json::UInt64( items.size() );
+    summary["failed"] = Json::UInt64( numFailed );
+    summary["jobs"] = jobs;
+    summary["threadsPerJob"] = threads;
+    summary["seconds"] = std::chrono::duration<double>( std::chrono::steady_clock::now() - startTime ).count();
+    if ( report )
+    {
+        Json::Value root;
+        root["summary"] = std::move( summary );
+        writer->write( root, report );
+        *report << std::endl;
+    }
+    if ( log )
+        *log << items.size() - numFailed << " of " << items.size() << " files processed successfully\n";
+
+    return numFailed == 0 ? 0 : 1;
 }
 
 // can throw
@@ -69,6 +411,7 @@ static int mainInternal( int argc, char **argv )
 {
     std::filesystem::path inFilePath;
     std::filesystem::path outFilePath;
+    BatchSettings batch;
 
     namespace po = boost::program_options;
     po::options_description generalOptions( "General options" );
@@ -78,6 +421,17 @@ static int mainInternal( int argc, char **argv )
         ("output-file", po::value<std::filesystem::path>( &outFilePath ), "filename of output mesh")
         ;
 
+    po::options_description batchOptions( "Batch mode" );
+    batchOptions.add_options()
+        ("batch", po::value<std::string>( &batch.inputs ), "process many meshes by the same commands: manifest file with one input file per line "
+            "(optionally followed by tab and output file), or pattern with wildcards in file name like dir/*.stl")
+        ("output-dir", po::value<std::filesystem::path>( &batch.outputDir ), "directory for output files, by default they have the names of input files")
+        ("output-ext", po::value<std::string>( &batch.outputExt ), "extension of output files (format), by default the same as of input files")
+        ("jobs", po::value<int>( &batch.jobs )->default_value( 1 ), "number of files processed concurrently, 0 - number of hardware threads")
+        ("threads", po::value<int>( &batch.threads )->default_value( 0 ), "maximal number of threads of algorithms processing one file, 0 - hardware threads divided by jobs")
+        ("report", po::value<std::filesystem::path>( &batch.reportPath ), "file to write the results and per-stage timings of each file as JSON lines, - for standard output")
+        ;
+
     po::options_description commands( "Commands" );
     commands.add_options()
         ( "remesh", po::value<float>()->implicit_value( 0 ), "optional argument if positive is target edge length after remeshing" )
@@ -88,14 +442,17 @@ static int mainInternal( int argc, char **argv )
         ;
 
     po::options_description allCommands( "Available options" );
-    allCommands.add( generalOptions ).add( commands );
+    allCommands.add( generalOptions ).add( batchOptions ).add( commands );
+
+    po::options_description nonCommands;
+    nonCommands.add( generalOptions ).add( batchOptions );
 
     po::positional_options_description p;
     p.add("input-file", 1);
     p.add("output-file", 1);
 
     po::parsed_options parsedGeneral = po::command_line_parser( argc, argv )
-        .options( generalOptions )
+        .options( nonCommands )
         .positional( p )
         .allow_unregistered()
         .run();
@@ -106,7 +463,7 @@ static int mainInternal( int argc, char **argv )
         if ( o.unregistered )
             unregisteredOptions.insert( unregisteredOptions.end(), o.original_tokens.begin(), o.original_tokens.end() );
     }
-    
+
     po::variables_map vm;
     po::store(parsedGeneral, vm);
     po::notify(vm);
@@ -116,15 +473,28 @@ static int mainInternal( int argc, char **argv )
         .allow_unregistered()
         .run();
 
-    if ( vm.count("help") || !vm.count("input-file") || !vm.count("output-file") )
+    const bool batchMode = vm.count( "batch" ) > 0;
+    if ( vm.count("help") || ( !batchMode && ( !vm.count("input-file") || !vm.count("output-file") ) ) )
     {
-        std::cerr << 
+        std::cerr <<
             "meshconv is mesh file conversion utility based on MeshInspector/MeshLib\n"
             "Usage: meshconv input-file output-file [options]\n"
+            "       meshconv --batch manifest.txt|pattern --output-dir dir [--jobs N] [--threads M] [--report report.jsonl] [options]\n"
             << allCommands << "\n";
         return 1;
     }
 
+    auto parsedRes = parseCommands( parsedCommands, batchMode && batch.reportPath == "-" ? nullptr : &std::cout );
+    if ( !parsedRes.has_value() )
+    {
+        std::cerr << parsedRes.error() << "\n";
+        return 1;
+    }
+    const auto& commandList = parsedRes.value();
+
+    if ( batchMode )
+        return batchMain( batch, commandList );
+
     auto loadRes = MR::MeshLoad::fromAnySupportedFormat( inFilePath );
     if ( !loadRes.has_value() )
     {
@@ -134,12 +504,13 @@ static int mainInternal( int argc, char **argv )
     auto mesh = std::move( loadRes.value() );
     std::cout << inFilePath << " loaded successfully\n";
 
-    std::vector<std::vector<std::string>> lists;
-    for ( const po::option& o : parsedCommands.options )
+    for ( const auto& command : commandList )
     {
-        if ( !doCommand( o, mesh ) )
+        auto res = doCommand( command, mesh, &std::cout );
+        if ( !res.has_value() )
         {
-            std::cerr << "Error in command : \""<< o.string_key << " " << o.value[0] << "\"\nBreak\n";
+            std::cerr << res.error() << "\n";
+            std::cerr << "Error in command : \""<< command.name << "\"\nBreak\n";
             return 1;
         }
     }
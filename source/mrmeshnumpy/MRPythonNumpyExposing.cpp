@@ -6,6 +6,7 @@
 #include "MRMesh/MRPointCloud.h"
 #include "MRMesh/MRBitSetParallelFor.h"
 #include "MRMesh/MRVertexAttributeGradient.h"
+#include <bit>
 
 MR_INIT_PYTHON_MODULE_PRECALL( mrmeshnumpy, [] ()
 {
@@ -213,11 +214,11 @@ pybind11::array_t<bool> getNumpyBitSet( const boost::dynamic_bitset<std::uint64_
     using namespace MR;
     // Allocate and initialize some data;
     const size_t size = bitSet.size();
-    bool* data = new bool[size];
-    for ( int i = 0; i < size; i++ )
-    {
-        data[i] = bitSet.test( i );
-    }
+    bool* data = new bool[size]();
+    // only set bits are written, zero blocks are skipped
+    for ( size_t b = 0; b < bitSet.num_blocks(); ++b )
+        for ( auto block = bitSet.m_bits[b]; block; block &= block - 1 )
+            data[b * BitSet::bits_per_block + std::countr_zero( block )] = true;
 
     // Create a Python object that will free the allocated
     // memory when destroyed:
@@ -0,0 +1,120 @@
+#include "MRPythonAsync.h"
+#include "MRMesh/MRSystem.h"
+#include <cmath>
+
+namespace MR
+{
+
+std::shared_ptr<PythonAsyncJob> PythonAsyncJob::start( Task task, pybind11::object pyProgressCb )
+{
+    auto job = std::make_shared<PythonAsyncJob>();
+    job->future_ = pybind11::module_::import( "concurrent.futures" ).attr( "Future" )();
+    job->hasPyProgressCb_ = !pyProgressCb.is_none();
+    job->pyProgressCb_ = std::move( pyProgressCb );
+
+    // the future is never marked as running, so it can be canceled until the result is set
+    std::weak_ptr<PythonAsyncJob> weakJob = job;
+    job->future_.attr( "add_done_callback" )( pybind11::cpp_function( [weakJob] ( pybind11::object future )
+    {
+        if ( auto j = weakJob.lock() )
+            if ( future.attr( "cancelled" )().cast<bool>() )
+                j->stop_ = true;
+    } ) );
+
+    std::thread( [job, task = std::move( task )] () mutable
+    {
+        SetCurrentThreadName( "PythonAsyncJob" );
+        job->run_( task );
+        // python objects of the job must be released with GIL acquired
+        pybind11::gil_scoped_acquire acquire;
+        job.reset();
+    } ).detach();
+    return job;
+}
+
+void PythonAsyncJob::run_( const Task& task )
+{
+    threadId_ = std::this_thread::get_id();
+    std::function<pybind11::object()> makeResult;
+    std::string error;
+    try
+    {
+        makeResult = task( [this] ( float p ) { return onProgress_( p ); } );
+    }
+    catch ( const std::exception& e )
+    {
+        error = e.what();
+    }
+
+    pybind11::gil_scoped_acquire acquire;
+    if ( future_.attr( "cancelled" )().cast<bool>() )
+        return;
+    if ( !pyError_.empty() )
+        error = pyError_;
+    else if ( stop_ )
+    {
+        // the job was canceled by python progress callback
+        future_.attr( "cancel" )();
+        return;
+    }
+    if ( error.empty() )
+    {
+        try
+        {
+            future_.attr( "set_result" )( makeResult ? makeResult() : pybind11::object( pybind11::none() ) );
+            return;
+        }
+        catch ( const std::exception& e )
+        {
+            error = e.what();
+        }
+    }
+    future_.attr( "set_exception" )( pybind11::module_::import( "builtins" ).attr( "RuntimeError" )( error ) );
+}
+
+bool PythonAsyncJob::onProgress_( float p )
+{
+    progress_ = p;
+    // python callback is invoked only from the job's thread (and not from the threads of parallel algorithms),
+    // and only on noticeable change of the progress not to wait for GIL too often
+    if ( stop_ || !hasPyProgressCb_ || std::this_thread::get_id() != threadId_ )
+        return !stop_;
+    const float last = lastReported_;
+    if ( std::abs( p - last ) < 0.01f && p < 1.0f )
+        return true;
+    lastReported_ = p;
+
+    pybind11::gil_scoped_acquire acquire;
+    try
+    {
+        auto res = pyProgressCb_( p );
+        if ( !res.is_none() && !res.cast<bool>() )
+            stop_ = true;
+    }
+    catch ( const std::exception& e )
+    {
+        pyError_ = e.what();
+        stop_ = true;
+    }
+    return !stop_;
+}
+
+}
+
+MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, AsyncJob, [] ( pybind11::module_& m )
+{
+    pybind11::class_<MR::PythonAsyncJob, std::shared_ptr<MR::PythonAsyncJob>>( m, "AsyncJob",
+        "long operation executed in background thread; it can be awaited in asyncio or waited by result()" ).
+        def_property_readonly( "future", &MR::PythonAsyncJob::future, "concurrent.futures.Future of the operation" ).
+        def_property_readonly( "progress", &MR::PythonAsyncJob::progress, "last reported progress in [0,1]" ).
+        def( "done", [] ( const MR::PythonAsyncJob& job ) { return job.future().attr( "done" )(); } ).
+        def( "cancelled", [] ( const MR::PythonAsyncJob& job ) { return job.future().attr( "cancelled" )(); } ).
+        def( "cancel", [] ( const MR::PythonAsyncJob& job ) { return job.future().attr( "cancel" )(); },
+            "requests the operation to stop on its next progress report, returns False if it is already finished" ).
+        def( "result", [] ( const MR::PythonAsyncJob& job, pybind11::object timeout ) { return job.future().attr( "result" )( timeout ); },
+            pybind11::arg( "timeout" ) = pybind11::none(), "waits for the operation and returns its result or raises its exception" ).
+        def( "__await__", [] ( const MR::PythonAsyncJob& job )
+        {
+            return pybind11::module_::import( "asyncio" ).attr( "wrap_future" )( job.future() ).attr( "__await__" )();
+        } );
+} )
@@ -0,0 +1,60 @@
+#pragma once
+#include "MRMesh/MRPython.h"
+#include "MRMesh/MRProgressCallback.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace MR
+{
+
+// The long operation executed in a separate thread without GIL, exposed in python as AsyncJob:
+// it can be awaited in asyncio, and it provides concurrent.futures.Future for thread-based code;
+// cancellation of the future (e.g. by asyncio on task cancellation) stops the operation on its next progress report
+class PythonAsyncJob
+{
+public:
+    // the task is executed with GIL released, it receives the progress callback returning false if the job was canceled,
+    // and returns the function converting its result in python object, which is called with GIL acquired
+    using Task = std::function<std::function<pybind11::object()>( const ProgressCallback& )>;
+
+    // starts the task in a new thread and returns immediately, must be called with GIL acquired;
+    // pyProgressCb (if not None) is called with the progress in [0,1] from the job's thread with GIL acquired,
+    // and it can return False to cancel the job
+    static std::shared_ptr<PythonAsyncJob> start( Task task, pybind11::object pyProgressCb );
+
+    // concurrent.futures.Future receiving the result of the task or its exception
+    const pybind11::object& future() const { return future_; }
+
+    // last reported progress of the task
+    float progress() const { return progress_; }
+
+private:
+    void run_( const Task& task );
+    bool onProgress_( float p );
+
+    pybind11::object future_;
+    pybind11::object pyProgressCb_;
+    bool hasPyProgressCb_ = false;
+    std::thread::id threadId_;
+    std::atomic<bool> stop_{ false };
+    std::atomic<float> progress_{ 0.0f };
+    std::atomic<float> lastReported_{ -1.0f };
+    // the message of the exception thrown by pyProgressCb, accessed only with GIL acquired
+    std::string pyError_;
+};
+
+// starts func( progressCallback ) asynchronously, the result of func is converted in python object after it is finished;
+// func must own all its data since python objects can be modified or destroyed while it runs
+template<typename F>
+std::shared_ptr<PythonAsyncJob> runPythonAsync( F&& func, pybind11::object pyProgressCb )
+{
+    return PythonAsyncJob::start( [func = std::forward<F>( func )] ( const ProgressCallback& cb ) mutable -> std::function<pybind11::object()>
+    {
+        auto res = std::make_shared<decltype( func( cb ) )>( func( cb ) );
+        return [res] () { return pybind11::cast( std::move( *res ) ); };
+    }, std::move( pyProgressCb ) );
+}
+
+}
@@ -1,6 +1,8 @@
 #include "MRMesh/MRPython.h"
+#include "MRPythonAsync.h"
 #include "MRMesh/MRAffineXf3.h"
 #include "MRMesh/MRMeshBoolean.h"
+#include <optional>
 
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, BooleanExposing, [] ( pybind11::module_& m )
 {
@@ -33,5 +35,18 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, BooleanExposing, [] ( pybind11::module_& m )
         def( "map", ( MR::EdgeBitSet( MR::BooleanResultMapper::* )( const MR::EdgeBitSet&, MR::BooleanResultMapper::MapObject )const )& MR::BooleanResultMapper::map ).
         def( "map", ( MR::FaceBitSet( MR::BooleanResultMapper::* )( const MR::FaceBitSet&, MR::BooleanResultMapper::MapObject )const )& MR::BooleanResultMapper::map );
 
-    m.def( "boolean", MR::boolean, "performs boolean operation on meshes" );
+    m.def( "boolean", MR::boolean, "performs boolean operation on meshes", pybind11::call_guard<pybind11::gil_scoped_release>() );
+
+    m.def( "boolean_async", [] ( const MR::Mesh& meshA, const MR::Mesh& meshB, MR::BooleanOperation operation, const MR::AffineXf3f* rigidB2A )
+    {
+        std::optional<MR::AffineXf3f> xf;
+        if ( rigidB2A )
+            xf = *rigidB2A;
+        // boolean does not report progress, so cancellation only discards its result
+        return MR::runPythonAsync( [meshA, meshB, operation, xf] ( const MR::ProgressCallback& )
+        {
+            return MR::boolean( meshA, meshB, operation, xf ? &*xf : nullptr );
+        }, pybind11::none() );
+    }, pybind11::arg( "meshA" ), pybind11::arg( "meshB" ), pybind11::arg( "operation" ), pybind11::arg( "rigidB2A" ) = nullptr,
+        "performs boolean operation on the copies of meshes in background thread, returns AsyncJob with BooleanResult" );
 } )
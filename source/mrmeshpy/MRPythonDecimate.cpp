@@ -1,4 +1,5 @@
 #include "MRMesh/MRPython.h"
+#include "MRPythonAsync.h"
 #include "MRMesh/MRMesh.h"
 #include "MRMesh/MRMeshDecimate.h"
 
@@ -19,5 +20,19 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, Decimate, [] ( pybind11::module_& m )
         def_readwrite( "facesDeleted", &MR::DecimateResult::facesDeleted ).
         def_readwrite( "errorIntroduced", &MR::DecimateResult::errorIntroduced );
 
-    m.def( "decimate", MR::decimateMesh, "simplifies mesh by collapsing edges" );
+    m.def( "decimate", MR::decimateMesh, "simplifies mesh by collapsing edges", pybind11::call_guard<pybind11::gil_scoped_release>() );
+
+    m.def( "decimate_async", [] ( const MR::Mesh& mesh, const MR::DecimateSettings& settings, pybind11::object progressCb )
+    {
+        // the copies of the mesh and its region are decimated, since python objects can change while the job runs
+        auto region = settings.region ? std::make_shared<MR::FaceBitSet>( *settings.region ) : nullptr;
+        return MR::runPythonAsync( [mesh = mesh, settings = settings, region] ( const MR::ProgressCallback& cb ) mutable
+        {
+            settings.region = region.get();
+            settings.progressCallback = cb;
+            auto res = MR::decimateMesh( mesh, settings );
+            return std::make_pair( std::move( mesh ), res );
+        }, std::move( progressCb ) );
+    }, pybind11::arg( "mesh" ), pybind11::arg( "settings" ) = MR::DecimateSettings{}, pybind11::arg( "progress_cb" ) = pybind11::none(),
+        "simplifies the copy of the mesh in background thread, returns AsyncJob with the result (decimated mesh, DecimateResult)" );
 } )
@@ -215,12 +215,14 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, FillHole, [] ( pybind11::module_& m )
         def( pybind11::init<>() ).
         def_readwrite( "multipleEdgesResolveMode", &MR::FillHoleParams::multipleEdgesResolveMode ).
         def_readwrite( "makeDegenerateBand", &MR::FillHoleParams::makeDegenerateBand ).
+        def_readwrite( "maxHoleEdgesForOptimalFill", &MR::FillHoleParams::maxHoleEdgesForOptimalFill ).
         def_readwrite( "outNewFaces", &MR::FillHoleParams::outNewFaces );
 
     m.def( "set_fill_hole_metric_plane", pythonSetFillHolePlaneMetric, "set plane metric to fill hole parameters" );
     m.def( "set_fill_hole_metric_edge_length", pythonSetFillHoleEdgeLengthMetric, "set edge length metric to fill hole parameters" );
     m.def( "set_fill_hole_metric_circumscribed", pythonSetFillHoleCircumscribedMetric, "set circumscribed metric to fill hole parameters" );
     m.def( "fill_hole", MR::fillHole, "fills hole represented by edge" );
+    m.def( "fill_holes", MR::fillHoles, "fills many holes represented by edges, triangulations of independent holes are computed in parallel" );
 } )
 
 std::vector<Vector3f> pythonComputePerVertNormals( const Mesh& mesh )
@@ -1,5 +1,7 @@
 #include "MRMesh/MRPython.h"
 #include "MRMesh/MRICP.h"
+#include "MRMesh/MRMultiwayICP.h"
+#include "MRMesh/MRPointCloud.h"
 
 
 namespace MR
@@ -18,6 +20,20 @@ bool operator == ( const VertPair& a, const VertPair& b )
 }
 }
 
+std::vector<MR::AffineXf3f> pythonMultiwayICP( const std::vector<MR::Mesh>& meshes, const std::vector<MR::AffineXf3f>& xfs,
+    const MR::MultiwayICPParams& params )
+{
+    if ( xfs.size() != meshes.size() )
+        throw std::runtime_error( "The number of transformations differs from the number of meshes" );
+    std::vector<MR::MeshOrPoints> objs( meshes.begin(), meshes.end() );
+    // registration runs on all cores and does not touch python objects
+    pybind11::gil_scoped_release release;
+    auto res = MR::multiwayICP( objs, xfs, params );
+    if ( !res.has_value() )
+        throw std::runtime_error( res.error() );
+    return std::move( *res );
+}
+
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, ICPExposing, [] ( pybind11::module_& m )
 {
     pybind11::enum_<MR::ICPMethod>( m, "ICPMethod" ).
@@ -51,6 +67,7 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, ICPExposing, [] ( pybind11::module_& m )
         def_readwrite( "icpMode", &MR::ICPProperties::icpMode ).
         def_readwrite( "fixedRotationAxis", &MR::ICPProperties::fixedRotationAxis ).
         def_readwrite( "freezePairs", &MR::ICPProperties::freezePairs ).
+        def_readwrite( "multiresLevels", &MR::ICPProperties::multiresLevels ).
         def_readwrite( "iterLimit", &MR::ICPProperties::iterLimit ).
         def_readwrite( "badIterStopCount", &MR::ICPProperties::badIterStopCount ).
         def_readwrite( "exitVal", &MR::ICPProperties::exitVal );
@@ -58,6 +75,8 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, ICPExposing, [] ( pybind11::module_& m )
     pybind11::class_<MR::MeshICP>( m, "MeshICP" ).
         def( pybind11::init<const MR::Mesh&, const MR::Mesh&, const MR::AffineXf3f&, const MR::AffineXf3f&, const MR::VertBitSet&>() ).
         def( pybind11::init<const MR::Mesh&, const MR::Mesh&, const MR::AffineXf3f&, const MR::AffineXf3f&, float>() ).
+        def( pybind11::init<const MR::PointCloud&, const MR::Mesh&, const MR::AffineXf3f&, const MR::AffineXf3f&, float>() ).
+        def( pybind11::init<const MR::PointCloud&, const MR::PointCloud&, const MR::AffineXf3f&, const MR::AffineXf3f&, float>() ).
         def( "setParams", &MR::MeshICP::setParams ).
         def( "setCosineLimit", &MR::MeshICP::setCosineLimit ).
         def( "setDistanceLimit", &MR::MeshICP::setDistanceLimit ).
@@ -72,8 +91,23 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, ICPExposing, [] ( pybind11::module_& m )
         def( "getMeanSqDistToPlane", &MR::MeshICP::getMeanSqDistToPlane ).
         def( "getVertPairs", &MR::MeshICP::getVertPairs, pybind11::return_value_policy::copy ).
         def( "getDistLimitsSq", &MR::MeshICP::getDistLimitsSq ).
-        def( "calculateTransformation", &MR::MeshICP::calculateTransformation ).
-        def( "updateVertPairs", &MR::MeshICP::updateVertPairs );
+        def( "calculateTransformation", &MR::MeshICP::calculateTransformation, pybind11::call_guard<pybind11::gil_scoped_release>() ).
+        def( "updateVertPairs", &MR::MeshICP::updateVertPairs, pybind11::call_guard<pybind11::gil_scoped_release>() );
+
+    pybind11::class_<MR::MultiwayICPParams>( m, "MultiwayICPParams" ).
+        def( pybind11::init<>() ).
+        def_readwrite( "icpProps", &MR::MultiwayICPParams::icpProps ).
+        def_readwrite( "samplingVoxelSize", &MR::MultiwayICPParams::samplingVoxelSize ).
+        def_readwrite( "maxBoxDistance", &MR::MultiwayICPParams::maxBoxDistance ).
+        def_readwrite( "minOverlapRatio", &MR::MultiwayICPParams::minOverlapRatio ).
+        def_readwrite( "globalIterLimit", &MR::MultiwayICPParams::globalIterLimit ).
+        def_readwrite( "anchorObject", &MR::MultiwayICPParams::anchorObject );
+
+    m.def( "multiwayICP", &pythonMultiwayICP, pybind11::arg( "meshes" ), pybind11::arg( "xfs" ), pybind11::arg( "params" ),
+        "registers all overlapping meshes simultaneously: pairwise ICP runs in parallel for all pairs with close bounding boxes, "
+        "then all transformations are found at once by global optimization; returns new world transformations of meshes" );
 } )
 
 MR_ADD_PYTHON_VEC( mrmeshpy, vectorICPVertPair, MR::VertPair )
+
+MR_ADD_PYTHON_VEC( mrmeshpy, vectorAffineXf3f, MR::AffineXf3f )
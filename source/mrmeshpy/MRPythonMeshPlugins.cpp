@@ -24,6 +24,8 @@
 #include "MRMesh/MRFaceFace.h"
 #include "MRMesh/MRLaplacian.h"
 #include "MRMesh/MRMeshFixer.h"
+#include "MRMesh/MROffset.h"
+#include "MRPythonAsync.h"
 #include <tl/expected.hpp>
 
 using namespace MR;
@@ -36,7 +38,7 @@ void fixSelfIntersections( Mesh& mesh1, float voxelSize )
     auto gridA = convert(mesh1);
     mesh1 = convert(gridA);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, fix_self_intersections, &fixSelfIntersections, "subtract second mesh from the first one" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, fix_self_intersections, &fixSelfIntersections, "subtract second mesh from the first one" )
 
 // Boolean
 void booleanSub( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
@@ -48,7 +50,7 @@ void booleanSub( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
     gridA -= gridB;
     mesh1 = convert(gridA);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, boolean_sub, &booleanSub, "subtract second mesh from the first one" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, boolean_sub, &booleanSub, "subtract second mesh from the first one" )
 
 void booleanUnion( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
 {
@@ -59,7 +61,7 @@ void booleanUnion( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
     gridA += gridB;
     mesh1 = convert(gridA);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, boolean_union, &booleanUnion, "merge second mesh into the first one" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, boolean_union, &booleanUnion, "merge second mesh into the first one" )
 
 void booleanIntersect( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
 {
@@ -70,7 +72,43 @@ void booleanIntersect( Mesh& mesh1, const Mesh& mesh2, float voxelSize )
     gridA *= gridB;
     mesh1 = convert(gridA);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, boolean_intersect, &booleanIntersect, "stores intersection of two meshes into the first one" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, boolean_intersect, &booleanIntersect, "stores intersection of two meshes into the first one" )
+
+// Offset
+Mesh offsetMeshSimple( const Mesh& mesh, float offset, const OffsetParameters& params )
+{
+    auto res = offsetMesh( mesh, offset, params );
+    if ( !res.has_value() )
+        throw std::runtime_error( res.error() );
+    return std::move( *res );
+}
+
+MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, OffsetParameters, [] ( pybind11::module_& m )
+{
+    pybind11::enum_<OffsetParameters::Type>( m, "OffsetType" ).
+        value( "Offset", OffsetParameters::Type::Offset ).
+        value( "Shell", OffsetParameters::Type::Shell );
+
+    pybind11::class_<OffsetParameters>( m, "OffsetParameters" ).
+        def( pybind11::init<>() ).
+        def_readwrite( "voxelSize", &OffsetParameters::voxelSize ).
+        def_readwrite( "adaptivity", &OffsetParameters::adaptivity ).
+        def_readwrite( "type", &OffsetParameters::type );
+
+    m.def( "offset_mesh", &offsetMeshSimple,
+        pybind11::arg( "mesh" ), pybind11::arg( "offset" ), pybind11::arg( "params" ) = OffsetParameters{},
+        "offsets mesh by converting it to voxels and back", pybind11::call_guard<pybind11::gil_scoped_release>() );
+
+    m.def( "offset_mesh_async", [] ( const Mesh& mesh, float offset, const OffsetParameters& params, pybind11::object progressCb )
+    {
+        return runPythonAsync( [mesh, offset, params = params] ( const ProgressCallback& cb ) mutable
+        {
+            params.callBack = cb;
+            return offsetMeshSimple( mesh, offset, params );
+        }, std::move( progressCb ) );
+    }, pybind11::arg( "mesh" ), pybind11::arg( "offset" ), pybind11::arg( "params" ) = OffsetParameters{}, pybind11::arg( "progress_cb" ) = pybind11::none(),
+        "offsets the copy of the mesh in background thread, returns AsyncJob with the result mesh" );
+} )
 
 // Stitch two Holes
 void pythonSetStitchHolesEdgeLengthMetric( MR::StitchHolesParams& params, const Mesh& mesh )
@@ -96,11 +134,11 @@ MR_ADD_PYTHON_FUNCTION( mrmeshpy, stitch_two_holes,
     "stitches holes on the mesh with exact two holes" )
 
 // Fix Tunnels
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, get_tunnel_faces, &MR::detectTunnelFaces,
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, get_tunnel_faces, &MR::detectTunnelFaces,
     "returns tunnel faces. Remove them and stitch new holes to fill tunnels. Tunnel length is the treshold for big holes" )
 
 // Homology Basis
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, detect_basis_tunnels, &MR::detectBasisTunnels, "finds homology basis as the set of edge loops" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, detect_basis_tunnels, &MR::detectBasisTunnels, "finds homology basis as the set of edge loops" )
 
 // Text Mesh
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, SymbolMeshParams, [] ( pybind11::module_& m )
@@ -113,7 +151,7 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, SymbolMeshParams, [] ( pybind11::module_& m
         def_readwrite( "pathToFontFile", &TextMeshAlignParams::pathToFontFile );
 } )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, create_text_mesh, &createSymbolsMesh, "create text mesh. Use empty path for default" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, create_text_mesh, &createSymbolsMesh, "create text mesh. Use empty path for default" )
 
 // Text on Mesh
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, TextAlignParams, [] ( pybind11::module_& m )
@@ -148,17 +186,17 @@ Mesh createTextOnMesh( Mesh& mesh, const AffineXf3f& xf, TextMeshAlignParams par
         return {};
 }
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, create_text_on_mesh, &createTextOnMesh, "create text on mesh" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, create_text_on_mesh, &createTextOnMesh, "create text on mesh" )
 
 // Laplacian Brush
 // nothing to add or test
 
 // Fix Undercuts
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, fix_undercuts_on_area,
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, fix_undercuts_on_area,
     static_cast<void ( * )(Mesh&, const FaceBitSet&, const Vector3f&, float, float)> (&MR::FixUndercuts::fixUndercuts),
     "fill all undercuts in direction for fixed area" )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, fix_undercuts,
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, fix_undercuts,
     static_cast<void ( * )(Mesh&, const Vector3f&, float, float)> (&MR::FixUndercuts::fixUndercuts),
     "fill all undercuts in direction" )
 
@@ -181,7 +219,7 @@ std::vector<FaceFace> findCollidingTrianglesSimple( const Mesh& a, const Mesh& b
 {
     return findCollidingTriangles(a, b, rigidB2A, firstIntersectionOnly);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, find_colliding_faces, &findCollidingTrianglesSimple, "finds all colliding face pairs" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, find_colliding_faces, &findCollidingTrianglesSimple, "finds all colliding face pairs" )
 
 // Signed Distance
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, MeshSignedDistanceResult, [] ( pybind11::module_& m )
@@ -197,10 +235,10 @@ MeshSignedDistanceResult findSignedDistanceSimple( const Mesh& a, const Mesh& b,
 {
     return findSignedDistance( a, b, &rigidB2A, std::numeric_limits<float>::max() );
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, find_signed_distance, &findSignedDistanceSimple, "finds signed distance for the current mesh. Negative value is for inner points" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, find_signed_distance, &findSignedDistanceSimple, "finds signed distance for the current mesh. Negative value is for inner points" )
 
 // Fix Spikes
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, remove_spikes, &removeSpikes, "removes spikes for the current mesh with given iterations" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, remove_spikes, &removeSpikes, "removes spikes for the current mesh with given iterations" )
 
 // Surface Distance
 // nothing to add or test
@@ -208,7 +246,7 @@ MR_ADD_PYTHON_FUNCTION( mrmeshpy, remove_spikes, &removeSpikes, "removes spikes
 // Geodesic Path
 MR_ADD_PYTHON_VEC( mrmeshpy, vectorMeshEdgePoint, MR::MeshEdgePoint )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, compute_surface_path, &computeSurfacePath, "finds closest surface path between points" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, compute_surface_path, &computeSurfacePath, "finds closest surface path between points" )
 
 // Relax Mesh
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, Relax, [] ( pybind11::module_& m )
@@ -228,11 +266,11 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, Relax, [] ( pybind11::module_& m )
         return relax( mesh, params );
     },
         pybind11::arg( "mesh" ), pybind11::arg( "params" ) = MeshRelaxParams{},
-        "Relax mesh" );
+        "Relax mesh", pybind11::call_guard<pybind11::gil_scoped_release>() );
 } )
 
 // Re-mesh
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, make_delone_edge_flips, &makeDeloneEdgeFlips, "Delone flips edges" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, make_delone_edge_flips, &makeDeloneEdgeFlips, "Delone flips edges" )
 
 // Subdivider Plugin
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, SubdivideSettings, [] ( pybind11::module_& m )
@@ -245,7 +283,7 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, SubdivideSettings, [] ( pybind11::module_& m
 } )
 
 // TODO: introduce MeshPart
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, subdivide_mesh, &subdivideMesh, "split edges in mesh with settings" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, subdivide_mesh, &subdivideMesh, "split edges in mesh with settings" )
 
 static void deleteFaces( MeshTopology& topology, const FaceBitSet& fs )
 {
@@ -302,11 +340,11 @@ MR::DistanceMap computeDMwithParams( const Mesh& mesh, const MeshToDistanceMapPa
     return computeDistanceMapD( mesh, params );
 }
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, compute_distance_map,
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, compute_distance_map,
     &computeDMwithParams,
     "computes Distance Map with given xf transformation, pixel size. Precise bounding box computation as the last parameter" )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, get_distance_map_mesh, &distanceMapToMesh,
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, get_distance_map_mesh, &distanceMapToMesh,
     "converts distance map to mesh" )
 
 // TODO: introduce filesystem::path
@@ -314,7 +352,7 @@ void saveDistanceMapToImageSimple(const DistanceMap& dm, const std::string& file
 {
     saveDistanceMapToImage(dm, filename);
 }
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, save_depth_image, &saveDistanceMapToImageSimple, "saves distance map to image file" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, save_depth_image, &saveDistanceMapToImageSimple, "saves distance map to image file" )
 
 // Position Verts Smooth
 MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, LaplacianEdgeWeightsParam, [] ( pybind11::module_& m )
@@ -324,9 +362,9 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, LaplacianEdgeWeightsParam, [] ( pybind11::mo
         value( "Cotan", Laplacian::EdgeWeights::Cotan );
 } )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, position_verts_smoothly, &positionVertsSmoothly, "shifts vertices to make smooth surface by Unit Laplacian" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, position_verts_smoothly, &positionVertsSmoothly, "shifts vertices to make smooth surface by Unit Laplacian" )
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, findMaxMeshDistanceSqOneWay, &findMaxDistanceSqOneWay, "returns the maximum of the distances from each B-mesh point to A-mesh" )
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, findMaxMeshDistanceSq, &findMaxDistanceSq, "returns the maximum of the distances from each mesh point to another mesh in both directions" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, findMaxMeshDistanceSqOneWay, &findMaxDistanceSqOneWay, "returns the maximum of the distances from each B-mesh point to A-mesh" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, findMaxMeshDistanceSq, &findMaxDistanceSq, "returns the maximum of the distances from each mesh point to another mesh in both directions" )
 
 MR_ADD_PYTHON_FUNCTION( mrmeshpy, findDegenerateFaces, &findDegenerateFaces, "finds faces which aspect ratio >= criticalAspectRatio" )
@@ -2,4 +2,4 @@
 #include "MRMesh/MRMeshToPointCloud.h"
 #include "MRMesh/MRMesh.h"
 
-MR_ADD_PYTHON_FUNCTION( mrmeshpy, mesh_to_points, &MR::meshToPointCloud, "bool saveNormals: calculate from triangles and save normal for each point" )
+MR_ADD_PYTHON_FUNCTION_NOGIL( mrmeshpy, mesh_to_points, &MR::meshToPointCloud, "bool saveNormals: calculate from triangles and save normal for each point" )
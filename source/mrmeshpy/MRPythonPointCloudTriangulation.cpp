@@ -1,4 +1,5 @@
 #include "MRMesh/MRPython.h"
+#include "MRPythonAsync.h"
 #include "MRMesh/MRPointCloud.h"
 #include "MRMesh/MRPointCloudTriangulation.h"
 #include <pybind11/stl.h>
@@ -16,5 +17,15 @@ MR_ADD_PYTHON_CUSTOM_DEF( mrmeshpy, TriangulationParameters, []( pybind11::modul
         return MR::triangulatePointCloud( pointCloud, params );
     },
         pybind11::arg( "pointCloud" ), pybind11::arg( "params" ) = MR::TriangulationParameters{},
-        "Creates mesh from given point cloud" );
+        "Creates mesh from given point cloud", pybind11::call_guard<pybind11::gil_scoped_release>() );
+
+    m.def( "triangulate_point_cloud_async", [] ( const MR::PointCloud& pointCloud, const MR::TriangulationParameters& params, pybind11::object progressCb )
+    {
+        return MR::runPythonAsync( [pointCloud, params] ( const MR::ProgressCallback& cb )
+        {
+            return MR::triangulatePointCloud( pointCloud, params, cb );
+        }, std::move( progressCb ) );
+    },
+        pybind11::arg( "pointCloud" ), pybind11::arg( "params" ) = MR::TriangulationParameters{}, pybind11::arg( "progress_cb" ) = pybind11::none(),
+        "Creates mesh from the copy of given point cloud in background thread, returns AsyncJob with the mesh or None if canceled" );
 } )
@@ -0,0 +1,120 @@
+from helper import *
+import pytest
+import asyncio
+import concurrent.futures
+
+
+def make_decimate_settings():
+    settings = mrmesh.DecimateSettings()
+    settings.maxError = 0.05
+    return settings
+
+def make_offset_params():
+    params = mrmesh.OffsetParameters()
+    params.voxelSize = 0.05
+    return params
+
+
+def test_decimate_async():
+    torus = mrmesh.make_torus(2,1,64,64,None)
+    numFaces = torus.topology.getValidFaces().count()
+
+    reported = []
+    job = mrmesh.decimate_async(torus, make_decimate_settings(), lambda p: reported.append(p))
+    mesh, res = job.result()
+
+    assert(job.done())
+    assert(not job.cancelled())
+    assert(job.progress > 0)
+    assert(len(reported) > 0)
+    assert(res.facesDeleted > 0)
+    assert(mesh.topology.getValidFaces().count() == numFaces - res.facesDeleted)
+    # the job works on the copy of the mesh
+    assert(torus.topology.getValidFaces().count() == numFaces)
+
+    # asyncio awaits the job directly
+    async def decimate():
+        return await mrmesh.decimate_async(torus, make_decimate_settings())
+    mesh2, res2 = asyncio.run(decimate())
+    assert(res2.facesDeleted == res.facesDeleted)
+
+
+def test_offset_mesh_async():
+    torus = mrmesh.make_torus(2,1,32,32,None)
+    box = torus.computeBoundingBox(torus.topology.getValidFaces(), mrmesh.AffineXf3())
+
+    job = mrmesh.offset_mesh_async(torus, 0.2, make_offset_params())
+    mesh = job.result()
+    offBox = mesh.computeBoundingBox(mesh.topology.getValidFaces(), mrmesh.AffineXf3())
+
+    assert(mesh.topology.getValidFaces().count() > 0)
+    assert(abs(offBox.max.x - box.max.x - 0.2) < 0.1)
+    assert(abs(offBox.min.z - box.min.z + 0.2) < 0.1)
+
+
+def test_async_cancel():
+    torus = mrmesh.make_torus(2,1,128,128,None)
+
+    # the future is never marked as running, so it can be cancelled at any moment before completion
+    job = mrmesh.decimate_async(torus, make_decimate_settings())
+    assert(job.future.cancel())
+    assert(job.cancelled())
+    with pytest.raises(concurrent.futures.CancelledError):
+        job.result()
+
+    job = mrmesh.offset_mesh_async(torus, 0.2, make_offset_params())
+    assert(job.cancel())
+    with pytest.raises(concurrent.futures.CancelledError):
+        job.result()
+
+
+def test_async_progress_false():
+    torus = mrmesh.make_torus(2,1,64,64,None)
+
+    calls = []
+    def stop(p):
+        calls.append(p)
+        return False
+    job = mrmesh.decimate_async(torus, make_decimate_settings(), stop)
+    with pytest.raises(concurrent.futures.CancelledError):
+        job.result()
+    assert(job.cancelled())
+    # the operation stops on the first report
+    assert(len(calls) == 1)
+
+    # returning None continues the operation
+    job = mrmesh.offset_mesh_async(torus, 0.2, make_offset_params(), lambda p: None)
+    assert(job.result().topology.getValidFaces().count() > 0)
+
+
+def test_async_progress_raises():
+    torus = mrmesh.make_torus(2,1,64,64,None)
+
+    def fail(p):
+        raise ValueError("progress failure")
+    job = mrmesh.decimate_async(torus, make_decimate_settings(), fail)
+    with pytest.raises(RuntimeError, match="progress failure"):
+        job.result()
+    assert(not job.cancelled())
+
+    job = mrmesh.offset_mesh_async(torus, 0.2, make_offset_params(), fail)
+    with pytest.raises(RuntimeError, match="progress failure"):
+        job.result()
+
+
+def test_nogil_thread_pool():
+    meshes = [mrmesh.make_torus(2,1,64,64,None) for i in range(4)]
+    numFaces = meshes[0].topology.getValidFaces().count()
+
+    # the functions release GIL, so the meshes are processed in parallel threads
+    with concurrent.futures.ThreadPoolExecutor(max_workers=4) as pool:
+        results = list(pool.map(lambda m: mrmesh.decimate(m, make_decimate_settings()), meshes))
+        offsets = list(pool.map(lambda m: mrmesh.offset_mesh(m, 0.2, make_offset_params()), meshes))
+
+    serialMesh = mrmesh.make_torus(2,1,64,64,None)
+    serialRes = mrmesh.decimate(serialMesh, make_decimate_settings())
+    for mesh, res in zip(meshes, results):
+        assert(res.facesDeleted == serialRes.facesDeleted)
+        assert(mesh.topology.getValidFaces().count() == numFaces - res.facesDeleted)
+    for mesh in offsets:
+        assert(mesh.topology.getValidFaces().count() > 0)
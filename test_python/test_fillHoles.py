@@ -0,0 +1,16 @@
+from helper import *
+import pytest
+
+def test_fill_holes():
+    torus = mrmesh.make_outer_half_test_torus(2, 1, 10, 10, None)
+
+    holes = torus.topology.findHoleRepresentiveEdges()
+    assert(len(holes)==2)
+
+    params = mrmesh.FillHoleParams()
+    mrmesh.set_fill_hole_metric_circumscribed(params, torus)
+    params.maxHoleEdgesForOptimalFill = 4
+    mrmesh.fill_holes(torus, holes, params)
+
+    holes = torus.topology.findHoleRepresentiveEdges()
+    assert(len(holes)==0)
@@ -36,4 +36,28 @@ def test_icp():
 
     assert(abs(diffXf.b.x)<1e-6 )
     assert(abs(diffXf.b.y)<1e-6 )
-    assert(abs(diffXf.b.z)<1e-6 )
\ No newline at end of file
+    assert(abs(diffXf.b.z)<1e-6 )
+
+def test_multiway_icp():
+    meshes = mrmesh.vectorMesh()
+    xfs = mrmesh.vectorAffineXf3f()
+    for i in range(3):
+        meshes.append(mrmesh.make_torus(2,1,32,32,None))
+        trans = mrmesh.Vector3()
+        trans.y = 0.05 * i
+        trans.z = -0.03 * i
+        xfs.append(mrmesh.AffineXf3.translation(trans))
+
+    params = mrmesh.MultiwayICPParams()
+    params.samplingVoxelSize = 0.1
+    newXfs = mrmesh.multiwayICP(meshes, xfs, params)
+
+    assert(newXfs.size() == 3)
+    for xf in newXfs:
+        assert(abs(xf.b.y) < 1e-3)
+        assert(abs(xf.b.z) < 1e-3)
+
+    # errors are raised as exceptions instead of returning empty list
+    xfs.resize(2)
+    with pytest.raises(RuntimeError, match="number of transformations"):
+        mrmesh.multiwayICP(meshes, xfs, params)